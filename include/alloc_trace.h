@@ -0,0 +1,48 @@
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Heap Allocation Tracing (debug builds) ---
+// With ALLOC_TRACE=1 and the linker wrapping malloc/calloc/realloc (see the
+// m5stack-core2-alloc-trace environment), every allocation made by the
+// traced task between allocTraceBegin() and allocTraceEnd() is counted.
+// The loop traces each round: the steady-state game path must not touch
+// the heap. Calls into the BLE stack and link management allocate inside
+// the library and run under ALLOC_TRACE_PAUSE().
+#ifndef ALLOC_TRACE
+#define ALLOC_TRACE 0
+#endif
+
+struct AllocTraceReport {
+  uint32_t count;        // allocations while tracing
+  uint32_t bytes;
+  uint32_t firstSize;    // the first offending allocation
+  void* firstCaller;
+};
+
+#if ALLOC_TRACE
+// Starts counting allocations made by the calling task.
+void allocTraceBegin();
+
+// Stops counting; returns false (and fills out) if anything was allocated.
+bool allocTraceEnd(AllocTraceReport* out);
+
+bool allocTraceActive();
+
+void allocTracePause();
+void allocTraceResume();
+
+class AllocTracePauseScope {
+public:
+  AllocTracePauseScope() { allocTracePause(); }
+  ~AllocTracePauseScope() { allocTraceResume(); }
+};
+
+#define ALLOC_TRACE_PAUSE() AllocTracePauseScope allocTracePauseScope
+#else
+#define ALLOC_TRACE_PAUSE() do {} while (0)
+#endif
+
+#endif // ALLOC_TRACE_H
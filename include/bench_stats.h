@@ -0,0 +1,40 @@
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- BLE Benchmark Statistics ---
+// The benchmark role runs BENCH_PINGS timed round trips over the ping
+// characteristic, then asks the shooter for a flood of BENCH_FLOOD_COUNT
+// notifications of BENCH_PAYLOAD_SIZE bytes (the largest that fits the
+// default 23-byte ATT MTU).
+#define BENCH_PINGS 200
+#define BENCH_FLOOD_COUNT 500
+#define BENCH_PAYLOAD_SIZE 20
+
+struct BenchSummary {
+  uint16_t pongs;           // round trips completed
+  uint16_t lost;            // pings that timed out
+  uint32_t rttMinUs;
+  uint32_t rttP50Us;
+  uint32_t rttP99Us;
+  uint32_t floodPackets;    // notifications received
+  uint32_t floodUs;         // first to last notification
+  bool rateMeasured;        // false when fewer than two packets or no time between them
+  uint32_t notifyPerSec;    // 0 unless rateMeasured
+  uint32_t kbps;            // payload kilobits per second, 0 unless rateMeasured
+};
+
+void benchReset();
+void benchAddRtt(uint32_t rttUs);
+void benchAddLoss();
+
+// Called from the BLE callback task for every flood notification.
+void benchFloodPacket(size_t bytes, uint32_t nowUs);
+uint32_t benchFloodPackets();
+
+// Sorts the RTT samples and fills out; call once both phases are done.
+void benchSummarize(BenchSummary* out);
+
+#endif // BENCH_STATS_H
@@ -0,0 +1,11 @@
+#ifndef BLE_SERVICE_H
+#define BLE_SERVICE_H
+
+// --- BLE UUID Definitions ---
+// The shooter's GATT service, shared by the firmware and the simulator's
+// synthetic dodgers.
+#define SERVICE_UUID           "ce062b2f-e42b-4239-b951-f9d4b4abe0ff"
+#define CHARACTERISTIC_UUID    "46f27243-ac2d-4b01-b909-4b5711a23a8d"
+#define PING_CHARACTERISTIC_UUID "9d3a51c4-6e0b-4f7e-8a52-1c7b2e90d3f6"  // benchmark echo/flood
+
+#endif // BLE_SERVICE_H
@@ -0,0 +1,29 @@
+#ifndef CONN_PROFILES_H
+#define CONN_PROFILES_H
+
+#include <stdint.h>
+
+// --- BLE Connection Parameter Profiles ---
+// Requested by the shooter (peripheral) as the match changes phase.
+// Intervals are in 1.25 ms units, supervision timeout in 10 ms units.
+enum ConnProfileId {
+  PROFILE_NONE = -1,
+  PROFILE_LOW_LATENCY,   // active rounds: shortest interval, no slave latency
+  PROFILE_POWER_SAVE,    // game-over screen: long interval, slave latency
+  PROFILE_COUNT
+};
+
+struct ConnProfile {
+  const char* name;
+  uint16_t minInterval;
+  uint16_t maxInterval;
+  uint16_t latency;
+  uint16_t timeout;
+};
+
+const ConnProfile connProfiles[PROFILE_COUNT] = {
+  { "low-latency", 0x06, 0x06, 0, 200 },  // 7.5 ms, 2 s timeout
+  { "power-save",  0x50, 0x64, 4, 600 },  // 100-125 ms, 6 s timeout
+};
+
+#endif // CONN_PROFILES_H
@@ -0,0 +1,25 @@
+#ifndef DEADLINE_TIMER_H
+#define DEADLINE_TIMER_H
+
+#include <stdint.h>
+
+// --- Deadline Scheduler ---
+// A handful of one-shot timers identified by small integer ids. Nothing here
+// reads the clock: callers pass the current time in milliseconds, so the
+// loop uses millis() and a host build can drive it from a virtual clock.
+// Deadlines are compared with wrap-safe signed differences.
+#define TIMER_SLOTS 8
+#define TIMER_NONE UINT32_MAX
+
+// Arm (or re-arm) timer id to expire delayMs after nowMs.
+void timerStart(uint8_t id, uint32_t delayMs, uint32_t nowMs);
+void timerCancel(uint8_t id);
+bool timerActive(uint8_t id);
+
+// Disarm and return the id of one expired timer, or -1 if none is due.
+int timerPopExpired(uint32_t nowMs);
+
+// Milliseconds until the earliest deadline (0 if overdue), TIMER_NONE if idle.
+uint32_t timerTimeUntilNext(uint32_t nowMs);
+
+#endif // DEADLINE_TIMER_H
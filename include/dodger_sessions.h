@@ -0,0 +1,101 @@
+#ifndef DODGER_SESSIONS_H
+#define DODGER_SESSIONS_H
+
+#include <stdint.h>
+#include "transport.h"
+
+// --- Dodger Sessions (shooter) ---
+// One game session per dodger the shooter serves, each with its own round,
+// choice and state. The shooter fires one shot per turn at every dodger
+// that has chosen; a dodger that is hit, or survives MAX_ROUNDS, is out,
+// and the match is over once no linked dodger is left playing. A dodger
+// that is away then is out too, so it never holds up the others.
+//
+// The table is a structure of arrays: the loop scans one field across all
+// sessions at a time (every state, every choice), so each scan walks one
+// short contiguous array. Live sessions are packed at the front.
+//
+// Sessions are keyed by the dodger's address, so a dodger that drops and
+// reconnects resumes its own session. Links that carry a single peer
+// (ESP-NOW, adverts, host links) use one session with a zero address on
+// peer 0.
+//
+// Bluedroid's default controller configuration allows 3 simultaneous
+// connections (CONFIG_BTDM_CTRL_BLE_MAX_CONN); raise both together.
+#ifndef MAX_DODGERS
+#define MAX_DODGERS 3
+#endif
+
+#define SESSION_ADDRESS_LEN 6
+
+enum SessionState {
+  SESSION_LINKED,       // connected, no game frame yet (a bench client stays here)
+  SESSION_WAIT_CHOICE,  // playing round, no choice yet
+  SESSION_CHOSEN,       // choice is in for round
+  SESSION_SHOT,         // shot fired at round, result showing
+  SESSION_OUT,          // hit, or survived the last round
+};
+
+struct SessionTable {
+  uint8_t count;                                    // live sessions
+  uint8_t survivors;                                // out without being hit, this match
+  uint8_t address[MAX_DODGERS][SESSION_ADDRESS_LEN];
+  TransportPeer peer[MAX_DODGERS];                  // link, while up
+  bool up[MAX_DODGERS];                             // linked now
+  uint8_t round[MAX_DODGERS];
+  // The choice for round while CHOSEN; while SHOT or OUT, an early choice
+  // for the session's next round (0 if none).
+  uint8_t choice[MAX_DODGERS];
+  uint8_t state[MAX_DODGERS];                       // SessionState
+  uint8_t result[MAX_DODGERS];                      // SNAP_* flags of the last shot
+  uint8_t shot[MAX_DODGERS];                        // barrel of the last shot, 0 if none
+  uint8_t shotRound[MAX_DODGERS];                   // round it was fired in
+  int8_t profile[MAX_DODGERS];                      // ConnProfileId requested, or PROFILE_NONE
+};
+
+extern SessionTable sessions;
+
+// A dodger linked on peer: resumes the session with its address, or opens
+// a new one, taking the place of a session whose dodger is gone and out of
+// the match if the table is full. Returns the session, or -1 if there is
+// no such session.
+int sessionLink(const uint8_t* address, TransportPeer peer);
+// The dodger on peer went away; its session waits for it to come back.
+void sessionUnlink(TransportPeer peer);
+// The up session on peer, or -1.
+int sessionFind(TransportPeer peer);
+int sessionsUp();
+
+// A game frame came from session i: it joins the match at round 1.
+void sessionJoin(int i);
+// A choice for round from session i. False if it is stale.
+bool sessionChoose(int i, uint8_t round, uint8_t choice);
+
+// True while the session takes part in the match (joined and not out).
+bool sessionPlaying(int i);
+// Sessions playing, and those of them that have chosen, counting only
+// linked ones.
+int sessionsReady(int* playing);
+// The lowest round a linked session is still playing, or 0 if none is.
+int sessionsLowestRound();
+// The barrel last fired at session i if that was in round, else 0: the
+// shot to repeat to a dodger that missed it.
+int sessionShotFor(int i, uint8_t round);
+
+// Fires shot at every session that has chosen, linked or not. Returns the
+// number hit; shotCount, if given, is set to the number shot at.
+int sessionsShoot(int shot, int* shotCount);
+// The result display is over: sessions that were shot advance a round or
+// go out. Returns sessionsEndIfOver().
+bool sessionsAdvance();
+// True once some session is out and no linked one is left playing; the
+// sessions still playing, whose dodgers are away, are then put out, neither
+// hit nor survivors. While none is out and every dodger playing is away, the
+// match waits for them to come back instead.
+bool sessionsEndIfOver();
+// A new match: every joined session back to round 1, keeping choices the
+// dodgers already made for it, and the last shot for a dodger that has yet
+// to see it.
+void sessionsRestart();
+
+#endif // DODGER_SESSIONS_H
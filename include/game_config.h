@@ -0,0 +1,51 @@
+#ifndef GAME_CONFIG_H
+#define GAME_CONFIG_H
+
+// --- Game Constants ---
+#define MAX_ROUNDS 5
+#define NUM_BARRELS 3
+
+// --- UI Layout Constants (Assuming a 320x240 Screen) ---
+const int screenWidth = 320;
+const int screenHeight = 240;
+
+// Role selection button dimensions
+const int roleButtonY = 80;
+const int roleButtonWidth = screenWidth / 2; // 160
+const int roleButtonHeight = 80;
+
+// Link selection toggle (BLE or ESP-NOW), centred above the role buttons
+const int linkButtonWidth = 240;
+const int linkButtonHeight = 40;
+const int linkButtonX = (screenWidth - linkButtonWidth) / 2;
+const int linkButtonY = 20;
+
+// Benchmark and spectator buttons, side by side below the role buttons
+const int benchButtonWidth = 150;
+const int benchButtonHeight = 40;
+const int benchButtonX = screenWidth / 2 - benchButtonWidth - 5;  // 5
+const int benchButtonY = 180;
+const int spectatorButtonWidth = benchButtonWidth;
+const int spectatorButtonHeight = benchButtonHeight;
+const int spectatorButtonX = screenWidth / 2 + 5;                 // 165
+const int spectatorButtonY = benchButtonY;
+
+// Text rows on the game screen (font 2 at text size 2 is 32 px tall)
+const int roundTextY = 10;
+const int statusTextY = 50;
+const int textRowHeight = 32;
+
+// Debug overlay row (font 2 at text size 1), between status and barrels
+const int overlayTextY = 150;
+const int overlayRowHeight = 16;
+
+// Barrel button dimensions and positions
+const int buttonWidth = 80;
+const int buttonHeight = 50;
+const int buttonSpacing = 20;
+const int buttonY = 180;
+const int button1X = 40;
+const int button2X = button1X + buttonWidth + buttonSpacing;  // 40+80+20 = 140
+const int button3X = button2X + buttonWidth + buttonSpacing;  // 140+80+20 = 240
+
+#endif // GAME_CONFIG_H
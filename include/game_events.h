@@ -0,0 +1,33 @@
+#ifndef GAME_EVENTS_H
+#define GAME_EVENTS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+// --- Main Loop Wake-Up Events ---
+// The loop blocks on an event group; anything that may need the state
+// machine to run (BLE callbacks, the touch interrupt, the loop's own state
+// changes) sets a bit. Timer deadlines need no bit: the loop bounds its wait
+// by the next one (deadline_timer.h) and wakes on the timeout.
+#define EVT_TOUCH          (1 << 0)  // touch controller interrupt
+#define EVT_BLE_RX         (1 << 1)  // data arrived from the peer
+#define EVT_BLE_LINK       (1 << 2)  // connection opened or closed
+#define EVT_STATE_CHANGED  (1 << 4)  // the loop changed state and must run again
+#define EVT_ALL            (EVT_TOUCH | EVT_BLE_RX | EVT_BLE_LINK | EVT_STATE_CHANGED)
+
+// Core2 FT6336U touch controller interrupt line.
+#define TOUCH_INT_PIN 39
+
+void eventsInit();
+void postEvent(EventBits_t bits);
+
+// micros() of the most recent touch interrupt, the start of a player's
+// input for latency measurement.
+uint32_t lastTouchInterruptUs();
+
+// Block until at least one event is posted or timeoutMs passes; returns
+// (and clears) the bits that were set, 0 on timeout.
+EventBits_t waitForEvents(uint32_t timeoutMs);
+
+#endif // GAME_EVENTS_H
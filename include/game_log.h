@@ -0,0 +1,136 @@
+#ifndef GAME_LOG_H
+#define GAME_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// --- Deferred Logging ---
+// LOG_* calls only copy a format pointer and up to LOG_MAX_ARGS integer
+// arguments into a lock-free ring; a low-priority task formats them and
+// writes to Serial. The game loop and the Bluedroid callback task never
+// wait on the UART. When the ring is full the record is dropped and
+// counted.
+//
+// Formats must be string literals and %s arguments must point at static
+// strings (names from tables, not temporary buffers): both are read later,
+// on the drain task. Supported conversions: %d %i %u %x %X %c %s %%, with
+// optional flags and width; arguments are treated as 32-bit integers.
+//
+// With LOG_TOKENIZED the format literals are not linked at all: each
+// LOG_* call carries a compile-time FNV-1a hash of its format, and the
+// drain task writes compact binary frames (see below) instead of text.
+// tools/log_tokens.py builds the token database from the sources and
+// tools/detokenize.py turns a captured serial stream back into text.
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// Messages above LOG_LEVEL are removed at compile time.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_MAX_ARGS 8
+#define LOG_RING_SIZE 64           // records; must be a power of two
+#define LOG_DRAIN_PERIOD_MS 20     // drain task sleep when the ring is empty
+
+#ifndef LOG_TOKENIZED
+#define LOG_TOKENIZED 0
+#endif
+
+// Tokenized serial frame:
+//   LOG_FRAME_SYNC, payload length, payload..., XOR of the payload bytes
+// payload:
+//   token (u32 LE), level << 4 | argc, varint ms, one field per argument
+// Integer arguments are zigzag varints; %s arguments are a varint length
+// followed by up to LOG_MAX_STRING bytes.
+#define LOG_FRAME_SYNC 0xA5
+#define LOG_MAX_STRING 24
+
+// 32-bit FNV-1a over the format's bytes, evaluated by the compiler.
+constexpr uint32_t logFnv1a(const char* s, uint32_t hash = 2166136261u) {
+  return *s == '\0' ? hash : logFnv1a(s + 1, (uint32_t)((hash ^ (uint8_t)*s) * 16777619u));
+}
+
+#if LOG_TOKENIZED
+typedef uint32_t LogFormat;
+// integral_constant forces the hash to be a constant expression, so the
+// literal itself never reaches the binary.
+#define LOG_FMT(fmt) (std::integral_constant<uint32_t, logFnv1a(fmt)>::value)
+#else
+typedef const char* LogFormat;
+#define LOG_FMT(fmt) (fmt)
+#endif
+
+typedef intptr_t LogArg;
+
+struct LogRecord {
+  uint32_t ms;
+  uint8_t level;
+  uint8_t argc;
+  uint8_t strMask;  // bit i set when args[i] is a string
+  LogFormat fmt;
+  LogArg args[LOG_MAX_ARGS];
+};
+
+// Starts the drain task; call right after Serial.begin().
+void logInit();
+
+// Formats and prints every queued record; returns how many were written.
+// The drain task calls this in a loop.
+int logDrain();
+
+// Records refused because the ring was full.
+uint32_t logDroppedCount();
+
+bool logPush(uint8_t level, LogFormat fmt, const LogArg* args, uint8_t argc, uint8_t strMask);
+
+template <typename T>
+inline LogArg logArg(T value) {
+  return (LogArg)value;
+}
+
+template <typename... Args>
+inline void logWrite(uint8_t level, LogFormat fmt, Args... args) {
+  static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+  const LogArg packed[] = { logArg(args)..., 0 };  // trailing 0 keeps the array non-empty
+  const bool isString[] = { std::is_convertible<Args, const char*>::value..., false };
+  uint8_t strMask = 0;
+  for (size_t i = 0; i < sizeof...(Args); i++) {
+    if (isString[i]) strMask |= (uint8_t)(1u << i);
+  }
+  logPush(level, fmt, packed, sizeof...(Args), strMask);
+}
+
+// Suppressed levels keep their arguments type-checked (and "used") but the
+// dead branch is removed by the compiler.
+#define LOG_DISCARD(level, fmt, ...) do { if (0) logWrite(level, LOG_FMT(fmt), ##__VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(fmt, ...) logWrite(LOG_LEVEL_ERROR, LOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define LOG_E(fmt, ...) LOG_DISCARD(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(fmt, ...) logWrite(LOG_LEVEL_WARN, LOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...) LOG_DISCARD(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(fmt, ...) logWrite(LOG_LEVEL_INFO, LOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...) LOG_DISCARD(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(fmt, ...) logWrite(LOG_LEVEL_DEBUG, LOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...) LOG_DISCARD(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#endif
+
+#endif // GAME_LOG_H
@@ -0,0 +1,109 @@
+#ifndef GAME_PROTOCOL_H
+#define GAME_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Game Wire Protocol ---
+// Every characteristic write and notification carries one fixed-layout
+// frame. Multi-byte fields are little-endian.
+//
+//   offset  size  field
+//   0       1     version (GAME_PROTOCOL_VERSION)
+//   1       1     opcode
+//   2       1     round number
+//   3       1     choice (barrel 1..NUM_BARRELS, 0 when unused)
+//   4       1     flags (opcode specific, 0 when unused)
+//   5       2     sequence number (per sender, wraps)
+//   7       4     sentUs: sender's micros() when handed to the BLE stack
+//   11      2     inputUs: trigger to send, saturating (see below)
+//   13      2     encodeUs: send start to BLE hand-off, saturating
+//
+// The timing fields feed the latency breakdown (latency_stats.h). The
+// trigger for OP_DODGER_CHOICE/OP_SHOT is the player's touch; for OP_PONG
+// it is the arrival of the OP_PING, so inputUs is the responder's turn-
+// around time. Version 1 frames (no timing) are rejected.
+#define GAME_PROTOCOL_VERSION 2
+#define GAME_FRAME_SIZE 15
+
+enum GameOpcode {
+  OP_DODGER_CHOICE = 0x01,  // dodger -> shooter: barrel the dodger hides in
+  OP_SHOT          = 0x02,  // shooter -> dodger: barrel the shooter fired at
+  OP_SYNC_REQUEST  = 0x03,  // dodger -> shooter: (re)connected, send a snapshot
+  OP_SNAPSHOT      = 0x04,  // shooter -> dodger: match state, see SNAP_* flags
+  OP_PING          = 0x05,  // either way: round-trip probe
+  OP_PONG          = 0x06,  // reply to OP_PING, echoing its sequence number
+
+  // Benchmark characteristic only (see bench_stats.h); frames may be padded.
+  OP_BENCH_PING    = 0x10,  // bench -> shooter: timed round trip
+  OP_BENCH_PONG    = 0x11,  // shooter -> bench: echo of OP_BENCH_PING
+  OP_BENCH_FLOOD   = 0x12,  // bench -> shooter: send seq notifications
+  OP_BENCH_DATA    = 0x13,  // shooter -> bench: one flood notification
+};
+
+// OP_DODGER_CHOICE/OP_SHOT: the frame repeats a move the peer may have
+// missed. The dodger repeats its choice until the shot arrives; the shooter
+// answers a repeated choice it has already fired at with the shot again.
+// Repeats carry no touch timing (inputUs 0xFFFF).
+#define MOVE_REPEAT 0x01
+
+// OP_SNAPSHOT: round is the shooter's round and choice the dodger choice it
+// holds for that round (0 if none yet).
+#define SNAP_SHOT_FIRED   0x01  // shooter has fired in this round
+#define SNAP_RESULT_SAFE  0x02  // result of the shot (valid with SNAP_SHOT_FIRED)
+#define SNAP_GAME_OVER    0x04  // match has ended
+
+enum FrameDecodeResult {
+  FRAME_OK,
+  FRAME_TOO_SHORT,
+  FRAME_BAD_VERSION,
+  FRAME_BAD_OPCODE,
+  FRAME_BAD_CHOICE,
+};
+
+struct GameFrame {
+  uint8_t opcode;
+  uint8_t round;
+  uint8_t choice;
+  uint8_t flags;
+  uint16_t seq;
+  uint32_t sentUs;
+  uint16_t inputUs;
+  uint16_t encodeUs;
+  uint32_t rxUs;    // local micros() at reception; not on the wire
+  uint16_t peer;    // TransportPeer it came in on, or goes out on; not on the wire
+};
+
+// Read-only view over a received frame. It points into the caller's buffer
+// and is only valid while that buffer is.
+struct GameFrameView {
+  const uint8_t* bytes;
+
+  uint8_t opcode() const { return bytes[1]; }
+  uint8_t round() const { return bytes[2]; }
+  uint8_t choice() const { return bytes[3]; }
+  uint8_t flags() const { return bytes[4]; }
+  uint16_t seq() const { return (uint16_t)(bytes[5] | (bytes[6] << 8)); }
+  uint32_t sentUs() const {
+    return (uint32_t)bytes[7] | ((uint32_t)bytes[8] << 8) | ((uint32_t)bytes[9] << 16) | ((uint32_t)bytes[10] << 24);
+  }
+  uint16_t inputUs() const { return (uint16_t)(bytes[11] | (bytes[12] << 8)); }
+  uint16_t encodeUs() const { return (uint16_t)(bytes[13] | (bytes[14] << 8)); }
+};
+
+// Write frame into buf; returns GAME_FRAME_SIZE, or 0 if buf is too small.
+size_t gameFrameEncode(const GameFrame& frame, uint8_t* buf, size_t bufLen);
+
+// Overwrite the sentUs and encodeUs fields of an encoded frame, so they can
+// be taken after encoding, right before the BLE call.
+void gameFrameStampSend(uint8_t* buf, uint32_t sentUs, uint16_t encodeUs);
+
+// Microsecond interval clamped to a 16-bit timing field.
+uint16_t gameFrameClampUs(uint32_t us);
+
+// Validate data and, on FRAME_OK, point view at it. No bytes are copied.
+FrameDecodeResult gameFrameDecode(const uint8_t* data, size_t len, GameFrameView* view);
+
+const char* frameDecodeResultName(FrameDecodeResult result);
+
+#endif // GAME_PROTOCOL_H
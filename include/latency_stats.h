@@ -0,0 +1,61 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+
+// --- Cross-Device Latency ---
+// Each peer estimates the offset between its clock and the other's from
+// the RTT probe pings, keeping the exchange with the smallest round trip
+// of each probe. With that offset, a received move can be split into
+// stages measured on both devices:
+//
+//   input   sender: touch interrupt to send start     (from the frame)
+//   encode  sender: send start to BLE hand-off         (from the frame)
+//   radio   BLE hand-off to the receiver's callback    (clock offset applied)
+//   decode  receiver: callback to the loop handling it
+//   render  receiver: the state machine taking the move to the updated
+//           frame being pushed
+//
+// Time a move waits for the receiving state machine (still showing the
+// previous result, say) is game pacing and is not counted. Radio is only
+// as good as the offset estimate, whose error is at most half the probe's
+// best round trip plus the clocks' drift since it.
+#define LATENCY_BUCKETS 9
+
+struct LatencyBreakdown {
+  int32_t inputUs;
+  int32_t encodeUs;
+  int32_t radioUs;
+  int32_t decodeUs;
+  int32_t renderUs;
+  int32_t totalUs;
+};
+
+// --- Clock offset ---
+void clockSyncProbeStart();
+// One ping/pong: local send and receive times plus the pong's sentUs and
+// the peer's turnaround (its inputUs + encodeUs), all in microseconds.
+void clockSyncSample(uint32_t pingSentUs, uint32_t pongRxUs, uint32_t peerSentUs, uint32_t peerTurnaroundUs);
+// Adopts the best sample of the probe, if any; returns true if it did.
+bool clockSyncProbeEnd();
+bool clockSyncValid();
+int32_t clockOffsetUs();       // peer clock minus local clock
+uint32_t clockErrorUs();       // bound on the offset error
+
+// --- Breakdown and histogram ---
+// Builds the breakdown of one received move; false if the clock offset is
+// not known yet.
+bool latencyMeasure(uint32_t sentUs, uint16_t inputUs, uint16_t encodeUs,
+                    uint32_t rxUs, uint32_t handledUs,
+                    uint32_t appliedUs, uint32_t renderedUs,
+                    LatencyBreakdown* out);
+void latencyRecord(const LatencyBreakdown& sample);
+void latencyReset();
+uint32_t latencyCount();
+// Mean of every stage over the recorded moves.
+void latencyAverage(LatencyBreakdown* out);
+
+// Console output: histogram of the totals and per-stage means.
+void latencyPrint(const char* direction);
+
+#endif // LATENCY_STATS_H
@@ -0,0 +1,58 @@
+#ifndef MEM_MONITOR_H
+#define MEM_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Heap and Stack Monitor ---
+// A low-priority task samples the internal heap (free, largest free block,
+// all-time minimum), free PSRAM and the stack high-water marks of the
+// loop, Bluedroid and log tasks every MEM_SAMPLE_PERIOD_MS. Samples go
+// into a fixed history ring that the console and the debug overlay read.
+// A falling largest block with steady free heap means fragmentation.
+#define MEM_SAMPLE_PERIOD_MS 30000
+#define MEM_HISTORY 128            // ~64 minutes at the default period
+#define MEM_HEAP_UNIT 16           // heap fields are stored in 16-byte units
+#define MEM_STACK_UNKNOWN 0xFFFF   // task not (yet) running
+
+enum MemTask {
+  MEM_TASK_LOOP,
+  MEM_TASK_BTC,                    // Bluedroid callbacks (GATT events)
+  MEM_TASK_BTU,                    // Bluedroid stack
+  MEM_TASK_LOG,
+  MEM_TASK_COUNT
+};
+
+// 20 bytes per sample.
+struct MemSample {
+  uint32_t ms;
+  uint16_t heapFree;               // MEM_HEAP_UNIT
+  uint16_t heapLargest;            // MEM_HEAP_UNIT
+  uint16_t heapMinFree;            // MEM_HEAP_UNIT, lowest since boot
+  uint16_t psramFreeKb;
+  uint16_t stackFree[MEM_TASK_COUNT];  // bytes never used, MEM_STACK_UNKNOWN if absent
+};
+
+// Call from setup(): the calling task is recorded as the loop task.
+void memMonitorInit();
+
+// Takes one sample now; the monitor task calls this every period.
+void memMonitorSample(uint32_t nowMs);
+
+// Copies the newest sample; false before the first one.
+bool memMonitorLatest(MemSample* out);
+
+// Copies up to max samples, oldest first; returns how many.
+int memMonitorHistory(MemSample* out, int max);
+
+// Total samples taken (also a change counter for readers).
+uint32_t memMonitorSampleCount();
+
+const char* memTaskName(int task);
+
+// Console output: the newest sample with the lows over the history, or
+// the whole history as a table.
+void memMonitorPrintLatest();
+void memMonitorPrintHistory();
+
+#endif // MEM_MONITOR_H
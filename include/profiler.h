@@ -0,0 +1,73 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// --- Scoped Cycle Profiler ---
+// PROFILE_SCOPE("name") times the rest of the enclosing block with the
+// CPU cycle counter and folds the result into a fixed table entry for that
+// name: count, total, min and max. Times are inclusive of nested scopes.
+// Each scope should be entered from one task only; entries are updated
+// without locking. "prof" on the serial console prints the table,
+// "prof reset" clears it. With PROFILER=0 the macro expands to nothing.
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#define PROFILE_SLOTS 24
+
+#if PROFILER
+#if defined(__XTENSA__)
+#include <xtensa/hal.h>
+static inline uint32_t profileCycles() {
+  return xthal_get_ccount();
+}
+#else
+#include <Arduino.h>
+static inline uint32_t profileCycles() {
+  return micros();  // hosts without a cycle counter: 1 "cycle" per us
+}
+#endif
+
+struct ProfileSlot {
+  const char* name;
+  uint32_t count;
+  uint64_t totalCycles;
+  uint32_t minCycles;
+  uint32_t maxCycles;
+};
+
+// Finds or claims the table entry for name (a static string); nullptr
+// once the table is full.
+ProfileSlot* profileSlot(const char* name);
+
+class ProfileScope {
+public:
+  explicit ProfileScope(ProfileSlot* slot) : slot(slot), start(profileCycles()) {}
+  ~ProfileScope() {
+    if (slot == nullptr) return;
+    uint32_t cycles = profileCycles() - start;
+    slot->count++;
+    slot->totalCycles += cycles;
+    if (cycles < slot->minCycles) slot->minCycles = cycles;
+    if (cycles > slot->maxCycles) slot->maxCycles = cycles;
+  }
+
+private:
+  ProfileSlot* slot;
+  uint32_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name)                                                        \
+  static ProfileSlot* PROFILE_CONCAT(profileSlot_, __LINE__) = profileSlot(name); \
+  ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileSlot_, __LINE__))
+
+void profilePrint();
+void profileReset();
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#endif
+
+#endif // PROFILER_H
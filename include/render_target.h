@@ -0,0 +1,42 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <M5Unified.h>
+#include <stdint.h>
+
+// --- Frame Render Target ---
+// RENDER_MODE_DIRECT: primitives go straight to the panel over SPI.
+// RENDER_MODE_SPRITE: a frame is composed in an off-screen canvas (PSRAM on
+// the Core2) and pushed to the panel in one DMA transfer.
+// Select with -DRENDER_MODE=... in platformio.ini.
+#define RENDER_MODE_DIRECT 0
+#define RENDER_MODE_SPRITE 1
+
+#ifndef RENDER_MODE
+#define RENDER_MODE RENDER_MODE_DIRECT
+#endif
+
+struct RenderStats {
+  uint32_t frames;            // frames that pushed at least one pixel
+  uint32_t lastFramePixels;   // pixels sent to the panel by the last frame
+  uint64_t totalPixels;       // pixels sent to the panel since boot
+  uint32_t lastComposeUs;     // time spent issuing draw primitives
+  uint32_t lastPushUs;        // time spent handing the frame to the panel
+  uint64_t totalComposeUs;
+  uint64_t totalPushUs;
+};
+
+// Allocate the canvas in sprite mode. Call once after the panel is set up.
+void renderInit();
+
+// Start a frame and return the surface to draw it on.
+lgfx::LovyanGFX& frameBegin();
+
+// Finish the frame. pixelsDrawn is the area the caller touched; in sprite
+// mode the whole canvas is pushed whenever anything was drawn.
+void frameEnd(uint32_t pixelsDrawn);
+
+const RenderStats& renderStats();
+const char* renderModeName();
+
+#endif // RENDER_TARGET_H
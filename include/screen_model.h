@@ -0,0 +1,44 @@
+#ifndef SCREEN_MODEL_H
+#define SCREEN_MODEL_H
+
+#include <stdint.h>
+#include "game_config.h"
+
+// --- Retained-Mode Game Screen ---
+// The game screen is described as a handful of elements. Setters update the
+// wanted state; screenRender() compares it with what is on the panel and
+// repaints only the rectangles of elements that changed.
+enum ScreenElement {
+  ELEM_ROUND,
+  ELEM_STATUS,
+  ELEM_BARREL1,
+  ELEM_BARREL2,
+  ELEM_BARREL3,
+  ELEM_OVERLAY,
+  ELEM_COUNT
+};
+
+struct ScreenModel {
+  char roundText[24];
+  char statusText[32];
+  uint16_t barrelColor[NUM_BARRELS];
+  char overlayText[64];  // mem overlay at its widest is 53 with the NUL
+};
+
+void screenSetRound(int round, int maxRounds);
+void screenSetTitle(const char* text);  // replaces the round text
+void screenSetStatus(const char* text);
+void screenSetBarrelColor(int barrel, uint16_t color);  // barrel is 1..NUM_BARRELS
+void screenSetOverlay(const char* text);  // small debug line; "" hides it
+
+// Forget what is on the panel; the next render repaints the whole screen.
+// Call this whenever something else has drawn over the game screen.
+void screenInvalidate();
+
+// Bitmask of (1 << ScreenElement) for elements that differ from the panel.
+uint8_t screenDirtyMask();
+
+// Draw changed elements as one frame; returns the number of pixels drawn.
+uint32_t screenRender();
+
+#endif // SCREEN_MODEL_H
@@ -0,0 +1,20 @@
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+// --- Serial Debug Console ---
+// Line-based commands typed on the serial monitor ("help" lists them).
+// The loop polls for input; handlers run on the loop task and print their
+// replies straight to Serial, outside the deferred log.
+#define CONSOLE_MAX_COMMANDS 8
+#define CONSOLE_LINE_SIZE 48
+
+// args is the rest of the line after the command name ("" if none).
+typedef void (*ConsoleHandler)(const char* args);
+
+// name and help must be static strings. Returns false if the table is full.
+bool consoleRegister(const char* name, const char* help, ConsoleHandler handler);
+
+// Reads whatever serial input is waiting and runs each complete line.
+void consolePoll();
+
+#endif // SERIAL_CONSOLE_H
@@ -0,0 +1,47 @@
+#ifndef SPECTATOR_BROADCAST_H
+#define SPECTATOR_BROADCAST_H
+
+#include <stdint.h>
+
+// --- Spectator Broadcast ---
+// The shooter puts a few bytes of match state in the manufacturer data of
+// its BLE advertisements, and spectators only scan for them: no
+// connection, nothing on the game link and no state on the shooter per
+// observer, so any number can watch.
+//
+// On the BLE link the state rides in the advertisements that find
+// dodgers, next to the service UUID, and the shooter keeps advertising it
+// non-connectable, without the UUID, while it has no room for another
+// dodger. On ESP-NOW and the host links the shooter advertises it
+// non-connectable on its own. The advert link already publishes its
+// frames in the advertising data, so there is no broadcast on it.
+//
+// The advertising data changes only when the state does. A spectator
+// follows the first shooter it hears, and passes on a state only when it
+// differs from the last one.
+struct SpectatorSnapshot {
+  uint8_t round;
+  uint8_t flags;    // SNAP_* (game_protocol.h): the shot showing, game over
+  uint8_t playing;  // dodgers in the round: still to be shot at, or shot at once SNAP_SHOT_FIRED
+  uint8_t ready;    // of them, those that have chosen
+  uint8_t hits;     // hit by the shot, with SNAP_SHOT_FIRED
+};
+
+// Shooter. withService: the advertisements also find dodgers, so they
+// carry the game service and the caller starts and restarts them.
+void spectatorBroadcastBegin(bool withService);
+// Puts snap on the air if it changed.
+void spectatorPublish(const SpectatorSnapshot& snap);
+// BLE link: (re)starts advertising, a connection having stopped it;
+// connectable while the shooter takes another dodger.
+void spectatorAdvertise(bool connectable);
+
+// Spectator: scans until the end.
+void spectatorListen();
+// The next state heard, oldest first. False if there is none.
+bool spectatorReceive(SpectatorSnapshot* snap);
+// True, once, when the followed shooter has gone quiet; the next shooter
+// heard is followed instead.
+bool spectatorShooterLost(uint32_t nowUs);
+
+#endif // SPECTATOR_BROADCAST_H
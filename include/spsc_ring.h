@@ -0,0 +1,55 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Lock-Free Single-Producer / Single-Consumer Ring ---
+// One task may push and one (other) task may pop, with no locks. Capacity
+// must be a power of two. A push into a full ring is refused and counted
+// rather than overwriting an unread item.
+template <typename T, size_t Capacity>
+class SpscRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SpscRing capacity must be a power of two");
+
+public:
+  // Producer side.
+  bool push(const T& item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == Capacity) {
+      overflows.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    slots[h & (Capacity - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side.
+  bool pop(T* item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    *item = slots[t & (Capacity - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  // Pushes refused because the ring was full.
+  uint32_t overflowCount() const {
+    return overflows.load(std::memory_order_relaxed);
+  }
+
+private:
+  T slots[Capacity];
+  std::atomic<size_t> head{0};  // written by the producer only
+  std::atomic<size_t> tail{0};  // written by the consumer only
+  std::atomic<uint32_t> overflows{0};
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,91 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// --- Timeline Trace ---
+// Records begin/end, instant and counter events with microsecond times
+// into a fixed ring (the oldest events are overwritten). "trace" on the
+// serial console dumps the ring as #TRACE text lines; tools/trace2json.py
+// turns a capture of them into Chrome trace JSON for chrome://tracing or
+// ui.perfetto.dev. With TRACE=0 every macro expands to nothing.
+#ifndef TRACE
+#define TRACE 0
+#endif
+
+#define TRACE_EVENTS 4096          // 12 bytes each, kept in PSRAM when present
+#define TRACE_NAMES 64
+
+// Timeline rows; the converter shows each as a thread.
+enum TraceTrack {
+  TRACE_TRACK_LOOP,                // loop task work
+  TRACE_TRACK_BLE,                 // Bluedroid callbacks
+  TRACE_TRACK_STATE,               // game state spans
+  TRACE_TRACK_LINK,                // dodger link state spans
+  TRACE_TRACK_COUNT
+};
+
+enum TraceType : uint8_t {
+  TRACE_BEGIN_EVENT = 'B',
+  TRACE_END_EVENT = 'E',
+  TRACE_INSTANT_EVENT = 'i',
+  TRACE_COUNTER_EVENT = 'C'
+};
+
+struct TraceEvent {
+  uint32_t us;
+  uint8_t type;                    // TraceType
+  uint8_t track;                   // TraceTrack
+  uint16_t name;                   // index into the name table
+  int32_t arg;
+};
+
+#if TRACE
+// Allocates the ring; call from setup().
+void traceInit();
+
+// Id for a static name string, registering it on first use.
+uint16_t traceNameId(const char* name);
+
+void traceEvent(uint8_t type, uint8_t track, uint16_t name, int32_t arg);
+
+// Writes the ring as #TRACE lines to Serial, then clears it. Recording is
+// paused while dumping.
+void traceDump();
+void traceClear();
+
+class TraceScope {
+public:
+  TraceScope(uint8_t track, uint16_t name) : track(track), name(name) {
+    traceEvent(TRACE_BEGIN_EVENT, track, name, 0);
+  }
+  ~TraceScope() { traceEvent(TRACE_END_EVENT, track, name, 0); }
+
+private:
+  uint8_t track;
+  uint16_t name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ID(name) \
+  ([]() { static const uint16_t id = traceNameId(name); return id; }())
+#define TRACE_SCOPE(track, name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(track, TRACE_ID(name))
+#define TRACE_BEGIN(track, name) traceEvent(TRACE_BEGIN_EVENT, track, TRACE_ID(name), 0)
+#define TRACE_END(track, name) traceEvent(TRACE_END_EVENT, track, TRACE_ID(name), 0)
+#define TRACE_INSTANT(track, name, arg) traceEvent(TRACE_INSTANT_EVENT, track, TRACE_ID(name), (int32_t)(arg))
+#define TRACE_COUNTER(name, value) traceEvent(TRACE_COUNTER_EVENT, TRACE_TRACK_LOOP, TRACE_ID(name), (int32_t)(value))
+// Spans whose name is only known at run time (state names).
+#define TRACE_BEGIN_NAMED(track, name) traceEvent(TRACE_BEGIN_EVENT, track, traceNameId(name), 0)
+#define TRACE_END_NAMED(track, name) traceEvent(TRACE_END_EVENT, track, traceNameId(name), 0)
+#else
+#define TRACE_SCOPE(track, name) do {} while (0)
+#define TRACE_BEGIN(track, name) do {} while (0)
+#define TRACE_END(track, name) do {} while (0)
+#define TRACE_INSTANT(track, name, arg) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#define TRACE_BEGIN_NAMED(track, name) do {} while (0)
+#define TRACE_END_NAMED(track, name) do {} while (0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,111 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Frame Transport ---
+// The game hands encoded frames to one backend and gets the peer's frames
+// back through a handler, so the game logic does not depend on the radio:
+//   bleTransport    - GATT notify/write on the shooter's service (transport_ble.h)
+//   espNowTransport - connectionless ESP-NOW frames (transport_espnow.h)
+//   advTransport    - frames published in BLE advertisements (transport_adv.h)
+//   hostTransport   - simulator loopback or Unix socket (transport_host.h)
+// Link setup (advertising, scanning, connecting) stays with the caller for
+// BLE; other backends report link changes through the link handler.
+//
+// Outgoing frames pass through a link conditioner that can add latency,
+// jitter and loss on any backend, on hardware as in the simulator.
+enum TransportChannel {
+  CHANNEL_GAME,   // game frames
+  CHANNEL_BENCH,  // benchmark frames, possibly padded
+  CHANNEL_COUNT
+};
+
+// A backend may carry links to several peers at once (the BLE server with
+// several dodgers connected); frames then name the link they came in on
+// or go out on. Backends with a single link report peer 0 and send every
+// frame to their one peer.
+typedef uint16_t TransportPeer;
+#define TRANSPORT_PEER_ALL 0xFFFF  // send: every peer
+
+struct TransportBackend {
+  const char* name;
+  // Start offering a link (host: the shooter) or looking for one. May be
+  // called again after the link drops. nullptr if the caller sets up links.
+  void (*begin)(bool host);
+  // Hand one frame to the link to peer; false if there is no such peer.
+  bool (*send)(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len);
+  // Timed upkeep (beacons, peer timeouts) on the loop task. Returns
+  // microseconds until it is needed again, or UINT32_MAX. May be nullptr.
+  uint32_t (*poll)(uint32_t nowUs);
+};
+
+// Called for each frame from the peer, on the backend's task. data is only
+// valid during the call.
+typedef void (*TransportRxHandler)(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len);
+// Called when a backend with begin() gains or loses its peer.
+typedef void (*TransportLinkHandler)(bool up);
+
+void transportInit(const TransportBackend* backend, TransportRxHandler rx, TransportLinkHandler link);
+const TransportBackend* transportBackend();
+void transportBegin(bool host);
+
+// Sends a frame now, or queues it if the link conditions delay it. False
+// if the backend has no peer; a frame dropped as lost still returns true.
+bool transportSend(TransportChannel channel, const uint8_t* data, size_t len);
+// The same, to one peer of a backend with several links.
+bool transportSendTo(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len);
+
+// For backends: deliver a frame from the peer (or from one of several),
+// report a link change.
+void transportReceive(TransportChannel channel, const uint8_t* data, size_t len);
+void transportReceiveFrom(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len);
+void transportLinkChanged(bool up);
+
+// --- Link Conditioner ---
+// Applied to frames this device sends; set the same conditions on both
+// ends for a symmetric link. Frames stay in order, as on a BLE link, so
+// jitter never lets a frame overtake an earlier one. Loss stands for
+// frames lost above the link layer (the BLE link layer itself retries).
+struct LinkConditions {
+  const char* name;
+  uint32_t latencyUs;       // added to every frame
+  uint32_t jitterUs;        // plus a uniform 0..jitterUs
+  uint16_t lossPermille;    // frames dropped per 1000
+};
+
+enum LinkProfileId {
+  LINK_IDEAL,     // no conditioning
+  LINK_GOOD,      // one 7.5 ms connection interval of wait
+  LINK_BUSY,      // crowded 2.4 GHz band: retransmissions and long intervals
+  LINK_LOSSY,     // edge of range
+  LINK_PROFILE_COUNT
+};
+
+const LinkConditions linkProfiles[LINK_PROFILE_COUNT] = {
+  { "ideal", 0, 0, 0 },
+  { "good", 3750, 7500, 0 },
+  { "busy", 30000, 30000, 10 },
+  { "lossy", 50000, 50000, 50 },
+};
+
+#define TRANSPORT_QUEUE_SLOTS 32  // delayed frames in flight
+
+struct TransportStats {
+  uint32_t sent;        // handed to the backend
+  uint32_t lost;        // dropped by the loss setting
+  uint32_t overflow;    // dropped because the delay queue was full
+  uint8_t maxQueued;    // deepest the delay queue has been
+};
+
+void transportSetConditions(const LinkConditions& conditions);
+const LinkConditions& transportConditions();
+const TransportStats& transportStats();
+
+// Sends the delayed frames that are due and runs the backend's upkeep.
+// Returns microseconds until either is next needed, or UINT32_MAX. Call
+// from the loop.
+uint32_t transportPoll(uint32_t nowUs);
+
+#endif // TRANSPORT_H
@@ -0,0 +1,34 @@
+#ifndef TRANSPORT_ADV_H
+#define TRANSPORT_ADV_H
+
+#include "transport.h"
+
+// --- BLE Advertising Transport ---
+// No connection at all: each device puts its latest frame (which carries
+// its round and committed choice) in the manufacturer data of its own
+// non-connectable advertisements and scans continuously, with duplicates,
+// for the other role's. The first device of the other role heard is the
+// peer; it is reported lost after a quiet spell and found again as soon
+// as it is heard, with no connection setup or discovery in between.
+//
+// A frame stays on the air until the next replaces it, so every
+// advertising event repeats it. Each publication carries a sequence
+// number, and the receiver passes on a publication only once: a repeat
+// is a duplicate, an older number is stale. Frames sent close together
+// are queued so each is on the air for a few advertising events before
+// the next replaces it. Rounds older than the game's are dropped by the
+// game itself, as for the other links.
+#define ADV_QUEUE_SLOTS 8  // frames waiting for their turn on the air
+
+struct AdvTransportStats {
+  uint32_t published;   // publications put on the air
+  uint32_t accepted;    // peer publications passed on
+  uint32_t duplicates;  // repeats of an accepted publication
+  uint32_t stale;       // publications older than an accepted one
+};
+
+extern const TransportBackend advTransport;
+
+const AdvTransportStats& advTransportStats();
+
+#endif // TRANSPORT_ADV_H
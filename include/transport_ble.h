@@ -0,0 +1,27 @@
+#ifndef TRANSPORT_BLE_H
+#define TRANSPORT_BLE_H
+
+#include <BLEDevice.h>
+#include "transport.h"
+
+// --- BLE GATT Transport ---
+// The shooter notifies on its characteristics and receives the dodgers'
+// writes to them, each tagged with the writer's connection ID as its
+// peer; the dodger writes and subscribes to notifications. The caller
+// creates the GATT objects and manages the connections, then attaches
+// them here.
+extern const TransportBackend bleTransport;
+
+// Shooter: frames go out as notifications on these characteristics and
+// writes to them come in. bench may be nullptr.
+void bleTransportServe(BLECharacteristic* game, BLECharacteristic* bench);
+// Shooter: at least one central is connected (or none); notifications
+// need one.
+void bleTransportSetServerLinked(bool linked);
+
+// Dodger: subscribe to the shooter's characteristics once discovered, and
+// stop using them when the link drops. bench may be nullptr.
+void bleTransportAttach(BLERemoteCharacteristic* game, BLERemoteCharacteristic* bench);
+void bleTransportDetach();
+
+#endif // TRANSPORT_BLE_H
@@ -0,0 +1,31 @@
+#ifndef TRANSPORT_ESPNOW_H
+#define TRANSPORT_ESPNOW_H
+
+#include "transport.h"
+
+// --- ESP-NOW Transport ---
+// Frames go out as ESP-NOW packets on a fixed Wi-Fi channel, with no
+// connection, discovery or connection interval in the way. The shooter
+// broadcasts a pairing beacon; the first dodger that answers is paired by
+// MAC address. From then on frames are unicast to that address, where
+// ESP-NOW acknowledges and retries them, and packets from any other
+// address are dropped. Both ends send a heartbeat, and a peer that has
+// gone quiet is unpaired and reported as a lost link.
+//
+// ESP-NOW reports each unicast's fate in its send callback. The latest game
+// frame is kept until then, and sent again up to ESPNOW_GAME_RESENDS times
+// if it was not acknowledged.
+#define ESPNOW_WIFI_CHANNEL 1
+#define ESPNOW_GAME_RESENDS 3
+
+struct EspNowTransportStats {
+  uint32_t failed;     // unicasts the peer did not acknowledge
+  uint32_t resent;     // game frames sent again after a failure
+  uint32_t abandoned;  // game frames still failing after every resend
+};
+
+extern const TransportBackend espNowTransport;
+
+const EspNowTransportStats& espNowTransportStats();
+
+#endif // TRANSPORT_ESPNOW_H
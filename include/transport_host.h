@@ -0,0 +1,22 @@
+#ifndef TRANSPORT_HOST_H
+#define TRANSPORT_HOST_H
+
+#include "transport.h"
+
+// --- Simulator Transport ---
+// In the native simulator (TRANSPORT_HOST=1) a device can be given a frame
+// link that bypasses the BLE radio: a zero-copy in-process loopback to
+// another simulated device, or a Unix-domain socket to a device in another
+// simulator process (see lib/sim_hal/src/sim_link.h).
+#ifndef TRANSPORT_HOST
+#define TRANSPORT_HOST 0
+#endif
+
+#if TRANSPORT_HOST
+extern const TransportBackend hostTransport;
+
+// True if the simulator gave this device a host link instead of BLE.
+bool hostTransportConfigured();
+#endif
+
+#endif // TRANSPORT_HOST_H
@@ -0,0 +1,62 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// --- Arduino core (simulator) ---
+// Time is the running device's: millis() and micros() count from its
+// power-up. delay() blocks only the calling task.
+#define IRAM_ATTR
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define digitalPinToInterrupt(pin) (pin)
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+// Serial monitor of the running device. Output goes to stdout a line at a
+// time, prefixed with the sim time and the device's label; input comes
+// from simSerialInput().
+class HardwareSerial {
+public:
+  void begin(unsigned long baud) {}
+  int available();
+  int read();
+  size_t write(uint8_t c);
+  size_t write(const uint8_t* data, size_t len);
+  size_t print(const char* text);
+  size_t print(char c);
+  size_t print(int value);
+  size_t print(unsigned int value);
+  size_t print(long value);
+  size_t print(unsigned long value);
+  size_t println();
+  size_t println(const char* text);
+  size_t println(int value);
+  size_t println(unsigned int value);
+  size_t println(long value);
+  size_t println(unsigned long value);
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
+
+#endif // SIM_ARDUINO_H
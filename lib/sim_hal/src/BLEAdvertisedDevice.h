@@ -0,0 +1,7 @@
+#ifndef SIM_BLEADVERTISEDDEVICE_H
+#define SIM_BLEADVERTISEDDEVICE_H
+
+// Declared with the rest of the BLE classes.
+#include "BLEDevice.h"
+
+#endif // SIM_BLEADVERTISEDDEVICE_H
@@ -0,0 +1,7 @@
+#ifndef SIM_BLECLIENT_H
+#define SIM_BLECLIENT_H
+
+// Declared with the rest of the BLE classes.
+#include "BLEDevice.h"
+
+#endif // SIM_BLECLIENT_H
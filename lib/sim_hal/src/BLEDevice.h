@@ -0,0 +1,371 @@
+#ifndef SIM_BLEDEVICE_H
+#define SIM_BLEDEVICE_H
+
+#include <Arduino.h>
+#include <esp_err.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// --- ESP32 BLE Arduino (simulator) ---
+// The subset of the Bluedroid wrapper classes the firmware uses, over an
+// in-memory radio shared by all simulated devices. Devices advertise to
+// every scanning device; a client connects by address to a connectable one. Writes and
+// notifications reach the peer on the link's next connection event (the
+// interval follows updateConnParams) and their callbacks run on the
+// receiving device outside its tasks, like Bluedroid's callback task.
+// A server takes any number of connections, each with its own conn_id.
+typedef uint8_t esp_bd_addr_t[6];
+typedef uint8_t esp_gatt_if_t;
+
+typedef enum {
+  BLE_ADDR_TYPE_PUBLIC = 0x00,
+  BLE_ADDR_TYPE_RANDOM = 0x01,
+} esp_ble_addr_type_t;
+
+typedef enum {
+  ADV_TYPE_IND = 0x00,
+  ADV_TYPE_DIRECT_IND_HIGH = 0x01,
+  ADV_TYPE_SCAN_IND = 0x02,
+  ADV_TYPE_NONCONN_IND = 0x03,
+  ADV_TYPE_DIRECT_IND_LOW = 0x04,
+} esp_ble_adv_type_t;
+
+#define ESP_BLE_ADV_FLAG_GEN_DISC      0x02
+#define ESP_BLE_ADV_FLAG_BREDR_NOT_SPT 0x04
+#define ESP_BLE_ADV_DATA_LEN_MAX       31
+
+typedef union {
+  struct {
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+  } connect;
+  struct {
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+    int reason;
+  } disconnect;
+  struct {
+    uint16_t conn_id;
+    esp_bd_addr_t bda;
+  } write;
+} esp_ble_gatts_cb_param_t;
+
+class BLEUUID {
+public:
+  BLEUUID() {}
+  BLEUUID(const char* uuid);
+  BLEUUID(const std::string& uuid);
+  bool equals(const BLEUUID& other) const { return value == other.value; }
+  std::string toString() const { return value; }
+
+private:
+  std::string value;  // lower case
+};
+
+class BLEAddress {
+public:
+  BLEAddress(esp_bd_addr_t address);
+  BLEAddress(const std::string& address);
+  bool equals(const BLEAddress& other) const;
+  esp_bd_addr_t* getNative() { return &native; }
+  std::string toString() const;
+
+private:
+  esp_bd_addr_t native;
+};
+
+class BLEServer;
+class BLEService;
+class BLECharacteristic;
+class BLERemoteCharacteristic;
+class BLERemoteService;
+class BLEClient;
+struct SimBleLink;
+
+class BLECharacteristicCallbacks {
+public:
+  virtual ~BLECharacteristicCallbacks() {}
+  virtual void onRead(BLECharacteristic* characteristic) {}
+  virtual void onWrite(BLECharacteristic* characteristic) {}
+  virtual void onWrite(BLECharacteristic* characteristic, esp_ble_gatts_cb_param_t* param) {
+    onWrite(characteristic);
+  }
+};
+
+class BLECharacteristic {
+public:
+  static const uint32_t PROPERTY_READ = 1 << 0;
+  static const uint32_t PROPERTY_WRITE = 1 << 1;
+  static const uint32_t PROPERTY_NOTIFY = 1 << 2;
+  static const uint32_t PROPERTY_BROADCAST = 1 << 3;
+  static const uint32_t PROPERTY_INDICATE = 1 << 4;
+  static const uint32_t PROPERTY_WRITE_NR = 1 << 5;
+
+  BLECharacteristic(const BLEUUID& uuid, uint32_t properties, BLEService* service);
+  BLEUUID getUUID() const { return uuid; }
+  uint32_t getProperties() const { return properties; }
+  void setCallbacks(BLECharacteristicCallbacks* callbacks) { this->callbacks = callbacks; }
+  void setValue(uint8_t* data, size_t len);
+  void setValue(const std::string& value);
+  std::string getValue() { return value; }
+  uint8_t* getData() { return (uint8_t*)value.data(); }
+  size_t getLength() { return value.size(); }
+  // Sends the value to every connected client subscribed to it.
+  void notify(bool isNotification = true);
+  // Attribute handle, unique across all simulated servers.
+  uint16_t getHandle() const { return handle; }
+  BLEService* getService() { return service; }
+
+  // Simulator: a client wrote data.
+  void simWritten(const uint8_t* data, size_t len, SimBleLink* link);
+  std::vector<BLERemoteCharacteristic*> subscribers;
+
+private:
+  BLEUUID uuid;
+  uint32_t properties;
+  BLEService* service;
+  BLECharacteristicCallbacks* callbacks;
+  std::string value;
+  uint16_t handle;
+};
+
+class BLEService {
+public:
+  BLEService(const BLEUUID& uuid, BLEServer* server) : uuid(uuid), server(server) {}
+  BLECharacteristic* createCharacteristic(const char* uuid, uint32_t properties);
+  BLECharacteristic* getCharacteristic(const BLEUUID& uuid);
+  BLEUUID getUUID() const { return uuid; }
+  BLEServer* getServer() { return server; }
+  void start() {}
+
+private:
+  BLEUUID uuid;
+  BLEServer* server;
+  std::vector<BLECharacteristic*> characteristics;
+};
+
+class BLEServerCallbacks {
+public:
+  virtual ~BLEServerCallbacks() {}
+  virtual void onConnect(BLEServer* server) {}
+  virtual void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) {}
+  virtual void onDisconnect(BLEServer* server) {}
+  virtual void onDisconnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) {}
+};
+
+class BLEServer {
+public:
+  BLEServer();
+  void setCallbacks(BLEServerCallbacks* callbacks) { this->callbacks = callbacks; }
+  BLEService* createService(const char* uuid);
+  BLEService* getServiceByUUID(const BLEUUID& uuid);
+  uint32_t getConnectedCount();
+  // Intervals in 1.25 ms units, timeout in 10 ms units (as in Bluedroid).
+  void updateConnParams(esp_bd_addr_t remote, uint16_t minInterval, uint16_t maxInterval,
+                        uint16_t latency, uint16_t timeout);
+  void disconnect(uint16_t connId);
+  esp_gatt_if_t getGattsIf() { return gattsIf; }
+
+  BLEServerCallbacks* callbacks;
+  std::vector<BLEService*> services;
+
+private:
+  esp_gatt_if_t gattsIf;
+};
+
+// Notifies (or indicates) value on one connection, whether or not its
+// client subscribed, as Bluedroid does.
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                      uint16_t value_len, uint8_t* value, bool need_confirm);
+
+// Raw advertising data, built from AD structures (length, type, value).
+class BLEAdvertisementData {
+public:
+  void setFlags(uint8_t flags) { addStructure(0x01, std::string(1, (char)flags)); }
+  void setName(const std::string& name) { addStructure(0x09, name); }
+  // A 128-bit UUID, least significant byte first.
+  void setCompleteServices(const BLEUUID& uuid);
+  void setManufacturerData(const std::string& data) { addStructure(0xFF, data); }
+  void addData(const std::string& data) { payload += data; }
+  std::string getPayload() { return payload; }
+
+private:
+  void addStructure(uint8_t type, const std::string& value) {
+    payload += (char)(value.size() + 1);
+    payload += (char)type;
+    payload += value;
+  }
+  std::string payload;
+};
+
+class BLEAdvertising {
+public:
+  BLEAdvertising() : active(false), connectable(true), customData(false), intervalUnits(0x20), startUs(0) {}
+  void addServiceUUID(const char* uuid) { serviceUUIDs.push_back(BLEUUID(uuid)); }
+  void addServiceUUID(const BLEUUID& uuid) { serviceUUIDs.push_back(uuid); }
+  void setScanResponse(bool enabled) {}
+  void setMinPreferred(uint16_t interval) {}
+  void setMaxPreferred(uint16_t interval) {}
+  // Kept, not sent: sim scans are passive.
+  void setScanResponseData(BLEAdvertisementData& data) { scanResponse = data.getPayload(); }
+  // 0.625 ms units. Advertising events follow the minimum interval.
+  void setMinInterval(uint16_t interval) { intervalUnits = interval; }
+  void setMaxInterval(uint16_t interval) {}
+  void setAdvertisementType(esp_ble_adv_type_t type) {
+    connectable = type == ADV_TYPE_IND || type == ADV_TYPE_DIRECT_IND_HIGH || type == ADV_TYPE_DIRECT_IND_LOW;
+  }
+  // Replaces the service UUIDs in what is advertised. Takes effect from
+  // the next advertising event, also while advertising.
+  void setAdvertisementData(BLEAdvertisementData& data) {
+    payload = data.getPayload();
+    customData = true;
+  }
+  void start();
+  void stop();
+
+  std::vector<BLEUUID> serviceUUIDs;
+  bool active;
+  bool connectable;
+  bool customData;
+  std::string payload;     // with customData
+  std::string scanResponse;
+  uint16_t intervalUnits;
+  uint64_t startUs;  // sim time
+};
+
+class BLEAdvertisedDevice {
+public:
+  BLEAdvertisedDevice(const BLEAddress& address) : address(address), rssi(-60) {}
+  BLEAddress getAddress() { return address; }
+  esp_ble_addr_type_t getAddressType() { return BLE_ADDR_TYPE_PUBLIC; }
+  std::string getName() { return name; }
+  bool haveName() { return !name.empty(); }
+  int getRSSI() { return rssi; }
+  bool haveRSSI() { return true; }
+  bool haveServiceUUID() { return !serviceUUIDs.empty(); }
+  bool isAdvertisingService(const BLEUUID& uuid);
+  bool haveManufacturerData() { return !manufacturerData.empty(); }
+  std::string getManufacturerData() { return manufacturerData; }
+  std::string toString() { return address.toString(); }
+
+  std::vector<BLEUUID> serviceUUIDs;
+  std::string name;
+  std::string manufacturerData;
+
+private:
+  BLEAddress address;
+  int rssi;
+};
+
+class BLEAdvertisedDeviceCallbacks {
+public:
+  virtual ~BLEAdvertisedDeviceCallbacks() {}
+  virtual void onResult(BLEAdvertisedDevice advertisedDevice) = 0;
+};
+
+class BLEScanResults {
+public:
+  int getCount() { return count; }
+  int count = 0;
+};
+
+class BLEScan {
+public:
+  BLEScan() : callbacks(nullptr), wantDuplicates(false), scanning(false),
+              startUs(0), endUs(0), onComplete(nullptr) {}
+  // With wantDuplicates every advertising event heard is reported, with the
+  // data advertised at the time; otherwise each device once per scan.
+  void setAdvertisedDeviceCallbacks(BLEAdvertisedDeviceCallbacks* callbacks, bool wantDuplicates = false) {
+    this->callbacks = callbacks;
+    this->wantDuplicates = wantDuplicates;
+  }
+  void setActiveScan(bool active) {}
+  void setInterval(uint16_t interval) {}
+  void setWindow(uint16_t window) {}
+  // Scans for duration seconds without blocking; onComplete runs when the
+  // window ends (not when stop() is called).
+  bool start(uint32_t duration, void (*onComplete)(BLEScanResults), bool continuePrevious = false);
+  void stop();
+  void clearResults();
+
+  BLEAdvertisedDeviceCallbacks* callbacks;
+  bool wantDuplicates;
+  bool scanning;
+  uint64_t startUs, endUs;  // sim time
+  void (*onComplete)(BLEScanResults);
+  std::vector<std::string> seen;  // addresses reported in this scan
+  std::vector<uint64_t> seenUs;   // when each was last reported
+};
+
+typedef void (*notify_callback)(BLERemoteCharacteristic* characteristic, uint8_t* data,
+                                size_t length, bool isNotify);
+
+class BLERemoteCharacteristic {
+public:
+  BLERemoteCharacteristic(BLECharacteristic* target, BLEClient* client)
+      : target(target), client(client), onNotify(nullptr) {}
+  BLEUUID getUUID() { return target->getUUID(); }
+  bool canNotify() { return (target->getProperties() & BLECharacteristic::PROPERTY_NOTIFY) != 0; }
+  bool canWrite() { return (target->getProperties() & BLECharacteristic::PROPERTY_WRITE) != 0; }
+  bool canWriteNoResponse() { return (target->getProperties() & BLECharacteristic::PROPERTY_WRITE_NR) != 0; }
+  void registerForNotify(notify_callback callback, bool notifications = true, bool descriptorRequiresRegistration = true);
+  void writeValue(uint8_t* data, size_t length, bool response = false);
+  void writeValue(const std::string& value, bool response = false);
+
+  BLECharacteristic* target;
+  BLEClient* client;
+  notify_callback onNotify;
+};
+
+class BLERemoteService {
+public:
+  BLERemoteService(BLEService* target, BLEClient* client) : target(target), client(client) {}
+  // Blocks the calling task for characteristic discovery.
+  BLERemoteCharacteristic* getCharacteristic(const BLEUUID& uuid);
+
+private:
+  BLEService* target;
+  BLEClient* client;
+  std::vector<BLERemoteCharacteristic*> characteristics;
+};
+
+class BLEClientCallbacks {
+public:
+  virtual ~BLEClientCallbacks() {}
+  virtual void onConnect(BLEClient* client) = 0;
+  virtual void onDisconnect(BLEClient* client) = 0;
+};
+
+class BLEClient {
+public:
+  BLEClient() : callbacks(nullptr), link(nullptr) {}
+  void setClientCallbacks(BLEClientCallbacks* callbacks) { this->callbacks = callbacks; }
+  // Blocks the calling task for connection setup; false if no device
+  // with that address is advertising.
+  bool connect(BLEAddress address, esp_ble_addr_type_t type = BLE_ADDR_TYPE_PUBLIC);
+  void disconnect();
+  bool isConnected();
+  // Blocks the calling task for service discovery.
+  BLERemoteService* getService(const BLEUUID& uuid);
+
+  BLEClientCallbacks* callbacks;
+  SimBleLink* link;
+
+private:
+  std::vector<BLERemoteService*> services;
+};
+
+class BLEDevice {
+public:
+  static void init(const std::string& deviceName);
+  static BLEServer* createServer();
+  static BLEClient* createClient();
+  static BLEScan* getScan();
+  static BLEAdvertising* getAdvertising();
+  static void startAdvertising();
+  static void stopAdvertising();
+  static BLEAddress getAddress();
+};
+
+#endif // SIM_BLEDEVICE_H
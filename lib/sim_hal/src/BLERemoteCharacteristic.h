@@ -0,0 +1,7 @@
+#ifndef SIM_BLEREMOTECHARACTERISTIC_H
+#define SIM_BLEREMOTECHARACTERISTIC_H
+
+// Declared with the rest of the BLE classes.
+#include "BLEDevice.h"
+
+#endif // SIM_BLEREMOTECHARACTERISTIC_H
@@ -0,0 +1,7 @@
+#ifndef SIM_BLESCAN_H
+#define SIM_BLESCAN_H
+
+// Declared with the rest of the BLE classes.
+#include "BLEDevice.h"
+
+#endif // SIM_BLESCAN_H
@@ -0,0 +1,7 @@
+#ifndef SIM_BLESERVER_H
+#define SIM_BLESERVER_H
+
+// Declared with the rest of the BLE classes.
+#include "BLEDevice.h"
+
+#endif // SIM_BLESERVER_H
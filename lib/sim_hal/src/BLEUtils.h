@@ -0,0 +1,7 @@
+#ifndef SIM_BLEUTILS_H
+#define SIM_BLEUTILS_H
+
+// Declared with the rest of the BLE classes.
+#include "BLEDevice.h"
+
+#endif // SIM_BLEUTILS_H
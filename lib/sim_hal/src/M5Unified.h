@@ -0,0 +1,147 @@
+#ifndef SIM_M5UNIFIED_H
+#define SIM_M5UNIFIED_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+// --- M5Unified / LovyanGFX (simulator) ---
+// M5.Display draws on the running device's panel and M5.Touch reads its
+// touch panel (pressed with simTouch()). A surface is an RGB565
+// framebuffer that also records the text drawn on it, for the harness, and
+// counts pixel writes per frame.
+#define TFT_BLACK       0x0000
+#define TFT_NAVY        0x000F
+#define TFT_DARKGREEN   0x03E0
+#define TFT_MAROON      0x7800
+#define TFT_PURPLE      0x780F
+#define TFT_OLIVE       0x7BE0
+#define TFT_LIGHTGREY   0xD69A
+#define TFT_DARKGREY    0x7BEF
+#define TFT_BLUE        0x001F
+#define TFT_GREEN       0x07E0
+#define TFT_CYAN        0x07FF
+#define TFT_RED         0xF800
+#define TFT_MAGENTA     0xF81F
+#define TFT_YELLOW      0xFFE0
+#define TFT_WHITE       0xFFFF
+#define TFT_ORANGE      0xFDA0
+
+#define BLACK     TFT_BLACK
+#define NAVY      TFT_NAVY
+#define DARKGREEN TFT_DARKGREEN
+#define MAROON    TFT_MAROON
+#define PURPLE    TFT_PURPLE
+#define OLIVE     TFT_OLIVE
+#define LIGHTGREY TFT_LIGHTGREY
+#define DARKGREY  TFT_DARKGREY
+#define BLUE      TFT_BLUE
+#define GREEN     TFT_GREEN
+#define CYAN      TFT_CYAN
+#define RED       TFT_RED
+#define MAGENTA   TFT_MAGENTA
+#define YELLOW    TFT_YELLOW
+#define WHITE     TFT_WHITE
+#define ORANGE    TFT_ORANGE
+
+struct SimSurface;
+// The surface of the canvas whose buffer this is, or nullptr.
+SimSurface* simCanvasSurface(const void* buffer);
+
+namespace lgfx {
+
+struct swap565_t {
+  uint8_t raw[2];
+};
+
+class LovyanGFX {
+public:
+  LovyanGFX() : textSize(1), textColor(TFT_WHITE), textBackground(TFT_BLACK) {}
+  virtual ~LovyanGFX() {}
+
+  int32_t width();
+  int32_t height();
+  void setRotation(uint8_t rotation) {}
+  void startWrite();
+  void endWrite();
+  void initDMA() {}
+  void waitDMA() {}
+
+  void setTextSize(float size) { textSize = size; }
+  // One colour draws transparent text; two fill each glyph cell.
+  void setTextColor(uint32_t color) { textColor = textBackground = color; }
+  void setTextColor(uint32_t color, uint32_t background) {
+    textColor = color;
+    textBackground = background;
+  }
+
+  void fillScreen(uint32_t color);
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawString(const char* text, int32_t x, int32_t y, uint8_t font);
+  void drawCentreString(const char* text, int32_t x, int32_t y, uint8_t font);
+  void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const swap565_t* data);
+
+protected:
+  // The surface drawn on: the running device's panel unless overridden.
+  virtual SimSurface* surface();
+
+  float textSize;
+  uint32_t textColor;
+  uint32_t textBackground;
+};
+
+} // namespace lgfx
+
+// Off-screen sprite, pushed to the panel with pushImageDMA.
+class M5Canvas : public lgfx::LovyanGFX {
+public:
+  explicit M5Canvas(lgfx::LovyanGFX* parent);
+  ~M5Canvas();
+  void setColorDepth(int bits) {}
+  void setPsram(bool enabled) {}
+  void* createSprite(int32_t w, int32_t h);
+  void* getBuffer() { return buffer; }
+
+protected:
+  SimSurface* surface();
+
+private:
+  friend SimSurface* simCanvasSurface(const void* buffer);
+  SimSurface* own;
+  uint16_t* buffer;
+};
+
+namespace m5 {
+
+struct touch_detail_t {
+  int16_t x;
+  int16_t y;
+};
+
+class Touch_Class {
+public:
+  void begin(lgfx::LovyanGFX* display) {}
+  // State as of the last M5.update().
+  uint8_t getCount();
+  touch_detail_t getDetail(uint8_t index = 0);
+};
+
+struct config_t {
+  bool serial_enable = true;
+  bool clear_display = true;
+};
+
+class M5Unified {
+public:
+  lgfx::LovyanGFX Display;
+  Touch_Class Touch;
+  config_t config() { return config_t(); }
+  void begin(const config_t& cfg);
+  void update();
+};
+
+} // namespace m5
+
+extern m5::M5Unified M5;
+
+#endif // SIM_M5UNIFIED_H
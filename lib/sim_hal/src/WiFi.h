@@ -0,0 +1,17 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include "esp_wifi.h"
+
+// --- Arduino WiFi (simulator) ---
+// Station mode is all ESP-NOW needs; there are no access points to join.
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t mode);
+};
+
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
@@ -0,0 +1,15 @@
+#ifndef SIM_ESP_ERR_H
+#define SIM_ESP_ERR_H
+
+// --- ESP-IDF error codes (simulator) ---
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_ESPNOW_NOT_INIT 0x3065
+#define ESP_ERR_ESPNOW_FULL 0x3067
+#define ESP_ERR_ESPNOW_NOT_FOUND 0x3069
+#define ESP_ERR_ESPNOW_EXIST 0x306b
+
+#endif // SIM_ESP_ERR_H
@@ -0,0 +1,49 @@
+#ifndef SIM_ESP_NOW_H
+#define SIM_ESP_NOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+
+// --- ESP-NOW (simulator) ---
+// An in-memory radio shared by all simulated devices. A packet reaches
+// every initialised device on the sender's channel (broadcast address) or
+// the one whose station MAC matches, after its airtime at the 1 Mbps
+// ESP-NOW rate; the receive callback runs on that device outside its
+// tasks, like the Wi-Fi task. Unicast needs the peer added first. The send
+// callback runs on the sender once the packet (and a unicast's ACK) has
+// been on the air: a unicast fails if no device with that MAC is on the
+// channel to acknowledge it, a broadcast always succeeds.
+#define ESP_NOW_ETH_ALEN 6
+#define ESP_NOW_KEY_LEN 16
+#define ESP_NOW_MAX_DATA_LEN 250
+#define ESP_NOW_MAX_TOTAL_PEER_NUM 20
+
+typedef struct {
+  uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+  uint8_t lmk[ESP_NOW_KEY_LEN];
+  uint8_t channel;
+  wifi_interface_t ifidx;
+  bool encrypt;
+  void* priv;
+} esp_now_peer_info_t;
+
+typedef enum {
+  ESP_NOW_SEND_SUCCESS = 0,
+  ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t* mac_addr, const uint8_t* data, int data_len);
+typedef void (*esp_now_send_cb_t)(const uint8_t* mac_addr, esp_now_send_status_t status);
+
+esp_err_t esp_now_init();
+esp_err_t esp_now_deinit();
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer);
+esp_err_t esp_now_del_peer(const uint8_t* peer_addr);
+bool esp_now_is_peer_exist(const uint8_t* peer_addr);
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len);
+
+#endif // SIM_ESP_NOW_H
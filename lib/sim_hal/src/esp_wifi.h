@@ -0,0 +1,16 @@
+#ifndef SIM_ESP_WIFI_H
+#define SIM_ESP_WIFI_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// --- ESP-IDF Wi-Fi driver (simulator) ---
+// Only what ESP-NOW needs: the station interface's MAC and its channel.
+// The station MAC is the device's address, as the BLE radio reports it.
+typedef enum { WIFI_IF_STA = 0, WIFI_IF_AP = 1 } wifi_interface_t;
+typedef enum { WIFI_SECOND_CHAN_NONE = 0, WIFI_SECOND_CHAN_ABOVE, WIFI_SECOND_CHAN_BELOW } wifi_second_chan_t;
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second);
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+
+#endif // SIM_ESP_WIFI_H
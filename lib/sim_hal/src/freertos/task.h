@@ -0,0 +1,23 @@
+#ifndef SIM_FREERTOS_TASK_H
+#define SIM_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+// stackDepth is in bytes, as in ESP-IDF. Priority and core are ignored.
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void taskYIELD();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TaskHandle_t xTaskGetHandle(const char* name);
+// Bytes of the task's stack never used, scaled back to device bytes.
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif // SIM_FREERTOS_TASK_H
@@ -0,0 +1,220 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+#include "sim_device.h"
+
+HardwareSerial Serial;
+
+// --- Time ---
+uint32_t millis() {
+  return (uint32_t)(simDeviceUs() / 1000);
+}
+
+uint32_t micros() {
+  return (uint32_t)simDeviceUs();
+}
+
+void delay(uint32_t ms) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void yield() {
+  simYield();
+}
+
+// --- GPIO ---
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  if (simCurrent != nullptr && pin == SIM_TOUCH_INT_PIN) simCurrent->touchIsr = isr;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (simCurrent != nullptr && pin == SIM_TOUCH_INT_PIN) simCurrent->touchIsr = nullptr;
+}
+
+// --- Serial ---
+static bool serialEcho = true;
+static uint64_t serialDigest = 0xcbf29ce484222325ull;  // FNV-1a offset basis
+
+void simSetSerialEcho(bool echo) {
+  serialEcho = echo;
+}
+
+uint64_t simSerialDigest() {
+  return serialDigest;
+}
+
+static void digestBytes(const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  for (size_t i = 0; i < len; i++) {
+    serialDigest ^= p[i];
+    serialDigest *= 0x100000001b3ull;
+  }
+}
+
+void simSerialWrite(const char* data, size_t len) {
+  if (simCurrent == nullptr) {
+    fwrite(data, 1, len, stdout);
+    return;
+  }
+  for (size_t i = 0; i < len; i++) {
+    char c = data[i];
+    if (c == '\r') continue;
+    if (c != '\n') {
+      simCurrent->serialOut += c;
+      continue;
+    }
+    uint64_t now = simNowUs();
+    digestBytes(&now, sizeof(now));
+    digestBytes(&simCurrent->index, sizeof(simCurrent->index));
+    digestBytes(simCurrent->serialOut.data(), simCurrent->serialOut.size());
+    if (serialEcho) {
+      printf("[%5lu.%03lu] %-8s| %s\n", (unsigned long)(now / 1000000), (unsigned long)(now / 1000 % 1000),
+             simCurrent->label, simCurrent->serialOut.c_str());
+    }
+    simCurrent->serialOut.clear();
+  }
+}
+
+int HardwareSerial::available() {
+  return simCurrent != nullptr ? (int)simCurrent->serialIn.size() : 0;
+}
+
+int HardwareSerial::read() {
+  if (simCurrent == nullptr || simCurrent->serialIn.empty()) return -1;
+  int c = (uint8_t)simCurrent->serialIn[0];
+  simCurrent->serialIn.erase(0, 1);
+  return c;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  simSerialWrite((const char*)&c, 1);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+  simSerialWrite((const char*)data, len);
+  return len;
+}
+
+size_t HardwareSerial::print(const char* text) {
+  size_t len = strlen(text);
+  simSerialWrite(text, len);
+  return len;
+}
+
+size_t HardwareSerial::print(char c) {
+  simSerialWrite(&c, 1);
+  return 1;
+}
+
+size_t HardwareSerial::print(int value) {
+  return printf("%d", value);
+}
+
+size_t HardwareSerial::print(unsigned int value) {
+  return printf("%u", value);
+}
+
+size_t HardwareSerial::print(long value) {
+  return printf("%ld", value);
+}
+
+size_t HardwareSerial::print(unsigned long value) {
+  return printf("%lu", value);
+}
+
+size_t HardwareSerial::println() {
+  return print("\n");
+}
+
+size_t HardwareSerial::println(const char* text) {
+  return print(text) + println();
+}
+
+size_t HardwareSerial::println(int value) {
+  return print(value) + println();
+}
+
+size_t HardwareSerial::println(unsigned int value) {
+  return print(value) + println();
+}
+
+size_t HardwareSerial::println(long value) {
+  return print(value) + println();
+}
+
+size_t HardwareSerial::println(unsigned long value) {
+  return print(value) + println();
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  if ((size_t)len >= sizeof(buf)) len = sizeof(buf) - 1;  // truncated, as with a small device buffer
+  simSerialWrite(buf, len);
+  return len;
+}
+
+// --- Heap ---
+// A Core2 after Bluedroid is up: about 180 KB of internal RAM and 4 MB of
+// PSRAM free. The model has no fragmentation, so the largest free block
+// is all of the free space.
+static const size_t heapBudget[2] = { 180 * 1024, 4 * 1024 * 1024 };
+
+struct SimHeapBlock {
+  size_t size;
+  int pool;
+  SimDevice* device;
+  max_align_t align;
+};
+
+static int heapPool(uint32_t caps) {
+  return (caps & MALLOC_CAP_SPIRAM) ? 1 : 0;
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+  int pool = heapPool(caps);
+  SimDevice* d = simCurrent;
+  if (d != nullptr && d->heapUsed[pool] + size > heapBudget[pool]) return nullptr;
+  SimHeapBlock* block = (SimHeapBlock*)malloc(offsetof(SimHeapBlock, align) + size);
+  if (block == nullptr) return nullptr;
+  block->size = size;
+  block->pool = pool;
+  block->device = d;
+  if (d != nullptr) {
+    d->heapUsed[pool] += size;
+    if (d->heapUsed[pool] > d->heapPeak[pool]) d->heapPeak[pool] = d->heapUsed[pool];
+  }
+  return &block->align;
+}
+
+void heap_caps_free(void* ptr) {
+  if (ptr == nullptr) return;
+  SimHeapBlock* block = (SimHeapBlock*)((uint8_t*)ptr - offsetof(SimHeapBlock, align));
+  if (block->device != nullptr) block->device->heapUsed[block->pool] -= block->size;
+  free(block);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+  int pool = heapPool(caps);
+  return heapBudget[pool] - (simCurrent != nullptr ? simCurrent->heapUsed[pool] : 0);
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+  int pool = heapPool(caps);
+  return heapBudget[pool] - (simCurrent != nullptr ? simCurrent->heapPeak[pool] : 0);
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+  return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps) {
+  return heapBudget[heapPool(caps)];
+}
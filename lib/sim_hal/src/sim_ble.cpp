@@ -0,0 +1,589 @@
+#include <BLEDevice.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_device.h"
+
+// --- Radio Timing ---
+// Round numbers in the range a Core2 pair shows over the air.
+static const uint64_t advertisingDelayUs = 40000;      // first advertisement heard after scan/advertise start
+static const uint32_t advertisingJitterUs = 5000;      // mean random delay added to each advertising interval
+static const uint32_t initialIntervalUs = 30000;       // Bluedroid's default connection interval
+static const uint32_t connectEvents = 2;               // connection setup, in intervals
+static const uint32_t discoveryEvents = 2;             // service discovery, in intervals
+static const uint32_t connectTimeoutMs = 2000;         // peer gone before the connect completed
+
+struct SimBleState {
+  std::string name;
+  BLEServer* server;
+  BLEClient* client;
+  BLEScan scan;
+  BLEAdvertising advertising;
+};
+
+struct SimBleLink {
+  SimDevice* central;
+  SimDevice* peripheral;
+  BLEClient* client;
+  BLEServer* server;
+  uint16_t connId;
+  bool connected;
+  uint64_t anchorUs;     // a connection event; the others follow every intervalUs
+  uint32_t intervalUs;
+};
+
+static std::vector<SimBleLink*> links;
+static uint16_t nextConnId = 0;
+static std::vector<BLECharacteristic*> characteristicHandles;  // handle - 1
+static esp_gatt_if_t nextGattsIf = 3;                            // Bluedroid's first app interface
+
+static SimBleState* bleState(SimDevice* d) {
+  if (d->ble == nullptr) {
+    d->ble = new SimBleState();
+    d->ble->server = nullptr;
+    d->ble->client = nullptr;
+  }
+  return d->ble;
+}
+
+static SimBleState* currentBle() {
+  if (simCurrent == nullptr) {
+    fprintf(stderr, "sim: BLE call outside a device\n");
+    abort();
+  }
+  return bleState(simCurrent);
+}
+
+// The first connection event strictly after now.
+static uint64_t nextConnectionEvent(const SimBleLink* link, uint64_t now) {
+  if (now < link->anchorUs) return link->anchorUs;
+  return link->anchorUs + ((now - link->anchorUs) / link->intervalUs + 1) * link->intervalUs;
+}
+
+// Blocks the calling task for count connection intervals.
+static void waitEvents(uint32_t intervalUs, uint32_t count) {
+  simBlock(nullptr, simNowUs() + (uint64_t)intervalUs * count);
+}
+
+// --- UUIDs and Addresses ---
+BLEUUID::BLEUUID(const char* uuid) : value(uuid) {
+  for (size_t i = 0; i < value.size(); i++) value[i] = (char)tolower((unsigned char)value[i]);
+}
+
+BLEUUID::BLEUUID(const std::string& uuid) : BLEUUID(uuid.c_str()) {}
+
+// The UUID's 32 hex digits, last first, as 16 bytes.
+void BLEAdvertisementData::setCompleteServices(const BLEUUID& uuid) {
+  std::string digits;
+  std::string text = uuid.toString();
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] != '-') digits += text[i];
+  }
+  std::string bytes;
+  for (size_t i = digits.size(); i >= 2; i -= 2) {
+    bytes += (char)strtoul(digits.substr(i - 2, 2).c_str(), nullptr, 16);
+  }
+  addStructure(0x07, bytes);
+}
+
+// Back from the 16 bytes to the text form, 8-4-4-4-12 digits.
+static BLEUUID uuidFromField(const std::string& bytes) {
+  std::string text;
+  for (size_t i = bytes.size(); i > 0; i--) {
+    char hex[3];
+    snprintf(hex, sizeof(hex), "%02x", (uint8_t)bytes[i - 1]);
+    text += hex;
+    size_t n = bytes.size() - i + 1;
+    if (n == 4 || n == 6 || n == 8 || n == 10) text += '-';
+  }
+  return BLEUUID(text);
+}
+
+BLEAddress::BLEAddress(esp_bd_addr_t address) {
+  memcpy(native, address, sizeof(native));
+}
+
+BLEAddress::BLEAddress(const std::string& address) {
+  unsigned int b[6] = { 0 };
+  sscanf(address.c_str(), "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]);
+  for (int i = 0; i < 6; i++) native[i] = (uint8_t)b[i];
+}
+
+bool BLEAddress::equals(const BLEAddress& other) const {
+  return memcmp(native, other.native, sizeof(native)) == 0;
+}
+
+std::string BLEAddress::toString() const {
+  char text[18];
+  snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x",
+           native[0], native[1], native[2], native[3], native[4], native[5]);
+  return text;
+}
+
+// --- Links ---
+struct SimLinkEvent {
+  SimBleLink* link;
+  esp_ble_gatts_cb_param_t param;
+};
+
+static void onServerConnect(void* arg) {
+  SimLinkEvent* e = (SimLinkEvent*)arg;
+  BLEServerCallbacks* callbacks = e->link->server->callbacks;
+  if (callbacks != nullptr) {
+    callbacks->onConnect(e->link->server);
+    callbacks->onConnect(e->link->server, &e->param);
+  }
+  delete e;
+}
+
+static void onServerDisconnect(void* arg) {
+  SimLinkEvent* e = (SimLinkEvent*)arg;
+  BLEServerCallbacks* callbacks = e->link->server->callbacks;
+  if (callbacks != nullptr) {
+    callbacks->onDisconnect(e->link->server);
+    callbacks->onDisconnect(e->link->server, &e->param);
+  }
+  delete e;
+}
+
+static void onClientConnect(void* arg) {
+  SimBleLink* link = (SimBleLink*)arg;
+  if (link->client->callbacks != nullptr) link->client->callbacks->onConnect(link->client);
+}
+
+static void onClientDisconnect(void* arg) {
+  SimBleLink* link = (SimBleLink*)arg;
+  if (link->client->callbacks != nullptr) link->client->callbacks->onDisconnect(link->client);
+}
+
+static void closeLink(SimBleLink* link) {
+  if (!link->connected) return;
+  link->connected = false;
+  if (link->client->link == link) link->client->link = nullptr;
+  uint64_t now = simNowUs();
+  SimLinkEvent* e = new SimLinkEvent();
+  e->link = link;
+  memset(&e->param, 0, sizeof(e->param));
+  e->param.disconnect.conn_id = link->connId;
+  memcpy(e->param.disconnect.remote_bda, link->central->mac, sizeof(esp_bd_addr_t));
+  simPost(link->peripheral, now, onServerDisconnect, e);
+  simPost(link->central, now, onClientDisconnect, link);
+}
+
+void simBleDisconnect(int device) {
+  SimDevice* d = simDevice(device);
+  for (size_t i = 0; i < links.size(); i++) {
+    if (links[i]->central == d || links[i]->peripheral == d) closeLink(links[i]);
+  }
+}
+
+// --- Data Packets ---
+struct SimPacket {
+  SimBleLink* link;
+  BLECharacteristic* characteristic;       // write: server side
+  BLERemoteCharacteristic* remote;         // notification: client side
+  std::string data;
+};
+
+static void deliverWrite(void* arg) {
+  SimPacket* p = (SimPacket*)arg;
+  if (p->link->connected) {
+    p->characteristic->simWritten((const uint8_t*)p->data.data(), p->data.size(), p->link);
+  }
+  delete p;
+}
+
+static void deliverNotify(void* arg) {
+  SimPacket* p = (SimPacket*)arg;
+  if (p->link->connected && p->remote->onNotify != nullptr) {
+    p->remote->onNotify(p->remote, (uint8_t*)&p->data[0], p->data.size(), true);
+  }
+  delete p;
+}
+
+// --- Server Side ---
+BLECharacteristic::BLECharacteristic(const BLEUUID& uuid, uint32_t properties, BLEService* service)
+    : uuid(uuid), properties(properties), service(service), callbacks(nullptr) {
+  characteristicHandles.push_back(this);
+  handle = (uint16_t)characteristicHandles.size();
+}
+
+void BLECharacteristic::setValue(uint8_t* data, size_t len) {
+  value.assign((const char*)data, len);
+}
+
+void BLECharacteristic::setValue(const std::string& value) {
+  this->value = value;
+}
+
+// Queues data for the client's copy of c on link's next connection event.
+static void notifyLink(BLECharacteristic* c, BLERemoteCharacteristic* remote, SimBleLink* link,
+                       const std::string& data) {
+  SimPacket* p = new SimPacket();
+  p->link = link;
+  p->characteristic = c;
+  p->remote = remote;
+  p->data = data;
+  simPost(link->central, nextConnectionEvent(link, simNowUs()), deliverNotify, p);
+}
+
+void BLECharacteristic::notify(bool isNotification) {
+  for (size_t i = 0; i < subscribers.size(); i++) {
+    SimBleLink* link = subscribers[i]->client->link;
+    if (link == nullptr || !link->connected || link->server != service->getServer()) continue;
+    notifyLink(this, subscribers[i], link, value);
+  }
+}
+
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                      uint16_t value_len, uint8_t* value, bool need_confirm) {
+  if (attr_handle == 0 || attr_handle > characteristicHandles.size()) return ESP_ERR_INVALID_ARG;
+  BLECharacteristic* c = characteristicHandles[attr_handle - 1];
+  BLEServer* server = c->getService()->getServer();
+  if (server->getGattsIf() != gatts_if) return ESP_ERR_INVALID_ARG;
+  for (size_t i = 0; i < links.size(); i++) {
+    SimBleLink* link = links[i];
+    if (link->server != server || link->connId != conn_id || !link->connected) continue;
+    // Only a client that registered for it has a callback to run.
+    for (size_t s = 0; s < c->subscribers.size(); s++) {
+      if (c->subscribers[s]->client->link == link) {
+        notifyLink(c, c->subscribers[s], link, std::string((const char*)value, value_len));
+      }
+    }
+    return ESP_OK;
+  }
+  return ESP_FAIL;
+}
+
+void BLECharacteristic::simWritten(const uint8_t* data, size_t len, SimBleLink* link) {
+  value.assign((const char*)data, len);
+  if (callbacks == nullptr) return;
+  esp_ble_gatts_cb_param_t param;
+  memset(&param, 0, sizeof(param));
+  param.write.conn_id = link->connId;
+  memcpy(param.write.bda, link->central->mac, sizeof(esp_bd_addr_t));
+  callbacks->onWrite(this, &param);
+}
+
+BLECharacteristic* BLEService::createCharacteristic(const char* uuid, uint32_t properties) {
+  BLECharacteristic* c = new BLECharacteristic(BLEUUID(uuid), properties, this);
+  characteristics.push_back(c);
+  return c;
+}
+
+BLECharacteristic* BLEService::getCharacteristic(const BLEUUID& uuid) {
+  for (size_t i = 0; i < characteristics.size(); i++) {
+    if (characteristics[i]->getUUID().equals(uuid)) return characteristics[i];
+  }
+  return nullptr;
+}
+
+BLEServer::BLEServer() : callbacks(nullptr), gattsIf(nextGattsIf++) {}
+
+BLEService* BLEServer::createService(const char* uuid) {
+  BLEService* s = new BLEService(BLEUUID(uuid), this);
+  services.push_back(s);
+  return s;
+}
+
+BLEService* BLEServer::getServiceByUUID(const BLEUUID& uuid) {
+  for (size_t i = 0; i < services.size(); i++) {
+    if (services[i]->getUUID().equals(uuid)) return services[i];
+  }
+  return nullptr;
+}
+
+uint32_t BLEServer::getConnectedCount() {
+  uint32_t count = 0;
+  for (size_t i = 0; i < links.size(); i++) {
+    if (links[i]->server == this && links[i]->connected) count++;
+  }
+  return count;
+}
+
+void BLEServer::updateConnParams(esp_bd_addr_t remote, uint16_t minInterval, uint16_t maxInterval,
+                                 uint16_t latency, uint16_t timeout) {
+  uint64_t now = simNowUs();
+  for (size_t i = 0; i < links.size(); i++) {
+    SimBleLink* link = links[i];
+    if (link->server != this || !link->connected ||
+        memcmp(link->central->mac, remote, sizeof(esp_bd_addr_t)) != 0) {
+      continue;
+    }
+    // The central settles on the low end of the requested range from the
+    // next connection event on.
+    link->anchorUs = nextConnectionEvent(link, now);
+    link->intervalUs = (uint32_t)minInterval * 1250;
+  }
+}
+
+void BLEServer::disconnect(uint16_t connId) {
+  for (size_t i = 0; i < links.size(); i++) {
+    if (links[i]->server == this && links[i]->connId == connId) closeLink(links[i]);
+  }
+}
+
+void BLEAdvertising::start() {
+  if (active) return;
+  active = true;
+  startUs = simNowUs();
+}
+
+void BLEAdvertising::stop() {
+  active = false;
+}
+
+// --- Scanning ---
+bool BLEAdvertisedDevice::isAdvertisingService(const BLEUUID& uuid) {
+  for (size_t i = 0; i < serviceUUIDs.size(); i++) {
+    if (serviceUUIDs[i].equals(uuid)) return true;
+  }
+  return false;
+}
+
+bool BLEScan::start(uint32_t duration, void (*onComplete)(BLEScanResults), bool continuePrevious) {
+  if (!continuePrevious) clearResults();
+  scanning = true;
+  startUs = simNowUs();
+  endUs = duration > 0 ? startUs + (uint64_t)duration * 1000000 : 0;
+  this->onComplete = onComplete;
+  return true;
+}
+
+void BLEScan::stop() {
+  scanning = false;
+}
+
+void BLEScan::clearResults() {
+  seen.clear();
+  seenUs.clear();
+}
+
+static int seenIndex(const BLEScan& scan, const std::string& address) {
+  for (size_t i = 0; i < scan.seen.size(); i++) {
+    if (scan.seen[i] == address) return (int)i;
+  }
+  return -1;
+}
+
+// When device d's advertisement is next heard by a scan, or UINT64_MAX: the
+// first time a while after the later of scan and advertising start, then,
+// for a scan that wants duplicates, at each advertising event after the
+// last one reported.
+static uint64_t heardAtUs(const BLEScan& scan, SimDevice* d) {
+  if (d->ble == nullptr || !d->ble->advertising.active) return UINT64_MAX;
+  const BLEAdvertising& adv = d->ble->advertising;
+  int i = seenIndex(scan, BLEAddress(d->mac).toString());
+  if (i < 0) {
+    uint64_t from = scan.startUs > adv.startUs ? scan.startUs : adv.startUs;
+    return from + advertisingDelayUs;
+  }
+  if (!scan.wantDuplicates) return UINT64_MAX;
+  uint64_t intervalUs = (uint64_t)adv.intervalUnits * 625 + advertisingJitterUs;
+  uint64_t last = scan.seenUs[i] > adv.startUs ? scan.seenUs[i] : adv.startUs;
+  return adv.startUs + ((last - adv.startUs) / intervalUs + 1) * intervalUs;
+}
+
+// The value of the first AD structure of a type in raw advertising data.
+static std::string adField(const std::string& payload, uint8_t type) {
+  size_t i = 0;
+  while (i + 1 < payload.size()) {
+    size_t len = (uint8_t)payload[i];
+    if (len == 0 || i + 1 + len > payload.size()) break;
+    if ((uint8_t)payload[i + 1] == type) return payload.substr(i + 2, len - 1);
+    i += 1 + len;
+  }
+  return std::string();
+}
+
+void simBlePoll(SimDevice* device, uint64_t nowUs) {
+  if (device->ble == nullptr) return;
+  BLEScan& scan = device->ble->scan;
+  for (int i = 0; i < simDeviceCount() && scan.scanning; i++) {
+    SimDevice* other = simDevice(i);
+    if (other == device || heardAtUs(scan, other) > nowUs) continue;
+    std::string address = BLEAddress(other->mac).toString();
+    int seen = seenIndex(scan, address);
+    if (seen < 0) {
+      scan.seen.push_back(address);
+      scan.seenUs.push_back(nowUs);
+    } else {
+      scan.seenUs[seen] = nowUs;  // events missed while the device was busy are not reported
+    }
+    if (scan.callbacks == nullptr) continue;
+    const BLEAdvertising& adv = other->ble->advertising;
+    BLEAdvertisedDevice found(BLEAddress(other->mac));
+    if (adv.customData) {
+      found.name = adField(adv.payload, 0x09);
+      found.manufacturerData = adField(adv.payload, 0xFF);
+      std::string service = adField(adv.payload, 0x07);
+      if (service.size() == 16) found.serviceUUIDs.push_back(uuidFromField(service));
+    } else {
+      found.serviceUUIDs = adv.serviceUUIDs;
+      found.name = other->ble->name;
+    }
+    simCurrent = device;
+    scan.callbacks->onResult(found);
+    simCurrent = nullptr;
+  }
+  if (scan.scanning && scan.endUs != 0 && nowUs >= scan.endUs) {
+    scan.scanning = false;
+    if (scan.onComplete != nullptr) {
+      BLEScanResults results;
+      results.count = (int)scan.seen.size();
+      simCurrent = device;
+      scan.onComplete(results);
+      simCurrent = nullptr;
+    }
+  }
+}
+
+uint64_t simBleNextUs(SimDevice* device) {
+  if (device->ble == nullptr || !device->ble->scan.scanning) return UINT64_MAX;
+  const BLEScan& scan = device->ble->scan;
+  uint64_t next = scan.endUs != 0 ? scan.endUs : UINT64_MAX;
+  for (int i = 0; i < simDeviceCount(); i++) {
+    SimDevice* other = simDevice(i);
+    if (other == device) continue;
+    uint64_t heard = heardAtUs(scan, other);
+    if (heard < next) next = heard;
+  }
+  return next;
+}
+
+// --- Client Side ---
+bool BLEClient::connect(BLEAddress address, esp_ble_addr_type_t type) {
+  if (isConnected()) return true;
+  SimDevice* central = simCurrent;
+  SimDevice* peripheral = nullptr;
+  for (int i = 0; i < simDeviceCount(); i++) {
+    SimDevice* d = simDevice(i);
+    if (d != central && BLEAddress(d->mac).equals(address)) peripheral = d;
+  }
+  waitEvents(initialIntervalUs, connectEvents);
+  if (peripheral == nullptr || peripheral->ble == nullptr || peripheral->ble->server == nullptr ||
+      !peripheral->ble->advertising.active || !peripheral->ble->advertising.connectable) {
+    simBlock(nullptr, simNowUs() + (uint64_t)connectTimeoutMs * 1000);
+    return false;
+  }
+  // A connected peripheral stops advertising until it is restarted.
+  peripheral->ble->advertising.active = false;
+
+  SimBleLink* link = new SimBleLink();
+  link->central = central;
+  link->peripheral = peripheral;
+  link->client = this;
+  link->server = peripheral->ble->server;
+  link->connId = nextConnId++;
+  link->connected = true;
+  link->anchorUs = simNowUs();
+  link->intervalUs = initialIntervalUs;
+  links.push_back(link);
+  this->link = link;
+  services.clear();
+
+  SimLinkEvent* e = new SimLinkEvent();
+  e->link = link;
+  memset(&e->param, 0, sizeof(e->param));
+  e->param.connect.conn_id = link->connId;
+  memcpy(e->param.connect.remote_bda, central->mac, sizeof(esp_bd_addr_t));
+  simPost(peripheral, link->anchorUs, onServerConnect, e);
+  simPost(central, link->anchorUs, onClientConnect, link);
+  return true;
+}
+
+void BLEClient::disconnect() {
+  if (link != nullptr) closeLink(link);
+}
+
+bool BLEClient::isConnected() {
+  return link != nullptr && link->connected;
+}
+
+BLERemoteService* BLEClient::getService(const BLEUUID& uuid) {
+  if (!isConnected()) return nullptr;
+  waitEvents(link->intervalUs, discoveryEvents);
+  if (!isConnected()) return nullptr;
+  BLEService* target = link->server->getServiceByUUID(uuid);
+  if (target == nullptr) return nullptr;
+  BLERemoteService* remote = new BLERemoteService(target, this);
+  services.push_back(remote);
+  return remote;
+}
+
+BLERemoteCharacteristic* BLERemoteService::getCharacteristic(const BLEUUID& uuid) {
+  for (size_t i = 0; i < characteristics.size(); i++) {
+    if (characteristics[i]->getUUID().equals(uuid)) return characteristics[i];
+  }
+  BLECharacteristic* found = target->getCharacteristic(uuid);
+  if (found == nullptr) return nullptr;
+  BLERemoteCharacteristic* remote = new BLERemoteCharacteristic(found, client);
+  characteristics.push_back(remote);
+  return remote;
+}
+
+void BLERemoteCharacteristic::registerForNotify(notify_callback callback, bool notifications,
+                                                bool descriptorRequiresRegistration) {
+  onNotify = callback;
+  std::vector<BLERemoteCharacteristic*>& subs = target->subscribers;
+  for (size_t i = 0; i < subs.size(); i++) {
+    if (subs[i] == this) {
+      if (callback == nullptr) subs.erase(subs.begin() + i);
+      return;
+    }
+  }
+  if (callback != nullptr) subs.push_back(this);
+}
+
+void BLERemoteCharacteristic::writeValue(uint8_t* data, size_t length, bool response) {
+  SimBleLink* link = client->link;
+  if (link == nullptr || !link->connected) return;
+  SimPacket* p = new SimPacket();
+  p->link = link;
+  p->characteristic = target;
+  p->remote = this;
+  p->data.assign((const char*)data, length);
+  simPost(link->peripheral, nextConnectionEvent(link, simNowUs()), deliverWrite, p);
+}
+
+void BLERemoteCharacteristic::writeValue(const std::string& value, bool response) {
+  writeValue((uint8_t*)value.data(), value.size(), response);
+}
+
+// --- BLEDevice ---
+void BLEDevice::init(const std::string& deviceName) {
+  currentBle()->name = deviceName;
+}
+
+BLEServer* BLEDevice::createServer() {
+  SimBleState* ble = currentBle();
+  if (ble->server == nullptr) ble->server = new BLEServer();
+  return ble->server;
+}
+
+BLEClient* BLEDevice::createClient() {
+  SimBleState* ble = currentBle();
+  ble->client = new BLEClient();
+  return ble->client;
+}
+
+BLEScan* BLEDevice::getScan() {
+  return &currentBle()->scan;
+}
+
+BLEAdvertising* BLEDevice::getAdvertising() {
+  return &currentBle()->advertising;
+}
+
+void BLEDevice::startAdvertising() {
+  getAdvertising()->start();
+}
+
+void BLEDevice::stopAdvertising() {
+  getAdvertising()->stop();
+}
+
+BLEAddress BLEDevice::getAddress() {
+  return BLEAddress(simCurrent->mac);
+}
@@ -0,0 +1,130 @@
+#ifndef SIM_DEVICE_H
+#define SIM_DEVICE_H
+
+#include <stdint.h>
+#include <string>
+#include <ucontext.h>
+#include "sim_hal.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// --- Simulator Internals ---
+// Shared by the HAL translation units; the firmware never includes this.
+enum SimTaskState { SIM_TASK_READY, SIM_TASK_BLOCKED, SIM_TASK_DELETED };
+
+struct SimDevice;
+
+struct SimTask {
+  SimDevice* device;
+  char name[16];
+  TaskFunction_t fn;
+  void* arg;
+  ucontext_t context;
+  uint8_t* stack;
+  size_t stackSize;
+  SimTaskState state;
+  uint64_t wakeUs;              // blocked: resume at this time at the latest
+  const void* waitObject;       // blocked: resume early when this is signalled
+};
+
+struct SimSurfaceText {
+  int x, y;
+  std::string text;
+};
+
+// A drawing target: its pixels, the text drawn on it (for the harness)
+// and counts.
+struct SimSurface {
+  int width, height;
+  uint16_t* pixels;             // RGB565, row-major
+  bool swapped;                 // pixels held byte-swapped, as in a LovyanGFX sprite
+  int writeDepth;               // startWrite() nesting
+  uint64_t pixelWrites;
+  uint32_t drawCalls;
+  uint64_t frameStartWrites;    // pixelWrites when the current frame began
+  SimFrameStats frames;
+  SimSurfaceText texts[32];
+  int textCount;
+};
+
+struct SimBleState;
+struct SimLinkState;
+struct SimEspNowState;
+
+struct SimDevice {
+  int index;
+  char label[16];
+  SimFirmware firmware;
+  uint64_t bootUs;              // sim time of power-up; millis() counts from here
+  bool booted;
+  SimTask* tasks[SIM_MAX_TASKS];
+  int taskCount;
+
+  // Arduino core
+  void (*touchIsr)();
+  size_t heapUsed[2];           // heap_caps_malloc bytes: internal, PSRAM
+  size_t heapPeak[2];
+  std::string serialIn;
+  std::string serialOut;        // current unfinished output line
+
+  // M5Unified
+  bool touchDown;
+  int touchX, touchY;
+  uint64_t touchReleaseUs;
+  bool touchLatched;            // state at the last M5.update()
+  int touchLatchedX, touchLatchedY;
+  SimSurface panel;
+  uint16_t panelPixels[SIM_PANEL_WIDTH * SIM_PANEL_HEIGHT];
+
+  SimBleState* ble;
+  SimLinkState* link;           // host frame link, if the harness set one
+  SimEspNowState* espnow;
+  uint8_t mac[6];
+};
+
+// The device (and task) whose code is running; nullptr for the harness.
+extern SimDevice* simCurrent;
+extern SimTask* simCurrentTask;
+
+SimDevice* simDevice(int index);
+int simDeviceCount();
+
+// False when the real clock paces the run.
+bool simClockIsVirtual();
+
+// Microseconds since the running device powered up.
+uint64_t simDeviceUs();
+
+// Blocks the running task until waitObject is signalled or wakeUs.
+void simBlock(const void* waitObject, uint64_t wakeUs);
+// Wakes every task of the device blocked on waitObject.
+void simSignal(SimDevice* device, const void* waitObject);
+// Lets the other ready tasks run before the running one continues.
+void simYield();
+
+// Runs fn as device's BLE callback task at dueUs (sim time). Events due at
+// the same time run in the order they were posted.
+typedef void (*SimEventFn)(void* arg);
+void simPost(SimDevice* device, uint64_t dueUs, SimEventFn fn, void* arg);
+
+// Pushes the running device's serial output line to stdout.
+void simSerialWrite(const char* data, size_t len);
+
+// Per-device BLE upkeep run by the scheduler (scan results, scan windows).
+void simBlePoll(SimDevice* device, uint64_t nowUs);
+// Earliest time simBlePoll has work to do, or UINT64_MAX.
+uint64_t simBleNextUs(SimDevice* device);
+
+// Sets surface up to draw on pixels (width * height, cleared to black).
+// Host link upkeep run by the scheduler (accepting, connecting, reading).
+void simLinkPoll(SimDevice* device, uint64_t nowUs);
+// Earliest time simLinkPoll has a timed step to do, or UINT64_MAX.
+uint64_t simLinkNextUs(SimDevice* device);
+// Real clock: sleeps for up to timeoutUs, waking early if a link has input.
+void simLinkWait(uint64_t timeoutUs);
+
+void simSurfaceInit(SimSurface* surface, int width, int height, uint16_t* pixels, bool swapped);
+// RGB565 colour of a pixel, whichever byte order the surface keeps.
+uint16_t simSurfacePixel(const SimSurface* surface, int x, int y);
+
+#endif // SIM_DEVICE_H
@@ -0,0 +1,349 @@
+#include <M5Unified.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+#include "sim_device.h"
+
+m5::M5Unified M5;
+
+static SimFrameHook frameHook = nullptr;
+
+// --- Surfaces ---
+void simSurfaceInit(SimSurface* surface, int width, int height, uint16_t* pixels, bool swapped) {
+  surface->width = width;
+  surface->height = height;
+  surface->pixels = pixels;
+  surface->swapped = swapped;
+  surface->writeDepth = 0;
+  surface->pixelWrites = 0;
+  surface->drawCalls = 0;
+  surface->frameStartWrites = 0;
+  memset(&surface->frames, 0, sizeof(surface->frames));
+  surface->textCount = 0;
+  if (pixels != nullptr) memset(pixels, 0, (size_t)width * height * sizeof(uint16_t));
+}
+
+static uint16_t swap16(uint16_t v) {
+  return (uint16_t)((v >> 8) | (v << 8));
+}
+
+uint16_t simSurfacePixel(const SimSurface* s, int x, int y) {
+  uint16_t v = s->pixels[y * s->width + x];
+  return s->swapped ? swap16(v) : v;
+}
+
+static void clipRect(const SimSurface* s, int32_t& x, int32_t& y, int32_t& w, int32_t& h) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > s->width) w = s->width - x;
+  if (y + h > s->height) h = s->height - y;
+  if (w < 0) w = 0;
+  if (h < 0) h = 0;
+}
+
+// Fills a rectangle already clipped to the surface.
+static void fillClipped(SimSurface* s, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
+  if (s->pixels == nullptr) return;
+  uint16_t v = s->swapped ? swap16(color) : color;
+  for (int32_t row = y; row < y + h; row++) {
+    uint16_t* p = s->pixels + row * s->width + x;
+    for (int32_t i = 0; i < w; i++) p[i] = v;
+  }
+  s->pixelWrites += (uint64_t)w * h;
+}
+
+static void fillArea(SimSurface* s, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
+  clipRect(s, x, y, w, h);
+  fillClipped(s, x, y, w, h, color);
+}
+
+static void endFrame(SimSurface* s) {
+  uint64_t pixels = s->pixelWrites - s->frameStartWrites;
+  s->frameStartWrites = s->pixelWrites;
+  if (pixels == 0) return;
+  s->frames.frames++;
+  s->frames.lastPixels = pixels;
+  if (pixels > s->frames.maxPixels) s->frames.maxPixels = pixels;
+  s->frames.totalPixels += pixels;
+  if (frameHook != nullptr && simCurrent != nullptr && s == &simCurrent->panel) frameHook(simCurrent->index);
+}
+
+SimFrameStats simFrameStats(int device) {
+  SimDevice* d = simDevice(device);
+  SimFrameStats none = { 0, 0, 0, 0 };
+  return d != nullptr ? d->panel.frames : none;
+}
+
+void simSetFrameHook(SimFrameHook hook) {
+  frameHook = hook;
+}
+
+// Text whose anchor is painted over is gone.
+static void eraseText(SimSurface* s, int32_t x, int32_t y, int32_t w, int32_t h) {
+  int kept = 0;
+  for (int i = 0; i < s->textCount; i++) {
+    const SimSurfaceText& t = s->texts[i];
+    bool covered = t.x >= x && t.x < x + w && t.y >= y && t.y < y + h;
+    if (!covered) s->texts[kept++] = s->texts[i];
+  }
+  s->textCount = kept;
+}
+
+static void addText(SimSurface* s, const char* text, int32_t x, int32_t y) {
+  eraseText(s, x, y, 1, 1);
+  if (s->textCount == (int)(sizeof(s->texts) / sizeof(s->texts[0]))) {
+    for (int i = 1; i < s->textCount; i++) s->texts[i - 1] = s->texts[i];  // drop the oldest
+    s->textCount--;
+  }
+  SimSurfaceText& t = s->texts[s->textCount++];
+  t.x = x;
+  t.y = y;
+  t.text = text;
+}
+
+bool simScreenHasText(int device, const char* text) {
+  SimDevice* d = simDevice(device);
+  if (d == nullptr) return false;
+  for (int i = 0; i < d->panel.textCount; i++) {
+    if (strstr(d->panel.texts[i].text.c_str(), text) != nullptr) return true;
+  }
+  return false;
+}
+
+// --- Text ---
+// Classic 5x7 glyphs for ' '..'~', one byte per column, bit 0 at the top.
+static const uint8_t glyphs[95][5] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 },
+  { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+  { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x08, 0x07, 0x03, 0x00 }, { 0x00, 0x1C, 0x22, 0x41, 0x00 },
+  { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x2A, 0x1C, 0x7F, 0x1C, 0x2A }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+  { 0x00, 0x80, 0x70, 0x30, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x00, 0x60, 0x60, 0x00 },
+  { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 },
+  { 0x72, 0x49, 0x49, 0x49, 0x46 }, { 0x21, 0x41, 0x49, 0x4D, 0x33 }, { 0x18, 0x14, 0x12, 0x7F, 0x10 },
+  { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x31 }, { 0x41, 0x21, 0x11, 0x09, 0x07 },
+  { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x46, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x00, 0x14, 0x00, 0x00 },
+  { 0x00, 0x40, 0x34, 0x00, 0x00 }, { 0x00, 0x08, 0x14, 0x22, 0x41 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+  { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x59, 0x09, 0x06 }, { 0x3E, 0x41, 0x5D, 0x59, 0x4E },
+  { 0x7C, 0x12, 0x11, 0x12, 0x7C }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+  { 0x7F, 0x41, 0x41, 0x41, 0x3E }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 },
+  { 0x3E, 0x41, 0x41, 0x51, 0x73 }, { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 },
+  { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, { 0x7F, 0x40, 0x40, 0x40, 0x40 },
+  { 0x7F, 0x02, 0x1C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+  { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 },
+  { 0x26, 0x49, 0x49, 0x49, 0x32 }, { 0x03, 0x01, 0x7F, 0x01, 0x03 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F },
+  { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F }, { 0x63, 0x14, 0x08, 0x14, 0x63 },
+  { 0x03, 0x04, 0x78, 0x04, 0x03 }, { 0x61, 0x59, 0x49, 0x4D, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x41 },
+  { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x41, 0x7F }, { 0x04, 0x02, 0x01, 0x02, 0x04 },
+  { 0x40, 0x40, 0x40, 0x40, 0x40 }, { 0x00, 0x03, 0x07, 0x08, 0x00 }, { 0x20, 0x54, 0x54, 0x78, 0x40 },
+  { 0x7F, 0x28, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x28 }, { 0x38, 0x44, 0x44, 0x28, 0x7F },
+  { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x00, 0x08, 0x7E, 0x09, 0x02 }, { 0x18, 0xA4, 0xA4, 0x9C, 0x78 },
+  { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x40, 0x3D, 0x00 },
+  { 0x7F, 0x10, 0x28, 0x44, 0x00 }, { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x78, 0x04, 0x78 },
+  { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0xFC, 0x18, 0x24, 0x24, 0x18 },
+  { 0x18, 0x24, 0x24, 0x18, 0xFC }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x24 },
+  { 0x04, 0x04, 0x3F, 0x44, 0x24 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C },
+  { 0x3C, 0x40, 0x30, 0x40, 0x3C }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x4C, 0x90, 0x90, 0x90, 0x7C },
+  { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x77, 0x00, 0x00 },
+  { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x02, 0x01, 0x02, 0x04, 0x02 },
+};
+
+// Glyph cell of the built-in fonts at text size 1.
+static void fontCell(uint8_t font, int32_t* w, int32_t* h) {
+  switch (font) {
+    case 4: *w = 14; *h = 26; break;
+    case 2: *w = 8; *h = 16; break;
+    default: *w = 6; *h = 8; break;
+  }
+}
+
+// Draws one glyph into its cell; each font pixel becomes a dx x dy block.
+static void drawGlyph(SimSurface* s, char c, int32_t x, int32_t y, int32_t cellW, int32_t cellH,
+                      int32_t dx, int32_t dy, uint16_t color) {
+  if (c < ' ' || c > '~') c = '?';
+  int32_t top = y + (cellH - 8 * dy) / 2;
+  for (int col = 0; col < 5; col++) {
+    uint8_t bits = glyphs[c - ' '][col];
+    for (int row = 0; row < 8; row++) {
+      if (bits & (1 << row)) fillArea(s, x + col * dx, top + row * dy, dx, dy, color);
+    }
+  }
+}
+
+// --- LovyanGFX ---
+namespace lgfx {
+
+SimSurface* LovyanGFX::surface() {
+  return simCurrent != nullptr ? &simCurrent->panel : nullptr;
+}
+
+int32_t LovyanGFX::width() {
+  SimSurface* s = surface();
+  return s != nullptr ? s->width : SIM_PANEL_WIDTH;
+}
+
+int32_t LovyanGFX::height() {
+  SimSurface* s = surface();
+  return s != nullptr ? s->height : SIM_PANEL_HEIGHT;
+}
+
+void LovyanGFX::startWrite() {
+  SimSurface* s = surface();
+  if (s != nullptr) s->writeDepth++;
+}
+
+void LovyanGFX::endWrite() {
+  SimSurface* s = surface();
+  if (s == nullptr || s->writeDepth == 0) return;
+  if (--s->writeDepth == 0) endFrame(s);
+}
+
+void LovyanGFX::fillScreen(uint32_t color) {
+  SimSurface* s = surface();
+  if (s == nullptr) return;
+  s->drawCalls++;
+  fillClipped(s, 0, 0, s->width, s->height, (uint16_t)color);
+  s->textCount = 0;
+}
+
+void LovyanGFX::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  SimSurface* s = surface();
+  if (s == nullptr) return;
+  clipRect(s, x, y, w, h);
+  s->drawCalls++;
+  fillClipped(s, x, y, w, h, (uint16_t)color);
+  eraseText(s, x, y, w, h);
+}
+
+void LovyanGFX::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  SimSurface* s = surface();
+  if (s == nullptr || w <= 0 || h <= 0) return;
+  s->drawCalls++;
+  fillArea(s, x, y, w, 1, (uint16_t)color);
+  if (h > 1) fillArea(s, x, y + h - 1, w, 1, (uint16_t)color);
+  if (h > 2) {
+    fillArea(s, x, y + 1, 1, h - 2, (uint16_t)color);
+    if (w > 1) fillArea(s, x + w - 1, y + 1, 1, h - 2, (uint16_t)color);
+  }
+}
+
+void LovyanGFX::drawString(const char* text, int32_t x, int32_t y, uint8_t font) {
+  SimSurface* s = surface();
+  if (s == nullptr) return;
+  int32_t cw, ch;
+  fontCell(font, &cw, &ch);
+  int32_t scale = textSize >= 1 ? (int32_t)textSize : 1;
+  cw *= scale;
+  ch *= scale;
+  int32_t dx = cw / 6 > 0 ? cw / 6 : 1;
+  int32_t dy = ch / 8 > 0 ? ch / 8 : 1;
+  s->drawCalls++;
+  if (textBackground != textColor) {
+    fillArea(s, x, y, (int32_t)strlen(text) * cw, ch, (uint16_t)textBackground);
+  }
+  for (const char* c = text; *c != '\0'; c++) {
+    drawGlyph(s, *c, x + (int32_t)(c - text) * cw, y, cw, ch, dx, dy, (uint16_t)textColor);
+  }
+  addText(s, text, x, y);
+}
+
+void LovyanGFX::drawCentreString(const char* text, int32_t x, int32_t y, uint8_t font) {
+  int32_t cw, ch;
+  fontCell(font, &cw, &ch);
+  int32_t scale = textSize >= 1 ? (int32_t)textSize : 1;
+  drawString(text, x - (int32_t)strlen(text) * cw * scale / 2, y, font);
+}
+
+void LovyanGFX::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const swap565_t* data) {
+  SimSurface* s = surface();
+  if (s == nullptr) return;
+  int32_t srcW = w;
+  int32_t srcX = x < 0 ? -x : 0;
+  int32_t srcY = y < 0 ? -y : 0;
+  clipRect(s, x, y, w, h);
+  s->drawCalls++;
+  if (s->pixels != nullptr) {
+    for (int32_t row = 0; row < h; row++) {
+      const swap565_t* src = data + (srcY + row) * srcW + srcX;
+      for (int32_t i = 0; i < w; i++) {
+        uint16_t color = (uint16_t)((src[i].raw[0] << 8) | src[i].raw[1]);
+        s->pixels[(y + row) * s->width + x + i] = s->swapped ? swap16(color) : color;
+      }
+    }
+  }
+  s->pixelWrites += (uint64_t)w * h;
+  eraseText(s, x, y, w, h);
+  // A pushed canvas brings its text along.
+  SimSurface* source = simCanvasSurface(data);
+  if (source != nullptr) {
+    for (int i = 0; i < source->textCount; i++) {
+      addText(s, source->texts[i].text.c_str(), x + source->texts[i].x, y + source->texts[i].y);
+    }
+  }
+  // The transfer is the frame in sprite mode.
+  endFrame(s);
+}
+
+} // namespace lgfx
+
+// --- M5Canvas ---
+static M5Canvas* canvases[8];
+static int canvasCount = 0;
+
+SimSurface* simCanvasSurface(const void* buffer) {
+  for (int i = 0; i < canvasCount; i++) {
+    if (buffer != nullptr && canvases[i]->getBuffer() == buffer) return canvases[i]->own;
+  }
+  return nullptr;
+}
+
+M5Canvas::M5Canvas(lgfx::LovyanGFX* parent) : own(new SimSurface()), buffer(nullptr) {
+  simSurfaceInit(own, 0, 0, nullptr, true);
+  if (canvasCount < (int)(sizeof(canvases) / sizeof(canvases[0]))) canvases[canvasCount++] = this;
+}
+
+M5Canvas::~M5Canvas() {
+  for (int i = 0; i < canvasCount; i++) {
+    if (canvases[i] == this) canvases[i] = canvases[--canvasCount];
+  }
+  heap_caps_free(buffer);
+  delete own;
+}
+
+void* M5Canvas::createSprite(int32_t w, int32_t h) {
+  heap_caps_free(buffer);
+  buffer = (uint16_t*)heap_caps_malloc((size_t)w * h * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+  if (buffer == nullptr) return nullptr;
+  simSurfaceInit(own, w, h, buffer, true);
+  return buffer;
+}
+
+SimSurface* M5Canvas::surface() {
+  return own;
+}
+
+// --- Touch and M5 ---
+namespace m5 {
+
+uint8_t Touch_Class::getCount() {
+  return simCurrent != nullptr && simCurrent->touchLatched ? 1 : 0;
+}
+
+touch_detail_t Touch_Class::getDetail(uint8_t index) {
+  touch_detail_t detail = { -1, -1 };
+  if (simCurrent != nullptr && simCurrent->touchLatched) {
+    detail.x = (int16_t)simCurrent->touchLatchedX;
+    detail.y = (int16_t)simCurrent->touchLatchedY;
+  }
+  return detail;
+}
+
+void M5Unified::begin(const config_t& cfg) {}
+
+void M5Unified::update() {
+  SimDevice* d = simCurrent;
+  if (d == nullptr) return;
+  d->touchLatched = d->touchDown;
+  d->touchLatchedX = d->touchX;
+  d->touchLatchedY = d->touchY;
+}
+
+} // namespace m5
@@ -0,0 +1,202 @@
+#include <WiFi.h>
+#include <esp_now.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "sim_device.h"
+
+// --- Radio Timing ---
+// Airtime of one packet at the 1 Mbps ESP-NOW rate: channel access, the
+// 802.11 action frame and vendor headers around the payload, and the ACK
+// of a unicast. A device's packets go out one after another.
+static const uint32_t channelAccessUs = 100;  // DIFS and average backoff
+static const uint32_t frameOverheadBytes = 43;
+static const uint32_t ackUs = 44;
+static const uint8_t broadcastAddress[ESP_NOW_ETH_ALEN] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+struct SimEspNowState {
+  bool initialised;
+  uint8_t channel;
+  esp_now_recv_cb_t recv;
+  esp_now_send_cb_t sent;
+  std::vector<std::string> peers;  // peer MACs, 6 bytes each
+  uint64_t airFreeUs;              // the end of the last packet this device sent
+};
+
+struct SimEspNowPacket {
+  uint8_t source[ESP_NOW_ETH_ALEN];
+  uint8_t channel;
+  std::string data;
+};
+
+struct SimEspNowSendStatus {
+  uint8_t peer[ESP_NOW_ETH_ALEN];
+  esp_now_send_status_t status;
+};
+
+WiFiClass WiFi;
+
+static SimEspNowState* espNowState(SimDevice* d) {
+  if (d->espnow == nullptr) {
+    d->espnow = new SimEspNowState();
+    d->espnow->initialised = false;
+    d->espnow->channel = 1;
+    d->espnow->recv = nullptr;
+    d->espnow->sent = nullptr;
+    d->espnow->airFreeUs = 0;
+  }
+  return d->espnow;
+}
+
+static SimEspNowState* currentEspNow() {
+  if (simCurrent == nullptr) {
+    fprintf(stderr, "sim: ESP-NOW call outside a device\n");
+    abort();
+  }
+  return espNowState(simCurrent);
+}
+
+static std::string macKey(const uint8_t* mac) {
+  return std::string((const char*)mac, ESP_NOW_ETH_ALEN);
+}
+
+static int findPeer(const SimEspNowState* s, const uint8_t* mac) {
+  std::string key = macKey(mac);
+  for (size_t i = 0; i < s->peers.size(); i++) {
+    if (s->peers[i] == key) return (int)i;
+  }
+  return -1;
+}
+
+// --- Wi-Fi ---
+bool WiFiClass::mode(wifi_mode_t mode) {
+  return true;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second) {
+  if (primary < 1 || primary > 14) return ESP_ERR_INVALID_ARG;
+  currentEspNow()->channel = primary;
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]) {
+  currentEspNow();
+  memcpy(mac, simCurrent->mac, ESP_NOW_ETH_ALEN);
+  return ESP_OK;
+}
+
+// --- ESP-NOW ---
+esp_err_t esp_now_init() {
+  SimEspNowState* s = currentEspNow();
+  s->initialised = true;
+  s->peers.clear();
+  return ESP_OK;
+}
+
+esp_err_t esp_now_deinit() {
+  SimEspNowState* s = currentEspNow();
+  s->initialised = false;
+  s->recv = nullptr;
+  s->sent = nullptr;
+  s->peers.clear();
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+  SimEspNowState* s = currentEspNow();
+  if (!s->initialised) return ESP_ERR_ESPNOW_NOT_INIT;
+  s->recv = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb) {
+  SimEspNowState* s = currentEspNow();
+  if (!s->initialised) return ESP_ERR_ESPNOW_NOT_INIT;
+  s->sent = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer) {
+  SimEspNowState* s = currentEspNow();
+  if (!s->initialised) return ESP_ERR_ESPNOW_NOT_INIT;
+  if (peer == nullptr) return ESP_ERR_INVALID_ARG;
+  if (findPeer(s, peer->peer_addr) >= 0) return ESP_ERR_ESPNOW_EXIST;
+  if (s->peers.size() == ESP_NOW_MAX_TOTAL_PEER_NUM) return ESP_ERR_ESPNOW_FULL;
+  s->peers.push_back(macKey(peer->peer_addr));
+  return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t* peer_addr) {
+  SimEspNowState* s = currentEspNow();
+  if (!s->initialised) return ESP_ERR_ESPNOW_NOT_INIT;
+  int i = findPeer(s, peer_addr);
+  if (i < 0) return ESP_ERR_ESPNOW_NOT_FOUND;
+  s->peers.erase(s->peers.begin() + i);
+  return ESP_OK;
+}
+
+bool esp_now_is_peer_exist(const uint8_t* peer_addr) {
+  SimEspNowState* s = currentEspNow();
+  return s->initialised && findPeer(s, peer_addr) >= 0;
+}
+
+static void deliverEspNow(void* arg) {
+  SimEspNowPacket* p = (SimEspNowPacket*)arg;
+  SimEspNowState* s = simCurrent->espnow;
+  // The receiver may have switched channel or stopped while it was in the air.
+  if (s->initialised && s->channel == p->channel && s->recv != nullptr) {
+    s->recv(p->source, (const uint8_t*)p->data.data(), (int)p->data.size());
+  }
+  delete p;
+}
+
+static void reportSent(void* arg) {
+  SimEspNowSendStatus* r = (SimEspNowSendStatus*)arg;
+  SimEspNowState* s = simCurrent->espnow;
+  if (s->initialised && s->sent != nullptr) s->sent(r->peer, r->status);
+  delete r;
+}
+
+static void transmit(SimEspNowState* s, const uint8_t* peer, const uint8_t* data, size_t len) {
+  bool broadcast = memcmp(peer, broadcastAddress, ESP_NOW_ETH_ALEN) == 0;
+  uint64_t start = s->airFreeUs > simNowUs() ? s->airFreeUs : simNowUs();
+  uint64_t endUs = start + channelAccessUs + (uint64_t)(frameOverheadBytes + len) * 8;
+  s->airFreeUs = endUs + (broadcast ? 0 : ackUs);
+  bool acked = false;
+  for (int i = 0; i < simDeviceCount(); i++) {
+    SimDevice* d = simDevice(i);
+    if (d == simCurrent || d->espnow == nullptr || !d->espnow->initialised) continue;
+    if (d->espnow->channel != s->channel) continue;
+    if (!broadcast && memcmp(d->mac, peer, ESP_NOW_ETH_ALEN) != 0) continue;
+    SimEspNowPacket* p = new SimEspNowPacket();
+    memcpy(p->source, simCurrent->mac, ESP_NOW_ETH_ALEN);
+    p->channel = s->channel;
+    p->data.assign((const char*)data, len);
+    simPost(d, endUs, deliverEspNow, p);
+    acked = true;
+  }
+  if (s->sent != nullptr) {
+    SimEspNowSendStatus* r = new SimEspNowSendStatus();
+    memcpy(r->peer, peer, ESP_NOW_ETH_ALEN);
+    r->status = (broadcast || acked) ? ESP_NOW_SEND_SUCCESS : ESP_NOW_SEND_FAIL;
+    simPost(simCurrent, s->airFreeUs, reportSent, r);
+  }
+}
+
+// A null peer_addr sends to every peer in the list, as on the device.
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len) {
+  SimEspNowState* s = currentEspNow();
+  if (!s->initialised) return ESP_ERR_ESPNOW_NOT_INIT;
+  if (len == 0 || len > ESP_NOW_MAX_DATA_LEN) return ESP_ERR_INVALID_ARG;
+  if (peer_addr == nullptr) {
+    for (size_t i = 0; i < s->peers.size(); i++) {
+      transmit(s, (const uint8_t*)s->peers[i].data(), data, len);
+    }
+    return ESP_OK;
+  }
+  if (findPeer(s, peer_addr) < 0) return ESP_ERR_ESPNOW_NOT_FOUND;
+  transmit(s, peer_addr, data, len);
+  return ESP_OK;
+}
@@ -0,0 +1,120 @@
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sim_link.h"
+
+// --- Host Simulator HAL ---
+// Stand-ins for the parts of the Arduino core, FreeRTOS, M5Unified, the
+// Bluedroid BLE classes and ESP-NOW that the firmware uses, so that several
+// copies of the whole game run in one Linux process (see src/sim/).
+//
+// Every simulated device has its own clock, tasks, event groups, touch
+// panel, display, serial port and BLE stack. The globals the firmware sees
+// (Serial, M5, BLEDevice, WiFi) forward to the device that is running. Tasks are
+// cooperative coroutines driven by one scheduler thread, so there are no
+// data races and a FreeRTOS task only gives up the CPU where it would
+// block on the device (delay, vTaskDelay, xEventGroupWaitBits). BLE
+// traffic between devices goes through an in-memory radio that delivers
+// each packet on the link's next connection event; ESP-NOW packets go
+// through another that delivers them after their airtime.
+
+#define SIM_MAX_DEVICES 16
+#define SIM_MAX_TASKS 8           // per device, including loopTask
+#define SIM_STACK_SCALE 8         // host stack bytes per FreeRTOS stack byte
+#define SIM_TOUCH_INT_PIN 39      // Core2 FT6336U interrupt line
+#define SIM_PANEL_WIDTH 320
+#define SIM_PANEL_HEIGHT 240
+
+// One build of the firmware: its Arduino entry points.
+struct SimFirmware {
+  const char* name;
+  void (*setup)();
+  void (*loop)();
+};
+
+// --- Clock ---
+// With the virtual clock (the default) time stands still while tasks run
+// and jumps to the next deadline when they are all blocked, so a run gives
+// the same result every time and finishes as fast as the host allows. The
+// real clock paces the run with the wall clock, for watching it.
+enum SimClock { SIM_CLOCK_VIRTUAL, SIM_CLOCK_REAL };
+
+// Selects the clock; call before adding devices.
+void simSetClock(SimClock clock);
+
+// Adds a device running fw that powers up bootDelayMs into the simulation.
+// label prefixes its serial output. Returns the device index.
+int simAddDevice(const SimFirmware& fw, const char* label, uint32_t bootDelayMs);
+
+// Runs the scheduler until ms of simulated time have passed.
+void simRunFor(uint32_t ms);
+
+// Microseconds since the simulation started.
+uint64_t simNowUs();
+
+// The device whose code is running, or -1 in the harness. Firmware built
+// once for several devices keeps its state per device with this.
+int simCurrentDevice();
+
+// Presses the touch panel at (x, y) for holdMs, firing the touch interrupt.
+void simTouch(int device, int x, int y, uint32_t holdMs);
+
+// Queues text as if typed into the device's serial monitor.
+void simSerialInput(int device, const char* text);
+
+// Serial output is printed to stdout, prefixed with the sim time and the
+// device label, unless echo is off.
+void simSetSerialEcho(bool echo);
+
+// FNV-1a hash of every serial line written so far with its sim time and
+// device; two runs behaved the same if their digests match.
+uint64_t simSerialDigest();
+
+// True if text was drawn and has not been painted over since.
+bool simScreenHasText(int device, const char* text);
+
+// --- Display ---
+// Each panel is a 320x240 RGB565 framebuffer. Text is drawn with a 5x7
+// bitmap font scaled to the cell size of the firmware's fonts, so images
+// match hardware in layout and colour but not in glyph shapes.
+
+// A frame ends when the panel's write transaction closes (direct mode) or
+// a canvas is pushed to it (sprite mode).
+struct SimFrameStats {
+  uint32_t frames;              // frames that wrote at least one pixel
+  uint64_t lastPixels;          // pixels written by the last frame
+  uint64_t maxPixels;
+  uint64_t totalPixels;
+};
+
+SimFrameStats simFrameStats(int device);
+
+// Called after each frame reaches a panel, in the context of its device.
+typedef void (*SimFrameHook)(int device);
+void simSetFrameHook(SimFrameHook hook);
+
+// Writes the panel as a binary PPM, or as a PNG if path ends in ".png".
+bool simScreenSave(int device, const char* path);
+
+// Compares the panel with a PPM written by simScreenSave. Returns the
+// number of pixels that differ, or -1 if the file is missing or its size
+// differs from the panel.
+long simScreenCompare(int device, const char* path);
+
+// --- BLE ---
+// Drops the device's BLE connections as if the peer went out of range.
+void simBleDisconnect(int device);
+
+// --- Host Links ---
+// Gives the device a frame link instead of the BLE radio (see sim_link.h);
+// path is the socket for SIM_LINK_UNIX_SOCKET. Call after simAddDevice.
+void simSetLink(int device, SimLinkKind kind, const char* path);
+
+// Firmware instances are compiled into their own namespace (see
+// src/sim/sim_firmware.h); this defines the instance's SimFirmware.
+#define SIM_FIRMWARE(ns) \
+  extern const SimFirmware ns##Firmware = { #ns, ns::setup, ns::loop }
+
+#endif // SIM_HAL_H
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "sim_device.h"
+
+// --- Panel Images ---
+// Frames are written as 8-bit RGB: binary PPM for golden images (trivial to
+// read back and diff) and PNG for viewing. The PNG uses stored (unpacked)
+// deflate blocks, so it needs no zlib.
+
+// Expands the panel to RGB888, replicating the high bits into the low ones
+// so that white stays 0xFFFFFF.
+static std::vector<uint8_t> panelRgb(const SimSurface* s) {
+  std::vector<uint8_t> rgb((size_t)s->width * s->height * 3);
+  uint8_t* p = rgb.data();
+  for (int y = 0; y < s->height; y++) {
+    for (int x = 0; x < s->width; x++) {
+      uint16_t c = simSurfacePixel(s, x, y);
+      uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+      *p++ = (uint8_t)((r << 3) | (r >> 2));
+      *p++ = (uint8_t)((g << 2) | (g >> 4));
+      *p++ = (uint8_t)((b << 3) | (b >> 2));
+    }
+  }
+  return rgb;
+}
+
+static bool writePpm(FILE* f, const SimSurface* s, const std::vector<uint8_t>& rgb) {
+  fprintf(f, "P6\n%d %d\n255\n", s->width, s->height);
+  return fwrite(rgb.data(), 1, rgb.size(), f) == rgb.size();
+}
+
+static uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0) {
+  static uint32_t table[256];
+  if (table[1] == 0) {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    }
+  }
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static void putBe32(std::vector<uint8_t>& out, uint32_t v) {
+  out.push_back((uint8_t)(v >> 24));
+  out.push_back((uint8_t)(v >> 16));
+  out.push_back((uint8_t)(v >> 8));
+  out.push_back((uint8_t)v);
+}
+
+static void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+  putBe32(out, (uint32_t)data.size());
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  putBe32(out, crc32(out.data() + start, out.size() - start));
+}
+
+static bool writePng(FILE* f, const SimSurface* s, const std::vector<uint8_t>& rgb) {
+  static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  std::vector<uint8_t> out(signature, signature + sizeof(signature));
+
+  std::vector<uint8_t> header;
+  putBe32(header, (uint32_t)s->width);
+  putBe32(header, (uint32_t)s->height);
+  const uint8_t format[5] = { 8, 2, 0, 0, 0 };  // 8-bit RGB, no interlace
+  header.insert(header.end(), format, format + sizeof(format));
+  putChunk(out, "IHDR", header);
+
+  // Each row starts with filter type 0 (none).
+  size_t stride = (size_t)s->width * 3;
+  std::vector<uint8_t> raw;
+  raw.reserve((stride + 1) * s->height);
+  for (int y = 0; y < s->height; y++) {
+    raw.push_back(0);
+    raw.insert(raw.end(), rgb.begin() + y * stride, rgb.begin() + (y + 1) * stride);
+  }
+
+  std::vector<uint8_t> z = { 0x78, 0x01 };
+  uint32_t a = 1, b = 0;  // Adler-32
+  for (size_t pos = 0; pos < raw.size();) {
+    size_t len = raw.size() - pos < 65535 ? raw.size() - pos : 65535;
+    z.push_back(pos + len == raw.size() ? 1 : 0);  // BFINAL on the last block
+    z.push_back((uint8_t)len);
+    z.push_back((uint8_t)(len >> 8));
+    z.push_back((uint8_t)~len);
+    z.push_back((uint8_t)(~len >> 8));
+    for (size_t i = pos; i < pos + len; i++) {
+      z.push_back(raw[i]);
+      a = (a + raw[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    pos += len;
+  }
+  putBe32(z, (b << 16) | a);
+  putChunk(out, "IDAT", z);
+  putChunk(out, "IEND", std::vector<uint8_t>());
+  return fwrite(out.data(), 1, out.size(), f) == out.size();
+}
+
+bool simScreenSave(int device, const char* path) {
+  SimDevice* d = simDevice(device);
+  if (d == nullptr) return false;
+  FILE* f = fopen(path, "wb");
+  if (f == nullptr) return false;
+  std::vector<uint8_t> rgb = panelRgb(&d->panel);
+  size_t len = strlen(path);
+  bool png = len > 4 && strcmp(path + len - 4, ".png") == 0;
+  bool ok = png ? writePng(f, &d->panel, rgb) : writePpm(f, &d->panel, rgb);
+  return fclose(f) == 0 && ok;
+}
+
+long simScreenCompare(int device, const char* path) {
+  SimDevice* d = simDevice(device);
+  if (d == nullptr) return -1;
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) return -1;
+  int width = 0, height = 0, maxValue = 0;
+  bool ok = fscanf(f, "P6 %d %d %d", &width, &height, &maxValue) == 3 && fgetc(f) != EOF &&
+            width == d->panel.width && height == d->panel.height && maxValue == 255;
+  std::vector<uint8_t> golden;
+  if (ok) {
+    golden.resize((size_t)width * height * 3);
+    ok = fread(golden.data(), 1, golden.size(), f) == golden.size();
+  }
+  fclose(f);
+  if (!ok) return -1;
+
+  std::vector<uint8_t> rgb = panelRgb(&d->panel);
+  long differing = 0;
+  for (size_t i = 0; i < rgb.size(); i += 3) {
+    if (memcmp(&rgb[i], &golden[i], 3) != 0) differing++;
+  }
+  return differing;
+}
@@ -0,0 +1,230 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include "sim_device.h"
+#include "sim_link.h"
+
+static const uint64_t connectRetryUs = 200000;  // socket client: while the host is not listening yet
+static const size_t maxLinkFrame = 64;
+
+struct SimLinkState {
+  SimLinkKind kind;
+  std::string path;
+  bool open;                // the firmware called simLinkOpen
+  bool host;
+  bool up;
+  SimLinkRxFn rx;
+  SimLinkStateFn state;
+  SimDevice* peer;          // loopback
+  int listenFd;             // socket host
+  int fd;                   // socket connection
+  uint64_t retryUs;         // socket client: next connect attempt
+};
+
+void simSetLink(int device, SimLinkKind kind, const char* path) {
+  SimDevice* d = simDevice(device);
+  if (d == nullptr) return;
+  if (kind == SIM_LINK_UNIX_SOCKET && simClockIsVirtual()) {
+    fprintf(stderr, "sim: Unix socket links need the real clock\n");
+    abort();
+  }
+  SimLinkState* link = new SimLinkState();
+  link->kind = kind;
+  link->path = path != nullptr ? path : "";
+  link->open = false;
+  link->host = false;
+  link->up = false;
+  link->rx = nullptr;
+  link->state = nullptr;
+  link->peer = nullptr;
+  link->listenFd = -1;
+  link->fd = -1;
+  link->retryUs = 0;
+  d->link = link;
+}
+
+// Hands a frame to the device's handler, in its callback context.
+static void deliverFrame(SimDevice* d, uint8_t channel, const uint8_t* data, size_t len) {
+  if (d->link->rx == nullptr) return;
+  SimDevice* saved = simCurrent;
+  SimTask* savedTask = simCurrentTask;
+  simCurrent = d;
+  simCurrentTask = nullptr;
+  d->link->rx(channel, data, len);
+  simCurrent = saved;
+  simCurrentTask = savedTask;
+}
+
+static void reportUp(void* arg) {
+  simCurrent->link->state(true);
+}
+
+static void reportDown(void* arg) {
+  simCurrent->link->state(false);
+}
+
+static void setUp(SimDevice* d, bool up) {
+  d->link->up = up;
+  if (d->link->state != nullptr) simPost(d, simNowUs(), up ? reportUp : reportDown, nullptr);
+}
+
+// --- Loopback ---
+static void pairLoopback(SimDevice* d) {
+  for (int i = 0; i < simDeviceCount(); i++) {
+    SimDevice* other = simDevice(i);
+    SimLinkState* o = other->link;
+    if (other == d || o == nullptr || o->kind != SIM_LINK_LOOPBACK) continue;
+    if (!o->open || o->up || o->host == d->link->host) continue;
+    d->link->peer = other;
+    o->peer = d;
+    setUp(d, true);
+    setUp(other, true);
+    return;
+  }
+}
+
+// --- Unix Socket ---
+static void closeConnection(SimDevice* d) {
+  SimLinkState* link = d->link;
+  if (link->fd >= 0) close(link->fd);
+  link->fd = -1;
+  if (link->up) setUp(d, false);
+  if (!link->host) link->open = false;  // the firmware reopens to reconnect
+}
+
+static bool makeAddress(const std::string& path, sockaddr_un* addr) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr->sun_path)) return false;
+  memcpy(addr->sun_path, path.c_str(), path.size());
+  return true;
+}
+
+static void listenSocket(SimDevice* d) {
+  SimLinkState* link = d->link;
+  sockaddr_un addr;
+  if (link->listenFd >= 0 || !makeAddress(link->path, &addr)) return;
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0);
+  unlink(link->path.c_str());
+  if (fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+    fprintf(stderr, "sim: cannot listen on %s: %s\n", link->path.c_str(), strerror(errno));
+    if (fd >= 0) close(fd);
+    return;
+  }
+  link->listenFd = fd;
+}
+
+static void connectSocket(SimDevice* d, uint64_t now) {
+  SimLinkState* link = d->link;
+  sockaddr_un addr;
+  if (!makeAddress(link->path, &addr)) return;
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0);
+  if (fd >= 0 && connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+    link->fd = fd;
+    setUp(d, true);
+    return;
+  }
+  if (fd >= 0) close(fd);
+  link->retryUs = now + connectRetryUs;
+}
+
+static void readSocket(SimDevice* d) {
+  SimLinkState* link = d->link;
+  for (;;) {
+    uint8_t msg[maxLinkFrame + 1];  // channel, then the frame
+    ssize_t n = recv(link->fd, msg, sizeof(msg), 0);
+    if (n > 0) {
+      deliverFrame(d, msg[0], msg + 1, (size_t)n - 1);
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    closeConnection(d);  // peer closed, or the socket failed
+    return;
+  }
+}
+
+// --- Firmware Side ---
+SimLinkKind simLinkKind() {
+  return simCurrent != nullptr && simCurrent->link != nullptr ? simCurrent->link->kind : SIM_LINK_NONE;
+}
+
+void simLinkOpen(bool host, SimLinkRxFn rx, SimLinkStateFn state) {
+  SimDevice* d = simCurrent;
+  if (d == nullptr || d->link == nullptr) return;
+  SimLinkState* link = d->link;
+  link->host = host;
+  link->rx = rx;
+  link->state = state;
+  if (link->up) {
+    setUp(d, true);
+    return;
+  }
+  link->open = true;
+  if (link->kind == SIM_LINK_LOOPBACK) {
+    pairLoopback(d);
+  } else if (host) {
+    listenSocket(d);
+  } else {
+    link->retryUs = simNowUs();
+  }
+}
+
+bool simLinkSend(uint8_t channel, const uint8_t* data, size_t len) {
+  SimDevice* d = simCurrent;
+  if (d == nullptr || d->link == nullptr || !d->link->up) return false;
+  SimLinkState* link = d->link;
+  if (link->kind == SIM_LINK_LOOPBACK) {
+    deliverFrame(link->peer, channel, data, len);
+    return true;
+  }
+  if (len > maxLinkFrame) return false;
+  uint8_t msg[maxLinkFrame + 1];
+  msg[0] = channel;
+  memcpy(msg + 1, data, len);
+  if (send(link->fd, msg, len + 1, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)(len + 1)) return true;
+  if (errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(d);
+  return false;
+}
+
+// --- Scheduler Side ---
+void simLinkPoll(SimDevice* d, uint64_t now) {
+  SimLinkState* link = d->link;
+  if (link == nullptr || link->kind != SIM_LINK_UNIX_SOCKET || !link->open) return;
+  if (link->host && link->fd < 0 && link->listenFd >= 0) {
+    int fd = accept4(link->listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+    if (fd >= 0) {
+      link->fd = fd;
+      setUp(d, true);
+    }
+  } else if (!link->host && link->fd < 0 && now >= link->retryUs) {
+    connectSocket(d, now);
+  }
+  if (link->fd >= 0) readSocket(d);
+}
+
+uint64_t simLinkNextUs(SimDevice* d) {
+  SimLinkState* link = d->link;
+  if (link == nullptr || link->kind != SIM_LINK_UNIX_SOCKET || !link->open) return UINT64_MAX;
+  if (!link->host && link->fd < 0) return link->retryUs;
+  return UINT64_MAX;
+}
+
+void simLinkWait(uint64_t timeoutUs) {
+  pollfd fds[SIM_MAX_DEVICES * 2];
+  nfds_t count = 0;
+  for (int i = 0; i < simDeviceCount(); i++) {
+    SimLinkState* link = simDevice(i)->link;
+    if (link == nullptr) continue;
+    if (link->fd >= 0) fds[count++] = { link->fd, POLLIN, 0 };
+    if (link->listenFd >= 0 && link->fd < 0) fds[count++] = { link->listenFd, POLLIN, 0 };
+  }
+  timespec timeout = { (time_t)(timeoutUs / 1000000), (long)(timeoutUs % 1000000) * 1000 };
+  ppoll(fds, count, &timeout, nullptr);
+}
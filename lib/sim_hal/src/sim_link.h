@@ -0,0 +1,35 @@
+#ifndef SIM_LINK_H
+#define SIM_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Host Frame Links ---
+// A simulated device can be given a link that carries frames without the
+// BLE radio, for the firmware's host transport (src/transport_host.cpp):
+//   SIM_LINK_LOOPBACK     - to another device in this process. A frame is
+//                           handed to the peer's handler as it is sent, from
+//                           the sender's buffer, without a copy or a delay.
+//   SIM_LINK_UNIX_SOCKET  - to a device in another simulator process over a
+//                           SOCK_SEQPACKET socket at a path; the host end
+//                           listens, the other connects. Needs the real
+//                           clock, since the two processes share no virtual
+//                           time.
+// The harness picks the link with simSetLink() (sim_hal.h). The calls
+// below act on the running device.
+enum SimLinkKind { SIM_LINK_NONE, SIM_LINK_LOOPBACK, SIM_LINK_UNIX_SOCKET };
+
+// Handlers run in the device's callback context, like BLE callbacks.
+typedef void (*SimLinkRxFn)(uint8_t channel, const uint8_t* data, size_t len);
+typedef void (*SimLinkStateFn)(bool up);
+
+SimLinkKind simLinkKind();
+
+// Starts offering the link (host) or looking for the host. Calling it again
+// while the link is up only reports it up again.
+void simLinkOpen(bool host, SimLinkRxFn rx, SimLinkStateFn state);
+
+// False if the link is not up.
+bool simLinkSend(uint8_t channel, const uint8_t* data, size_t len);
+
+#endif // SIM_LINK_H
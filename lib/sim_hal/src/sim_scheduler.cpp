@@ -0,0 +1,437 @@
+#include <chrono>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "sim_device.h"
+#include "freertos/event_groups.h"
+
+SimDevice* simCurrent = nullptr;
+SimTask* simCurrentTask = nullptr;
+
+static SimDevice devices[SIM_MAX_DEVICES];
+static int deviceCount = 0;
+static ucontext_t schedulerContext;
+
+static const uint32_t loopTaskStack = 8192;  // the Arduino core's loopTask
+static const uint8_t stackPaint = 0xA5;
+static const uint32_t maxPassesWithoutTime = 1000000;  // virtual clock: assume a task spins
+
+static void simFatal(const char* what) {
+  fprintf(stderr, "sim: %s (device %s, task %s)\n", what,
+          simCurrent ? simCurrent->label : "-", simCurrentTask ? simCurrentTask->name : "-");
+  abort();
+}
+
+// --- Clock ---
+static SimClock clockKind = SIM_CLOCK_VIRTUAL;
+static uint64_t virtualNowUs = 0;
+static std::chrono::steady_clock::time_point realStart = std::chrono::steady_clock::now();
+
+void simSetClock(SimClock clock) {
+  if (deviceCount > 0) simFatal("simSetClock after simAddDevice");
+  clockKind = clock;
+  virtualNowUs = 0;
+  realStart = std::chrono::steady_clock::now();
+}
+
+bool simClockIsVirtual() {
+  return clockKind == SIM_CLOCK_VIRTUAL;
+}
+
+uint64_t simNowUs() {
+  if (clockKind == SIM_CLOCK_VIRTUAL) return virtualNowUs;
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - realStart).count();
+}
+
+// Called when every task is blocked and no event is due before us.
+static void waitUntil(uint64_t us) {
+  if (clockKind == SIM_CLOCK_VIRTUAL) {
+    if (us > virtualNowUs) virtualNowUs = us;
+    return;
+  }
+  uint64_t now = simNowUs();
+  if (us > now) simLinkWait(us - now);
+}
+
+uint64_t simDeviceUs() {
+  uint64_t now = simNowUs();
+  return simCurrent != nullptr ? now - simCurrent->bootUs : now;
+}
+
+// --- Devices ---
+SimDevice* simDevice(int index) {
+  return (index >= 0 && index < deviceCount) ? &devices[index] : nullptr;
+}
+
+int simDeviceCount() {
+  return deviceCount;
+}
+
+int simCurrentDevice() {
+  return simCurrent != nullptr ? simCurrent->index : -1;
+}
+
+int simAddDevice(const SimFirmware& fw, const char* label, uint32_t bootDelayMs) {
+  if (deviceCount == SIM_MAX_DEVICES) simFatal("too many devices");
+  SimDevice* d = &devices[deviceCount];
+  d->index = deviceCount;
+  snprintf(d->label, sizeof(d->label), "%s", label);
+  d->firmware = fw;
+  d->bootUs = simNowUs() + (uint64_t)bootDelayMs * 1000;
+  d->booted = false;
+  d->taskCount = 0;
+  d->touchIsr = nullptr;
+  d->heapUsed[0] = d->heapUsed[1] = 0;
+  d->heapPeak[0] = d->heapPeak[1] = 0;
+  d->touchDown = false;
+  d->touchLatched = false;
+  simSurfaceInit(&d->panel, SIM_PANEL_WIDTH, SIM_PANEL_HEIGHT, d->panelPixels, false);
+  d->ble = nullptr;
+  d->link = nullptr;
+  d->espnow = nullptr;
+  const uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, (uint8_t)(0x10 + deviceCount) };
+  memcpy(d->mac, mac, sizeof(mac));
+  return deviceCount++;
+}
+
+// --- Tasks ---
+static void taskEntry() {
+  SimTask* t = simCurrentTask;
+  t->fn(t->arg);
+  // FreeRTOS tasks must not return; treat it as deleting itself.
+  t->state = SIM_TASK_DELETED;
+  swapcontext(&t->context, &schedulerContext);
+}
+
+static SimTask* createTask(SimDevice* d, TaskFunction_t fn, const char* name, uint32_t stackDepth, void* arg) {
+  if (d->taskCount == SIM_MAX_TASKS) return nullptr;
+  SimTask* t = new SimTask();
+  t->device = d;
+  snprintf(t->name, sizeof(t->name), "%s", name);
+  t->fn = fn;
+  t->arg = arg;
+  t->stackSize = (size_t)(stackDepth < 1024 ? 1024 : stackDepth) * SIM_STACK_SCALE;
+  t->stack = (uint8_t*)malloc(t->stackSize);
+  memset(t->stack, stackPaint, t->stackSize);
+  t->state = SIM_TASK_READY;
+  t->wakeUs = 0;
+  t->waitObject = nullptr;
+  getcontext(&t->context);
+  t->context.uc_stack.ss_sp = t->stack;
+  t->context.uc_stack.ss_size = t->stackSize;
+  t->context.uc_link = &schedulerContext;
+  makecontext(&t->context, taskEntry, 0);
+  d->tasks[d->taskCount++] = t;
+  return t;
+}
+
+static void freeTask(SimTask* t) {
+  SimDevice* d = t->device;
+  for (int i = 0; i < d->taskCount; i++) {
+    if (d->tasks[i] == t) {
+      d->tasks[i] = d->tasks[--d->taskCount];
+      break;
+    }
+  }
+  free(t->stack);
+  delete t;
+}
+
+static void runTask(SimTask* t) {
+  simCurrent = t->device;
+  simCurrentTask = t;
+  swapcontext(&schedulerContext, &t->context);
+  simCurrent = nullptr;
+  simCurrentTask = nullptr;
+  if (t->state == SIM_TASK_DELETED) freeTask(t);
+}
+
+void simBlock(const void* waitObject, uint64_t wakeUs) {
+  SimTask* t = simCurrentTask;
+  if (t == nullptr) simFatal("blocking call outside a task");
+  t->state = SIM_TASK_BLOCKED;
+  t->waitObject = waitObject;
+  t->wakeUs = wakeUs;
+  swapcontext(&t->context, &schedulerContext);
+}
+
+void simSignal(SimDevice* device, const void* waitObject) {
+  for (int i = 0; i < device->taskCount; i++) {
+    SimTask* t = device->tasks[i];
+    if (t->state == SIM_TASK_BLOCKED && t->waitObject == waitObject) {
+      t->state = SIM_TASK_READY;
+    }
+  }
+}
+
+void simYield() {
+  SimTask* t = simCurrentTask;
+  if (t == nullptr) return;
+  swapcontext(&t->context, &schedulerContext);
+}
+
+static void loopTask(void* arg) {
+  SimDevice* d = simCurrent;
+  d->firmware.setup();
+  for (;;) {
+    d->firmware.loop();
+    simYield();
+  }
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle) {
+  if (simCurrent == nullptr) simFatal("xTaskCreate outside a device");
+  SimTask* t = createTask(simCurrent, fn, name, stackDepth, arg);
+  if (handle != nullptr) *handle = t;
+  return t != nullptr ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core) {
+  return xTaskCreate(fn, name, stackDepth, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  SimTask* t = task != nullptr ? (SimTask*)task : simCurrentTask;
+  if (t == nullptr) simFatal("vTaskDelete outside a task");
+  t->state = SIM_TASK_DELETED;
+  if (t == simCurrentTask) {
+    swapcontext(&t->context, &schedulerContext);  // never resumed
+  } else {
+    freeTask(t);
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0) {
+    simYield();
+    return;
+  }
+  simBlock(nullptr, simNowUs() + (uint64_t)ticks * 1000 * portTICK_PERIOD_MS);
+}
+
+void taskYIELD() {
+  simYield();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return simCurrentTask;
+}
+
+TaskHandle_t xTaskGetHandle(const char* name) {
+  if (simCurrent == nullptr) return nullptr;
+  for (int i = 0; i < simCurrent->taskCount; i++) {
+    if (strcmp(simCurrent->tasks[i]->name, name) == 0) return simCurrent->tasks[i];
+  }
+  return nullptr;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  SimTask* t = task != nullptr ? (SimTask*)task : simCurrentTask;
+  if (t == nullptr) return 0;
+  size_t untouched = 0;
+  while (untouched < t->stackSize && t->stack[untouched] == stackPaint) untouched++;  // grows down
+  return (UBaseType_t)(untouched / SIM_STACK_SCALE);
+}
+
+// --- Event Groups ---
+struct SimEventGroup {
+  SimDevice* device;
+  EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate() {
+  if (simCurrent == nullptr) simFatal("xEventGroupCreate outside a device");
+  SimEventGroup* group = new SimEventGroup();
+  group->device = simCurrent;
+  group->bits = 0;
+  return group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t handle, EventBits_t bits) {
+  SimEventGroup* group = (SimEventGroup*)handle;
+  group->bits |= bits;
+  simSignal(group->device, group);
+  return group->bits;
+}
+
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t handle, EventBits_t bits, BaseType_t* woken) {
+  xEventGroupSetBits(handle, bits);
+  if (woken != nullptr) *woken = pdFALSE;  // the scheduler picks the task up anyway
+  return pdPASS;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t handle, EventBits_t bits) {
+  SimEventGroup* group = (SimEventGroup*)handle;
+  EventBits_t before = group->bits;
+  group->bits &= ~bits;
+  return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t handle) {
+  return ((SimEventGroup*)handle)->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t handle, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t ticks) {
+  SimEventGroup* group = (SimEventGroup*)handle;
+  uint64_t deadline = ticks == portMAX_DELAY ? UINT64_MAX
+                      : simNowUs() + (uint64_t)ticks * 1000 * portTICK_PERIOD_MS;
+  for (;;) {
+    EventBits_t current = group->bits;
+    bool satisfied = waitForAll ? (current & bits) == bits : (current & bits) != 0;
+    if (satisfied) {
+      if (clearOnExit) group->bits &= ~bits;
+      return current;
+    }
+    if (ticks == 0 || simNowUs() >= deadline) return current;
+    simBlock(group, deadline);
+  }
+}
+
+// --- Callback Events ---
+struct SimEvent {
+  uint64_t dueUs;
+  uint64_t order;
+  SimDevice* device;
+  SimEventFn fn;
+  void* arg;
+};
+
+struct SimEventLater {
+  bool operator()(const SimEvent& a, const SimEvent& b) const {
+    return a.dueUs != b.dueUs ? a.dueUs > b.dueUs : a.order > b.order;
+  }
+};
+
+static std::priority_queue<SimEvent, std::vector<SimEvent>, SimEventLater> events;
+static uint64_t eventOrder = 0;
+
+void simPost(SimDevice* device, uint64_t dueUs, SimEventFn fn, void* arg) {
+  SimEvent e = { dueUs, eventOrder++, device, fn, arg };
+  events.push(e);
+}
+
+static bool runDueEvents(uint64_t now) {
+  bool ran = false;
+  while (!events.empty() && events.top().dueUs <= now) {
+    SimEvent e = events.top();
+    events.pop();
+    simCurrent = e.device;
+    simCurrentTask = nullptr;
+    e.fn(e.arg);
+    simCurrent = nullptr;
+    ran = true;
+  }
+  return ran;
+}
+
+// --- Harness ---
+void simTouch(int index, int x, int y, uint32_t holdMs) {
+  SimDevice* d = simDevice(index);
+  if (d == nullptr || !d->booted) return;
+  d->touchDown = true;
+  d->touchX = x;
+  d->touchY = y;
+  d->touchReleaseUs = simNowUs() + (uint64_t)holdMs * 1000;
+  if (d->touchIsr != nullptr) {
+    SimDevice* saved = simCurrent;
+    SimTask* savedTask = simCurrentTask;
+    simCurrent = d;
+    simCurrentTask = nullptr;
+    d->touchIsr();
+    simCurrent = saved;
+    simCurrentTask = savedTask;
+  }
+}
+
+void simSerialInput(int index, const char* text) {
+  SimDevice* d = simDevice(index);
+  if (d != nullptr) d->serialIn += text;
+}
+
+// Boots devices, releases touches and times out blocked tasks. Returns the
+// next time any of that (or a BLE poll) is due.
+static uint64_t pollDevices(uint64_t now) {
+  uint64_t next = UINT64_MAX;
+  for (int i = 0; i < deviceCount; i++) {
+    SimDevice* d = &devices[i];
+    if (!d->booted) {
+      if (now < d->bootUs) {
+        if (d->bootUs < next) next = d->bootUs;
+        continue;
+      }
+      d->booted = true;
+      createTask(d, loopTask, "loopTask", loopTaskStack, nullptr);
+    }
+    if (d->touchDown) {
+      if (now >= d->touchReleaseUs) {
+        d->touchDown = false;
+      } else if (d->touchReleaseUs < next) {
+        next = d->touchReleaseUs;
+      }
+    }
+    simBlePoll(d, now);
+    uint64_t bleNext = simBleNextUs(d);
+    if (bleNext < next) next = bleNext;
+    simLinkPoll(d, now);
+    uint64_t linkNext = simLinkNextUs(d);
+    if (linkNext < next) next = linkNext;
+    for (int t = 0; t < d->taskCount; t++) {
+      SimTask* task = d->tasks[t];
+      if (task->state != SIM_TASK_BLOCKED) continue;
+      if (now >= task->wakeUs) {
+        task->state = SIM_TASK_READY;
+      } else if (task->wakeUs < next) {
+        next = task->wakeUs;
+      }
+    }
+  }
+  return next;
+}
+
+static bool runReadyTasks() {
+  bool ran = false;
+  for (int i = 0; i < deviceCount; i++) {
+    SimDevice* d = &devices[i];
+    // A task may create or delete tasks while it runs; walk a snapshot.
+    SimTask* ready[SIM_MAX_TASKS];
+    int count = 0;
+    for (int t = 0; t < d->taskCount; t++) {
+      if (d->tasks[t]->state == SIM_TASK_READY) ready[count++] = d->tasks[t];
+    }
+    for (int t = 0; t < count; t++) {
+      bool alive = false;
+      for (int k = 0; k < d->taskCount; k++) alive |= d->tasks[k] == ready[t];
+      if (alive && ready[t]->state == SIM_TASK_READY) {
+        runTask(ready[t]);
+        ran = true;
+      }
+    }
+  }
+  return ran;
+}
+
+void simRunFor(uint32_t ms) {
+  uint64_t endUs = simNowUs() + (uint64_t)ms * 1000;
+  uint64_t lastNow = UINT64_MAX;
+  uint32_t passes = 0;
+  for (;;) {
+    uint64_t now = simNowUs();
+    if (now >= endUs) break;
+    passes = now == lastNow ? passes + 1 : 0;
+    lastNow = now;
+    if (passes == maxPassesWithoutTime) simFatal("tasks never block; virtual time cannot advance");
+    uint64_t next = pollDevices(now);
+    bool ran = runDueEvents(now);
+    ran |= runReadyTasks();
+    if (ran) continue;
+    if (!events.empty() && events.top().dueUs < next) next = events.top().dueUs;
+    waitUntil(next < endUs ? next : endUs);
+  }
+}
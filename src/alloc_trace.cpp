@@ -0,0 +1,70 @@
+#include "alloc_trace.h"
+
+#if ALLOC_TRACE
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static TaskHandle_t tracedTask = nullptr;
+static volatile bool tracing = false;
+static volatile int pauseDepth = 0;
+static AllocTraceReport report;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+}
+
+// Runs inside the allocator: no logging, no allocation.
+static void countAllocation(size_t size, void* caller) {
+  if (!tracing || pauseDepth > 0 || xTaskGetCurrentTaskHandle() != tracedTask) return;
+  if (report.count == 0) {
+    report.firstSize = (uint32_t)size;
+    report.firstCaller = caller;
+  }
+  report.count++;
+  report.bytes += (uint32_t)size;
+}
+
+extern "C" {
+void* __wrap_malloc(size_t size) {
+  countAllocation(size, __builtin_return_address(0));
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  countAllocation(count * size, __builtin_return_address(0));
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  countAllocation(size, __builtin_return_address(0));
+  return __real_realloc(ptr, size);
+}
+}
+
+void allocTraceBegin() {
+  report = AllocTraceReport();
+  pauseDepth = 0;
+  tracedTask = xTaskGetCurrentTaskHandle();
+  tracing = true;
+}
+
+bool allocTraceEnd(AllocTraceReport* out) {
+  tracing = false;
+  if (out != nullptr) *out = report;
+  return report.count == 0;
+}
+
+bool allocTraceActive() {
+  return tracing;
+}
+
+void allocTracePause() {
+  pauseDepth++;
+}
+
+void allocTraceResume() {
+  if (pauseDepth > 0) pauseDepth--;
+}
+#endif
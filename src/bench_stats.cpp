@@ -0,0 +1,70 @@
+#include <algorithm>
+#include "bench_stats.h"
+
+static uint32_t rttValues[BENCH_PINGS];
+static uint16_t rttCount = 0;
+static uint16_t lostCount = 0;
+
+// Written by the BLE task during the flood, read by the loop afterwards.
+static volatile uint32_t floodPackets = 0;
+static volatile uint32_t floodBytes = 0;
+static volatile uint32_t floodFirstUs = 0;
+static volatile uint32_t floodLastUs = 0;
+
+void benchReset() {
+  rttCount = 0;
+  lostCount = 0;
+  floodPackets = 0;
+  floodBytes = 0;
+  floodFirstUs = 0;
+  floodLastUs = 0;
+}
+
+void benchAddRtt(uint32_t rttUs) {
+  if (rttCount < BENCH_PINGS) rttValues[rttCount++] = rttUs;
+}
+
+void benchAddLoss() {
+  lostCount++;
+}
+
+void benchFloodPacket(size_t bytes, uint32_t nowUs) {
+  if (floodPackets == 0) floodFirstUs = nowUs;
+  floodLastUs = nowUs;
+  floodBytes = floodBytes + bytes;
+  floodPackets = floodPackets + 1;
+}
+
+uint32_t benchFloodPackets() {
+  return floodPackets;
+}
+
+// Nearest-rank percentile over sorted samples.
+static uint32_t percentile(int pct) {
+  if (rttCount == 0) return 0;
+  int rank = (pct * rttCount + 99) / 100;
+  if (rank < 1) rank = 1;
+  return rttValues[rank - 1];
+}
+
+void benchSummarize(BenchSummary* out) {
+  std::sort(rttValues, rttValues + rttCount);
+  out->pongs = rttCount;
+  out->lost = lostCount;
+  out->rttMinUs = rttCount > 0 ? rttValues[0] : 0;
+  out->rttP50Us = percentile(50);
+  out->rttP99Us = percentile(99);
+  out->floodPackets = floodPackets;
+  out->floodUs = floodLastUs - floodFirstUs;
+  out->notifyPerSec = 0;
+  out->kbps = 0;
+  // The first packet only starts the clock, so rates use the intervals.
+  // A flood that lands within one clock tick has no rate to report.
+  out->rateMeasured = floodPackets > 1 && out->floodUs > 0;
+  if (out->rateMeasured) {
+    uint64_t intervals = floodPackets - 1;
+    out->notifyPerSec = (uint32_t)(intervals * 1000000ULL / out->floodUs);
+    uint64_t bits = (uint64_t)(floodBytes - floodBytes / floodPackets) * 8;
+    out->kbps = (uint32_t)(bits * 1000ULL / out->floodUs);
+  }
+}
@@ -0,0 +1,48 @@
+#include "deadline_timer.h"
+
+static uint32_t deadlines[TIMER_SLOTS];
+static uint8_t activeMask = 0;
+
+void timerStart(uint8_t id, uint32_t delayMs, uint32_t nowMs) {
+  if (id >= TIMER_SLOTS) return;
+  deadlines[id] = nowMs + delayMs;
+  activeMask |= (uint8_t)(1 << id);
+}
+
+void timerCancel(uint8_t id) {
+  if (id >= TIMER_SLOTS) return;
+  activeMask &= (uint8_t)~(1 << id);
+}
+
+bool timerActive(uint8_t id) {
+  return id < TIMER_SLOTS && (activeMask & (1 << id)) != 0;
+}
+
+int timerPopExpired(uint32_t nowMs) {
+  int due = -1;
+  int32_t mostOverdue = -1;
+  for (int id = 0; id < TIMER_SLOTS; id++) {
+    if (!(activeMask & (1 << id))) continue;
+    int32_t late = (int32_t)(nowMs - deadlines[id]);
+    // Fire in deadline order when several are due at once.
+    if (late >= 0 && late > mostOverdue) {
+      mostOverdue = late;
+      due = id;
+    }
+  }
+  if (due >= 0) {
+    activeMask &= (uint8_t)~(1 << due);
+  }
+  return due;
+}
+
+uint32_t timerTimeUntilNext(uint32_t nowMs) {
+  uint32_t next = TIMER_NONE;
+  for (int id = 0; id < TIMER_SLOTS; id++) {
+    if (!(activeMask & (1 << id))) continue;
+    int32_t remaining = (int32_t)(deadlines[id] - nowMs);
+    if (remaining <= 0) return 0;
+    if ((uint32_t)remaining < next) next = (uint32_t)remaining;
+  }
+  return next;
+}
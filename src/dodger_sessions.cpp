@@ -0,0 +1,196 @@
+#include <string.h>
+#include "dodger_sessions.h"
+#include "conn_profiles.h"
+#include "game_config.h"
+#include "game_protocol.h"
+
+SessionTable sessions;
+
+static void sessionInit(int i, const uint8_t* address) {
+  memcpy(sessions.address[i], address, SESSION_ADDRESS_LEN);
+  sessions.round[i] = 1;
+  sessions.choice[i] = 0;
+  sessions.state[i] = SESSION_LINKED;
+  sessions.result[i] = 0;
+  sessions.shot[i] = 0;
+}
+
+// --- Links ---
+int sessionLink(const uint8_t* address, TransportPeer peer) {
+  int slot = -1;
+  for (int i = 0; i < sessions.count; i++) {
+    if (memcmp(sessions.address[i], address, SESSION_ADDRESS_LEN) == 0) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0 && sessions.count < MAX_DODGERS) {
+    slot = sessions.count++;
+    sessionInit(slot, address);
+  } else if (slot < 0) {
+    // A dodger that is away mid-match keeps its session until the match
+    // ends without it.
+    for (int i = 0; i < sessions.count; i++) {
+      if (!sessions.up[i] && !sessionPlaying(i)) {
+        slot = i;
+        sessionInit(slot, address);
+        break;
+      }
+    }
+    if (slot < 0) return -1;
+  }
+  sessions.up[slot] = true;
+  sessions.peer[slot] = peer;
+  sessions.profile[slot] = PROFILE_NONE;  // a new link starts on default parameters
+  return slot;
+}
+
+void sessionUnlink(TransportPeer peer) {
+  int i = sessionFind(peer);
+  if (i < 0) return;
+  sessions.up[i] = false;
+  sessions.profile[i] = PROFILE_NONE;
+}
+
+int sessionFind(TransportPeer peer) {
+  for (int i = 0; i < sessions.count; i++) {
+    if (sessions.up[i] && sessions.peer[i] == peer) return i;
+  }
+  return -1;
+}
+
+int sessionsUp() {
+  int up = 0;
+  for (int i = 0; i < sessions.count; i++) {
+    if (sessions.up[i]) up++;
+  }
+  return up;
+}
+
+// --- Moves ---
+void sessionJoin(int i) {
+  if (sessions.state[i] != SESSION_LINKED) return;
+  sessions.state[i] = SESSION_WAIT_CHOICE;
+  sessions.round[i] = 1;
+  sessions.choice[i] = 0;
+}
+
+bool sessionChoose(int i, uint8_t round, uint8_t choice) {
+  switch (sessions.state[i]) {
+    case SESSION_WAIT_CHOICE:
+    case SESSION_CHOSEN:
+      if (round != sessions.round[i]) return false;
+      sessions.state[i] = SESSION_CHOSEN;
+      break;
+    case SESSION_SHOT:
+      // The dodger saw its result and chose for the next round already.
+      if (round != sessions.round[i] + 1) return false;
+      break;
+    case SESSION_OUT:
+      // The dodger restarted first; held for the next match.
+      if (round != 1) return false;
+      break;
+    default:
+      return false;
+  }
+  sessions.choice[i] = choice;
+  return true;
+}
+
+// --- Match ---
+bool sessionPlaying(int i) {
+  uint8_t state = sessions.state[i];
+  return state == SESSION_WAIT_CHOICE || state == SESSION_CHOSEN || state == SESSION_SHOT;
+}
+
+int sessionsReady(int* playing) {
+  int waiting = 0, chosen = 0;
+  for (int i = 0; i < sessions.count; i++) {
+    if (!sessions.up[i]) continue;
+    if (sessions.state[i] == SESSION_CHOSEN) chosen++;
+    else if (sessions.state[i] == SESSION_WAIT_CHOICE) waiting++;
+  }
+  *playing = waiting + chosen;
+  return chosen;
+}
+
+int sessionsLowestRound() {
+  int lowest = 0;
+  for (int i = 0; i < sessions.count; i++) {
+    if (sessions.up[i] && sessionPlaying(i) && (lowest == 0 || sessions.round[i] < lowest)) lowest = sessions.round[i];
+  }
+  return lowest;
+}
+
+int sessionShotFor(int i, uint8_t round) {
+  return sessions.shotRound[i] == round ? sessions.shot[i] : 0;
+}
+
+int sessionsShoot(int shot, int* shotCount) {
+  int hits = 0, shotAt = 0;
+  for (int i = 0; i < sessions.count; i++) {
+    if (sessions.state[i] != SESSION_CHOSEN) continue;
+    bool safe = sessions.choice[i] != shot;
+    sessions.result[i] = SNAP_SHOT_FIRED | (safe ? SNAP_RESULT_SAFE : 0);
+    sessions.shot[i] = (uint8_t)shot;
+    sessions.shotRound[i] = sessions.round[i];
+    sessions.choice[i] = 0;
+    sessions.state[i] = SESSION_SHOT;
+    shotAt++;
+    if (!safe) hits++;
+  }
+  if (shotCount != nullptr) *shotCount = shotAt;
+  return hits;
+}
+
+bool sessionsAdvance() {
+  for (int i = 0; i < sessions.count; i++) {
+    if (sessions.state[i] == SESSION_SHOT) {
+      if (!(sessions.result[i] & SNAP_RESULT_SAFE)) {
+        sessions.state[i] = SESSION_OUT;
+        sessions.choice[i] = 0;
+      } else if (sessions.round[i] >= MAX_ROUNDS) {
+        sessions.state[i] = SESSION_OUT;
+        sessions.choice[i] = 0;
+        sessions.survivors++;
+      } else {
+        sessions.round[i]++;
+        sessions.state[i] = sessions.choice[i] != 0 ? SESSION_CHOSEN : SESSION_WAIT_CHOICE;
+      }
+    }
+  }
+  return sessionsEndIfOver();
+}
+
+// The same rule as sessionsReady(): only linked sessions hold the match up.
+bool sessionsEndIfOver() {
+  bool anyOut = false;
+  for (int i = 0; i < sessions.count; i++) {
+    if (sessions.state[i] == SESSION_OUT) anyOut = true;
+    else if (sessions.up[i] && sessionPlaying(i)) return false;
+  }
+  if (!anyOut) return false;
+  for (int i = 0; i < sessions.count; i++) {
+    if (!sessionPlaying(i)) continue;
+    // Away when the match ended: out, neither hit nor a survivor.
+    sessions.state[i] = SESSION_OUT;
+    sessions.choice[i] = 0;
+    sessions.result[i] = 0;
+  }
+  return true;
+}
+
+void sessionsRestart() {
+  for (int i = 0; i < sessions.count; i++) {
+    uint8_t state = sessions.state[i];
+    if (state == SESSION_LINKED) continue;
+    // Only a choice held on the game-over screen is one for round 1.
+    uint8_t held = (state == SESSION_OUT || sessions.round[i] == 1) ? sessions.choice[i] : 0;
+    if (state == SESSION_SHOT) held = 0;
+    sessions.round[i] = 1;
+    sessions.choice[i] = held;
+    sessions.state[i] = held != 0 ? SESSION_CHOSEN : SESSION_WAIT_CHOICE;
+    sessions.result[i] = 0;
+  }
+  sessions.survivors = 0;
+}
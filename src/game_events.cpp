@@ -0,0 +1,31 @@
+#include "game_events.h"
+
+static EventGroupHandle_t loopEvents = nullptr;
+static volatile uint32_t touchInterruptUs = 0;
+
+static void IRAM_ATTR onTouchInterrupt() {
+  BaseType_t woken = pdFALSE;
+  touchInterruptUs = micros();
+  xEventGroupSetBitsFromISR(loopEvents, EVT_TOUCH, &woken);
+  if (woken == pdTRUE) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void eventsInit() {
+  loopEvents = xEventGroupCreate();
+  pinMode(TOUCH_INT_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(TOUCH_INT_PIN), onTouchInterrupt, FALLING);
+}
+
+void postEvent(EventBits_t bits) {
+  xEventGroupSetBits(loopEvents, bits);
+}
+
+uint32_t lastTouchInterruptUs() {
+  return touchInterruptUs;
+}
+
+EventBits_t waitForEvents(uint32_t timeoutMs) {
+  return xEventGroupWaitBits(loopEvents, EVT_ALL, pdTRUE, pdFALSE, pdMS_TO_TICKS(timeoutMs)) & EVT_ALL;
+}
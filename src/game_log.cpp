@@ -0,0 +1,218 @@
+#include "game_log.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0,
+              "LOG_RING_SIZE must be a power of two");
+
+// --- Bounded Multi-Producer Ring ---
+// Each cell carries a sequence number (Vyukov's bounded queue): a producer
+// claims a slot by advancing enqueuePos with a CAS, fills it, then
+// publishes it by bumping the cell's sequence. The drain task is the only
+// consumer.
+struct LogCell {
+  std::atomic<uint32_t> sequence;
+  LogRecord record;
+};
+
+static LogCell cells[LOG_RING_SIZE];
+static std::atomic<uint32_t> enqueuePos{0};
+static uint32_t dequeuePos = 0;             // drain task only
+static std::atomic<uint32_t> dropped{0};
+static uint32_t reportedDropped = 0;        // drain task only
+
+static void logTask(void* param) {
+  for (;;) {
+    if (logDrain() == 0) {
+      vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+    }
+  }
+}
+
+void logInit() {
+  for (uint32_t i = 0; i < LOG_RING_SIZE; i++) {
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  xTaskCreate(logTask, "log", 3072, nullptr, 1, nullptr);
+}
+
+bool logPush(uint8_t level, LogFormat fmt, const LogArg* args, uint8_t argc, uint8_t strMask) {
+  uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+  LogCell* cell;
+  for (;;) {
+    cell = &cells[pos & (LOG_RING_SIZE - 1)];
+    uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);  // ring full
+      return false;
+    } else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  cell->record.ms = millis();
+  cell->record.level = level;
+  cell->record.argc = argc;
+  cell->record.strMask = strMask;
+  cell->record.fmt = fmt;
+  memcpy(cell->record.args, args, argc * sizeof(LogArg));
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+static bool logPop(LogRecord* out) {
+  LogCell* cell = &cells[dequeuePos & (LOG_RING_SIZE - 1)];
+  uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+  if ((int32_t)(seq - (dequeuePos + 1)) < 0) return false;
+  *out = cell->record;
+  cell->sequence.store(dequeuePos + LOG_RING_SIZE, std::memory_order_release);
+  dequeuePos++;
+  return true;
+}
+
+uint32_t logDroppedCount() {
+  return dropped.load(std::memory_order_relaxed);
+}
+
+#if LOG_TOKENIZED
+// --- Binary Frames (drain task) ---
+static_assert(4 + 1 + 5 + LOG_MAX_ARGS * (5 + LOG_MAX_STRING) <= 255,
+              "tokenized log payload must fit the one-byte length");
+
+static size_t putVarint(uint8_t* out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+static void writeRecord(const LogRecord& rec) {
+  // sync + length + token + level/argc + ms + args + checksum, all bounded
+  uint8_t frame[2 + 4 + 1 + 5 + LOG_MAX_ARGS * (5 + LOG_MAX_STRING) + 1];
+  uint8_t* payload = frame + 2;
+  size_t len = 0;
+  for (int i = 0; i < 4; i++) {
+    payload[len++] = (uint8_t)(rec.fmt >> (8 * i));
+  }
+  payload[len++] = (uint8_t)(rec.level << 4 | rec.argc);
+  len += putVarint(payload + len, rec.ms);
+  for (uint8_t i = 0; i < rec.argc; i++) {
+    if (rec.strMask & (1u << i)) {
+      const char* str = (const char*)rec.args[i];
+      size_t strLen = str != nullptr ? strnlen(str, LOG_MAX_STRING) : 0;
+      len += putVarint(payload + len, strLen);
+      memcpy(payload + len, str, strLen);
+      len += strLen;
+    } else {
+      int32_t v = (int32_t)rec.args[i];
+      len += putVarint(payload + len, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));  // zigzag
+    }
+  }
+  uint8_t check = 0;
+  for (size_t i = 0; i < len; i++) check ^= payload[i];
+  frame[0] = LOG_FRAME_SYNC;
+  frame[1] = (uint8_t)len;
+  payload[len] = check;
+  Serial.write(frame, len + 3);
+}
+#else
+// --- Formatting (drain task) ---
+// Expands the record's format one conversion at a time, handing each
+// argument to snprintf with a spec rebuilt for a 32-bit value.
+static size_t formatRecord(const LogRecord& rec, char* out, size_t size) {
+  size_t len = 0;
+  uint8_t argi = 0;
+  const char* p = rec.fmt;
+  while (*p != '\0' && len + 1 < size) {
+    if (*p != '%') {
+      out[len++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[len++] = '%';
+      p += 2;
+      continue;
+    }
+    // Copy flags and width, drop length modifiers, keep the conversion.
+    char spec[12];
+    size_t specLen = 0;
+    spec[specLen++] = *p++;
+    while (*p != '\0' && strchr("-+ #0123456789", *p) != nullptr && specLen < sizeof(spec) - 3) {
+      spec[specLen++] = *p++;
+    }
+    while (*p == 'l' || *p == 'h' || *p == 'z') p++;
+    char conv = *p;
+    if (conv == '\0') break;
+    p++;
+    LogArg arg = argi < rec.argc ? rec.args[argi] : 0;
+    argi++;
+    int n;
+    if (conv == 's') {
+      spec[specLen++] = 's';
+      spec[specLen] = '\0';
+      const char* str = (const char*)arg;
+      n = snprintf(out + len, size - len, spec, str != nullptr ? str : "(null)");
+    } else if (conv == 'c') {
+      spec[specLen++] = 'c';
+      spec[specLen] = '\0';
+      n = snprintf(out + len, size - len, spec, (int)arg);
+    } else if (conv == 'u' || conv == 'x' || conv == 'X') {
+      spec[specLen++] = 'l';
+      spec[specLen++] = conv;
+      spec[specLen] = '\0';
+      n = snprintf(out + len, size - len, spec, (unsigned long)(uint32_t)arg);
+    } else {
+      spec[specLen++] = 'l';
+      spec[specLen++] = 'd';
+      spec[specLen] = '\0';
+      n = snprintf(out + len, size - len, spec, (long)(int32_t)arg);
+    }
+    if (n < 0) break;
+    len += (size_t)n;
+    if (len >= size) len = size - 1;
+  }
+  out[len] = '\0';
+  return len;
+}
+
+static const char levelTags[] = { '-', 'E', 'W', 'I', 'D' };
+
+static void writeRecord(const LogRecord& rec) {
+  char line[160];
+  int prefix = snprintf(line, sizeof(line), "%7lu %c ", (unsigned long)rec.ms,
+                        rec.level <= LOG_LEVEL_DEBUG ? levelTags[rec.level] : '?');
+  formatRecord(rec, line + prefix, sizeof(line) - prefix);
+  Serial.println(line);
+}
+#endif
+
+int logDrain() {
+  LogRecord rec;
+  int written = 0;
+  while (logPop(&rec)) {
+    writeRecord(rec);
+    written++;
+  }
+  uint32_t lost = logDroppedCount();
+  if (lost != reportedDropped) {
+    rec.ms = millis();
+    rec.level = LOG_LEVEL_WARN;
+    rec.argc = 1;
+    rec.strMask = 0;
+    rec.fmt = LOG_FMT("Log: %u records dropped (ring full).");
+    rec.args[0] = (LogArg)(lost - reportedDropped);
+    writeRecord(rec);
+    reportedDropped = lost;
+  }
+  return written;
+}
@@ -0,0 +1,66 @@
+#include "game_protocol.h"
+#include "game_config.h"
+
+size_t gameFrameEncode(const GameFrame& frame, uint8_t* buf, size_t bufLen) {
+  if (buf == nullptr || bufLen < GAME_FRAME_SIZE) return 0;
+  buf[0] = GAME_PROTOCOL_VERSION;
+  buf[1] = frame.opcode;
+  buf[2] = frame.round;
+  buf[3] = frame.choice;
+  buf[4] = frame.flags;
+  buf[5] = (uint8_t)(frame.seq & 0xFF);
+  buf[6] = (uint8_t)(frame.seq >> 8);
+  buf[11] = (uint8_t)(frame.inputUs & 0xFF);
+  buf[12] = (uint8_t)(frame.inputUs >> 8);
+  gameFrameStampSend(buf, frame.sentUs, frame.encodeUs);
+  return GAME_FRAME_SIZE;
+}
+
+void gameFrameStampSend(uint8_t* buf, uint32_t sentUs, uint16_t encodeUs) {
+  buf[7] = (uint8_t)(sentUs & 0xFF);
+  buf[8] = (uint8_t)(sentUs >> 8);
+  buf[9] = (uint8_t)(sentUs >> 16);
+  buf[10] = (uint8_t)(sentUs >> 24);
+  buf[13] = (uint8_t)(encodeUs & 0xFF);
+  buf[14] = (uint8_t)(encodeUs >> 8);
+}
+
+uint16_t gameFrameClampUs(uint32_t us) {
+  return us > 0xFFFF ? 0xFFFF : (uint16_t)us;
+}
+
+FrameDecodeResult gameFrameDecode(const uint8_t* data, size_t len, GameFrameView* view) {
+  if (data == nullptr || len < GAME_FRAME_SIZE) return FRAME_TOO_SHORT;
+  if (data[0] != GAME_PROTOCOL_VERSION) return FRAME_BAD_VERSION;
+  switch (data[1]) {
+    case OP_DODGER_CHOICE:
+    case OP_SHOT:
+      if (data[3] < 1 || data[3] > NUM_BARRELS) return FRAME_BAD_CHOICE;
+      break;
+    case OP_SYNC_REQUEST:
+    case OP_SNAPSHOT:
+    case OP_PING:
+    case OP_PONG:
+    case OP_BENCH_PING:
+    case OP_BENCH_PONG:
+    case OP_BENCH_FLOOD:
+    case OP_BENCH_DATA:
+      if (data[3] > NUM_BARRELS) return FRAME_BAD_CHOICE;
+      break;
+    default:
+      return FRAME_BAD_OPCODE;
+  }
+  view->bytes = data;
+  return FRAME_OK;
+}
+
+const char* frameDecodeResultName(FrameDecodeResult result) {
+  switch (result) {
+    case FRAME_OK:          return "ok";
+    case FRAME_TOO_SHORT:   return "too short";
+    case FRAME_BAD_VERSION: return "bad version";
+    case FRAME_BAD_OPCODE:  return "bad opcode";
+    case FRAME_BAD_CHOICE:  return "bad choice";
+  }
+  return "unknown";
+}
@@ -0,0 +1,134 @@
+#include <Arduino.h>
+#include "latency_stats.h"
+
+// --- Clock offset ---
+static bool offsetValid = false;
+static int32_t offsetUs = 0;
+static uint32_t offsetErrorUs = 0;
+
+static bool candidateValid = false;
+static int32_t candidateOffsetUs = 0;
+static uint32_t candidateRttUs = 0;
+
+void clockSyncProbeStart() {
+  candidateValid = false;
+}
+
+void clockSyncSample(uint32_t pingSentUs, uint32_t pongRxUs, uint32_t peerSentUs, uint32_t peerTurnaroundUs) {
+  uint32_t peerRxUs = peerSentUs - peerTurnaroundUs;
+  uint32_t elapsed = pongRxUs - pingSentUs;
+  if (peerTurnaroundUs > elapsed) return;
+  uint32_t rtt = elapsed - peerTurnaroundUs;
+  // NTP-style: the midpoints of the two legs line up.
+  int32_t offset = ((int32_t)(peerRxUs - pingSentUs) + (int32_t)(peerSentUs - pongRxUs)) / 2;
+  if (!candidateValid || rtt < candidateRttUs) {
+    candidateValid = true;
+    candidateOffsetUs = offset;
+    candidateRttUs = rtt;
+  }
+}
+
+bool clockSyncProbeEnd() {
+  if (!candidateValid) return false;
+  offsetValid = true;
+  offsetUs = candidateOffsetUs;
+  offsetErrorUs = candidateRttUs / 2;
+  return true;
+}
+
+bool clockSyncValid() {
+  return offsetValid;
+}
+
+int32_t clockOffsetUs() {
+  return offsetUs;
+}
+
+uint32_t clockErrorUs() {
+  return offsetErrorUs;
+}
+
+// --- Breakdown and histogram ---
+// Upper bounds of the total-latency buckets in milliseconds; the last
+// bucket takes everything above.
+static const uint16_t bucketLimitMs[LATENCY_BUCKETS - 1] = { 10, 20, 30, 50, 75, 100, 150, 250 };
+static uint32_t buckets[LATENCY_BUCKETS];
+static uint32_t samples = 0;
+static int64_t stageSums[6];
+static int32_t minTotalUs = 0;
+static int32_t maxTotalUs = 0;
+
+bool latencyMeasure(uint32_t sentUs, uint16_t inputUs, uint16_t encodeUs,
+                    uint32_t rxUs, uint32_t handledUs,
+                    uint32_t appliedUs, uint32_t renderedUs,
+                    LatencyBreakdown* out) {
+  if (!offsetValid) return false;
+  out->inputUs = inputUs;
+  out->encodeUs = encodeUs;
+  // sentUs is on the peer's clock: local = peer - offset.
+  out->radioUs = (int32_t)(rxUs - sentUs) + offsetUs;
+  out->decodeUs = (int32_t)(handledUs - rxUs);
+  out->renderUs = (int32_t)(renderedUs - appliedUs);
+  out->totalUs = out->inputUs + out->encodeUs + out->radioUs + out->decodeUs + out->renderUs;
+  return true;
+}
+
+void latencyRecord(const LatencyBreakdown& sample) {
+  int bucket = 0;
+  while (bucket < LATENCY_BUCKETS - 1 && sample.totalUs >= (int32_t)bucketLimitMs[bucket] * 1000) {
+    bucket++;
+  }
+  buckets[bucket]++;
+  const int32_t* stages = &sample.inputUs;
+  for (int i = 0; i < 6; i++) stageSums[i] += stages[i];
+  if (samples == 0 || sample.totalUs < minTotalUs) minTotalUs = sample.totalUs;
+  if (samples == 0 || sample.totalUs > maxTotalUs) maxTotalUs = sample.totalUs;
+  samples++;
+}
+
+void latencyReset() {
+  for (int i = 0; i < LATENCY_BUCKETS; i++) buckets[i] = 0;
+  for (int i = 0; i < 6; i++) stageSums[i] = 0;
+  samples = 0;
+}
+
+uint32_t latencyCount() {
+  return samples;
+}
+
+void latencyAverage(LatencyBreakdown* out) {
+  int32_t* stages = &out->inputUs;
+  for (int i = 0; i < 6; i++) {
+    stages[i] = samples > 0 ? (int32_t)(stageSums[i] / (int64_t)samples) : 0;
+  }
+}
+
+void latencyPrint(const char* direction) {
+  Serial.printf("Latency %s: %lu moves", direction, (unsigned long)samples);
+  if (offsetValid) {
+    Serial.printf(", clock offset %ld us +/- %lu us\n", (long)offsetUs, (unsigned long)offsetErrorUs);
+  } else {
+    Serial.println(", clock offset not measured yet");
+  }
+  if (samples == 0) return;
+  uint32_t peak = 1;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    if (buckets[i] > peak) peak = buckets[i];
+  }
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    char bar[33];
+    int len = (int)(buckets[i] * 32 / peak);
+    for (int j = 0; j < len; j++) bar[j] = '#';
+    bar[len] = '\0';
+    if (i < LATENCY_BUCKETS - 1) {
+      Serial.printf("  <%4u ms %5lu %s\n", bucketLimitMs[i], (unsigned long)buckets[i], bar);
+    } else {
+      Serial.printf("  >=%3u ms %5lu %s\n", bucketLimitMs[i - 1], (unsigned long)buckets[i], bar);
+    }
+  }
+  LatencyBreakdown avg;
+  latencyAverage(&avg);
+  Serial.printf("  mean us: input %ld, encode %ld, radio %ld, decode %ld, render %ld = %ld (min %ld, max %ld)\n",
+                (long)avg.inputUs, (long)avg.encodeUs, (long)avg.radioUs, (long)avg.decodeUs,
+                (long)avg.renderUs, (long)avg.totalUs, (long)minTotalUs, (long)maxTotalUs);
+}
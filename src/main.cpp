@@ -6,19 +6,49 @@
 #include <BLEScan.h>
 #include <BLEAdvertisedDevice.h>
 #include <BLERemoteCharacteristic.h>
-
-// --- BLE UUID Definitions ---
-#define SERVICE_UUID           "ce062b2f-e42b-4239-b951-f9d4b4abe0ff"
-#define CHARACTERISTIC_UUID    "46f27243-ac2d-4b01-b909-4b5711a23a8d"
-
-// --- Game Constants ---
-#define MAX_ROUNDS 5
-#define NUM_BARRELS 3
+#include "game_config.h"
+#include "screen_model.h"
+#include "render_target.h"
+#include "game_events.h"
+#include "deadline_timer.h"
+#include "game_protocol.h"
+#include "dodger_sessions.h"
+#include "ble_service.h"
+#include "spectator_broadcast.h"
+#include "spsc_ring.h"
+#include "conn_profiles.h"
+#include "bench_stats.h"
+#include "game_log.h"
+#include "alloc_trace.h"
+#include "mem_monitor.h"
+#include "serial_console.h"
+#include "profiler.h"
+#include "trace.h"
+#include "latency_stats.h"
+#include "transport.h"
+#include "transport_adv.h"
+#include "transport_ble.h"
+#include "transport_espnow.h"
+#include "transport_host.h"
 
 // --- Role Definitions ---
-enum Role { ROLE_UNDEFINED, ROLE_SHOOTER, ROLE_DODGER };
+enum Role { ROLE_UNDEFINED, ROLE_SHOOTER, ROLE_DODGER, ROLE_BENCH, ROLE_SPECTATOR };
 Role deviceRole = ROLE_UNDEFINED;
 
+// --- Link Choices ---
+// The role screen's link toggle steps through these.
+struct LinkChoice {
+  const char* label;
+  const TransportBackend* backend;
+};
+const LinkChoice linkChoices[] = {
+  { "BLE link", &bleTransport },
+  { "ESP-NOW link", &espNowTransport },
+  { "Advert link", &advTransport },
+};
+const int linkChoiceCount = sizeof(linkChoices) / sizeof(linkChoices[0]);
+int linkChoice = 0;  // index into linkChoices
+
 // --- Shooter Game States ---
 enum ShooterState { SHOOTER_WAIT_DODGER, SHOOTER_WAIT_INPUT, SHOOTER_SHOW_RESULT, SHOOTER_GAME_OVER };
 ShooterState shooterState = SHOOTER_WAIT_DODGER;
@@ -30,49 +60,144 @@ DodgerState dodgerState = DODGER_WAIT_INPUT;
 // --- Global Game Variables ---
 int roundNumber = 1;
 bool gameOver = false;
-bool roundResultSafe = false; // true if dodger successfully hides this round
+bool roundResultSafe = false; // true if dodger successfully hides this round (shooter: if any dodger survived)
 
 // Choices for current round (values 1, 2, or 3)
 int dodgerChoice = 0;
 int shooterChoice = 0;
 
-// --- BLE Communication Flags ---
-volatile bool deviceConnected = false;      // For BLE Server
-volatile bool dodgerInputReceived = false;    // When shooter receives dodger input via BLE
-volatile bool notificationReceived = false;   // For BLE Client notifications
-int receivedShooterChoice = 0;                  // Received shooter barrel (as int)
+// Shooter: the last shot's outcome across the dodger sessions (dodger_sessions.h).
+int shotCount = 0;
+int shotHits = 0;
+
+// --- BLE Communication State ---
+volatile bool deviceConnected = false;      // shooter: a link the transport made itself is up
+uint16_t txSeq = 0;                         // Sequence number of our next frame
+
+// Dodger connections to the BLE server, opened and closed on the Bluedroid
+// task and applied to the session table by the loop.
+struct DodgerLinkEvent {
+  bool up;
+  TransportPeer peer;
+  uint8_t address[SESSION_ADDRESS_LEN];
+};
+SpscRing<DodgerLinkEvent, 8> dodgerLinkEvents;
+volatile uint8_t serverLinkCount = 0;       // written by the BLE task
+
+// Frames received by the BLE callbacks, consumed by loop(). The Bluedroid
+// task is the only producer and the loop task the only consumer.
+SpscRing<GameFrame, 8> rxMessages;
+uint32_t reportedRxOverflows = 0;
+
+// Shot the dodger's loop has accepted but the state machine has not used yet.
+int pendingChoice = 0;
+int pendingRound = 0;
 
 // --- BLE Objects for Shooter (Server) ---
 BLEServer* pServer = nullptr;
 BLEService* pService = nullptr;
-BLECharacteristic* pCharacteristic = nullptr;
+
+// --- RTT Probe ---
+// A short burst of OP_PING frames, each sent when the previous OP_PONG
+// returns, measuring application-level round trips over the current link.
+// A ping unanswered within the timeout is a lost sample and the next one
+// goes out; only a run of losses ends the probe early.
+const int rttProbePings = 5;
+const int rttProbeMaxLost = 3;            // consecutive lost pings
+const uint32_t rttProbeSettleTime = 500;  // let new parameters take effect
+const uint32_t rttProbeTimeout = 1000;    // per ping
+int rttProbeRemaining = 0;
+int rttLost = 0, rttLostInRow = 0;
+uint16_t rttPingSeq = 0;
+uint32_t rttPingSentUs = 0;
+uint32_t rttMinUs = 0, rttMaxUs = 0, rttSumUs = 0;
+int rttSamples = 0;
+const uint32_t clockResyncInterval = 60000;  // re-estimate the clock offset against drift
+
+// --- Move latency (latency_stats.h) ---
+// The peer's last accepted move, from arrival until it is on screen.
+enum MoveTimingState { MOVE_TIMING_IDLE, MOVE_TIMING_PENDING, MOVE_TIMING_RENDER };
+MoveTimingState moveTimingState = MOVE_TIMING_IDLE;
+GameFrame moveTiming;
+uint32_t moveHandledUs = 0;
+uint32_t moveAppliedUs = 0;
 
 // --- BLE Objects for Dodger (Client) ---
-BLERemoteCharacteristic* pRemoteCharacteristic = nullptr;
 BLEClient* pClient = nullptr;
 
-// --- UI Layout Constants (Assuming a 320x240 Screen) ---
-const int screenWidth = 320;
-const int screenHeight = 240;
+// --- Dodger Link State ---
+// Scan, connect, service discovery and notify registration run as a state
+// machine stepped from loop(). The blocking Bluedroid calls (connect and
+// discovery) run in a short-lived task that reports progress in connectStep.
+enum LinkState { LINK_IDLE, LINK_SCANNING, LINK_CONNECTING, LINK_SYNCING, LINK_READY };
+enum ConnectStep { STEP_CONNECT, STEP_DISCOVER, STEP_SUBSCRIBE, STEP_DONE, STEP_FAILED };
+LinkState linkState = LINK_IDLE;
+volatile ConnectStep connectStep = STEP_CONNECT;  // written by the connect task
+volatile bool serverFound = false;                // written by the scan callback
+volatile bool scanWindowEnded = false;            // written by the scan callback
+volatile bool linkLost = false;                   // written by the client callback
+esp_bd_addr_t serverAddress;
+esp_ble_addr_type_t serverAddressType = BLE_ADDR_TYPE_PUBLIC;
+unsigned long linkStartTime = 0;    // scan started
+unsigned long serverFoundTime = 0;  // matching advertisement seen
+const uint32_t scanWindowSeconds = 5;
+const uint32_t linkTickInterval = 1000; // progress redraw while connecting
+
+// Reconnect supervision: retries back off from reconnectBaseDelay up to
+// reconnectMaxDelay, and every (re)connect asks the shooter for a snapshot
+// so an interrupted match resumes where it left off.
+const uint32_t reconnectBaseDelay = 500;  // milliseconds
+const uint32_t reconnectMaxDelay = 8000;  // milliseconds
+uint8_t reconnectAttempts = 0;
+bool matchInterrupted = false;            // link dropped during a match
+unsigned long linkLostTime = 0;
+
+// --- Benchmark Mode ---
+// The bench role connects to a shooter like a dodger, then measures the
+// link over the ping characteristic: timed round trips, then a flood of
+// notifications that the shooter streams from its loop.
+enum BenchState { BENCH_RTT, BENCH_FLOOD, BENCH_DONE };
+BenchState benchState = BENCH_RTT;
+int benchPingsSent = 0;
+uint16_t benchPingSeq = 0;
+uint32_t benchPingSentUs = 0;
+uint32_t benchFloodSeen = 0;                // flood packets at the last check
+BenchSummary benchSummary;
+bool benchResultsShown = false;
+const uint32_t benchPingTimeout = 1000;     // milliseconds per round trip
+const uint32_t benchFloodIdleTimeout = 2000;
+const int benchFloodBurst = 16;             // notifications per shooter loop pass
+int benchFloodRemaining = 0;                // shooter side
+uint16_t benchFloodSeq = 0;
+TransportPeer benchFloodPeer = 0;           // the bench client that asked
 
-// Role selection button dimensions
-const int roleButtonY = 80;
-const int roleButtonWidth = screenWidth / 2; // 160
-const int roleButtonHeight = 80;
+// --- Spectator Mode ---
+// The spectator only scans for the shooter's broadcast (spectator_broadcast.h).
+SpectatorSnapshot spectatorView;
+bool spectatorWatching = false;  // a shooter is being heard
 
-// Barrel button dimensions and positions
-const int buttonWidth = 80;
-const int buttonHeight = 50;
-const int buttonSpacing = 20;
-const int buttonY = 180;
-const int button1X = 40;
-const int button2X = button1X + buttonWidth + buttonSpacing;  // 40+80+20 = 140
-const int button3X = button2X + buttonWidth + buttonSpacing;  // 140+80+20 = 240
+// --- Memory Monitor Overlay ---
+bool memOverlay = false;  // toggled with the "mem overlay" console command
 
 // --- Touch Debounce ---
 unsigned long lastTouchTime = 0;
 const unsigned long touchDebounce = 300; // milliseconds
 
+// --- Main Loop Pacing ---
+// The loop sleeps until an event arrives; this only bounds how long M5
+// housekeeping (buttons, power) can go without an update.
+const uint32_t loopIdleTimeout = 1000; // milliseconds
+bool gameOverScreenShown = false;
+
+// --- Timed Transitions ---
+enum GameTimer { TIMER_SPLASH, TIMER_ROUND_RESULT, TIMER_LINK_TICK, TIMER_LINK_RETRY, TIMER_RTT_PROBE, TIMER_BENCH,
+                 TIMER_MOVE_REPEAT };
+const uint32_t splashTime = 1000;        // role banner after selection
+const uint32_t resultDisplayTime = 1500; // round result before advancing
+const uint32_t moveRepeatInterval = 500; // dodger repeats its choice until the shot arrives
+bool splashActive = false;
+uint32_t timersHeldBySplash = 0;         // fired during the splash, handled after it
+
 // --- Helper: Check if a point lies in a rectangle ---
 static bool pointInRect(int px, int py, int rx, int ry, int rw, int rh) {
   return (px >= rx && px <= rx + rw && py >= ry && py <= ry + rh);
@@ -82,43 +207,584 @@ static bool pointInRect(int px, int py, int rx, int ry, int rw, int rh) {
 void drawRoleSelectionScreen();
 void drawGameScreen();
 void drawGameOverScreen();
+void drawCurrentScreen();
+void updateMemOverlay();
 void resetGame();
 void setupBLE_Server();
 void setupBLE_Client();
+void startLinkScan();
+void serviceClientLink(uint32_t firedTimers);
+#if ALLOC_TRACE
+void traceRoundAllocations();
+#endif
+#if TRACE
+void traceStateSpans();
+void onTraceCommand(const char* args);
+#endif
+void drawLinkScreen();
+void handleMessage(const GameFrame& msg);
+void startBench();
+void serviceBench(uint32_t firedTimers);
+void handleBenchMessage(const GameFrame& msg);
+void drawBenchScreen();
+void drawSpectatorScreen();
+void onMemCommand(const char* args);
+void onLatCommand(const char* args);
+#if PROFILER
+void onProfCommand(const char* args);
+#endif
+void onLinkCommand(const char* args);
+void onRenderCommand(const char* args);
+
+// --- Helper: Hand a received frame to the loop (BLE task side) ---
+static void queueFrame(const GameFrameView& frame, TransportPeer peer) {
+  GameFrame msg = { frame.opcode(), frame.round(), frame.choice(), frame.flags(), frame.seq(),
+                    frame.sentUs(), frame.inputUs(), frame.encodeUs(), micros(), peer };
+  rxMessages.push(msg);
+  postEvent(EVT_BLE_RX);
+}
 
 // --- BLE Server Callback Classes ---
+// Each connection is one dodger; the loop gives it a session and restarts
+// advertising, connectable while there is room for another.
 class MyServerCallbacks : public BLEServerCallbacks {
-  void onConnect(BLEServer* pServer) {
-    deviceConnected = true;
-    Serial.println("BLE: Client connected.");
+  void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+    DodgerLinkEvent event = { true, param->connect.conn_id, { 0 } };
+    memcpy(event.address, param->connect.remote_bda, SESSION_ADDRESS_LEN);
+    dodgerLinkEvents.push(event);
+    serverLinkCount++;
+    bleTransportSetServerLinked(true);
+    postEvent(EVT_BLE_LINK);
+    TRACE_INSTANT(TRACE_TRACK_BLE, "ble.connected", param->connect.conn_id);
+    LOG_I("BLE: Client connected on connection %u.", param->connect.conn_id);
   }
-  void onDisconnect(BLEServer* pServer) {
-    deviceConnected = false;
-    Serial.println("BLE: Client disconnected.");
-    BLEDevice::startAdvertising();
+  void onDisconnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+    DodgerLinkEvent event = { false, param->disconnect.conn_id, { 0 } };
+    dodgerLinkEvents.push(event);
+    if (serverLinkCount > 0) serverLinkCount--;
+    bleTransportSetServerLinked(serverLinkCount > 0);
+    postEvent(EVT_BLE_LINK);
+    TRACE_INSTANT(TRACE_TRACK_BLE, "ble.disconnected", param->disconnect.conn_id);
+    LOG_I("BLE: Client on connection %u disconnected.", param->disconnect.conn_id);
   }
 };
 
-class MyCharacteristicCallbacks : public BLECharacteristicCallbacks {
-  void onWrite(BLECharacteristic *pCharacteristic) {
-    std::string rxValue = pCharacteristic->getValue();
-    if (rxValue.length() > 0) {
-      dodgerChoice = atoi(rxValue.c_str());
-      dodgerInputReceived = true;
-      Serial.print("BLE: Received dodger choice: ");
-      Serial.println(dodgerChoice);
+// --- Transport Handlers (backend task side) ---
+static void onTransportFrame(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len) {
+  GameFrameView frame;
+  FrameDecodeResult result = gameFrameDecode(data, len, &frame);
+  if (channel == CHANNEL_BENCH) {
+    // Flood packets are only counted here so a burst does not overrun the
+    // frame ring; echo requests and pongs go to the loop like game frames.
+    if (result != FRAME_OK) return;
+    if (frame.opcode() == OP_BENCH_DATA) {
+      benchFloodPacket(len, micros());
+      postEvent(EVT_BLE_RX);
+    } else {
+      queueFrame(frame, peer);
     }
+    return;
+  }
+  if (result != FRAME_OK) {
+    LOG_W("Link: Dropped frame from %s: %s", deviceRole == ROLE_SHOOTER ? "dodger" : "shooter",
+          frameDecodeResultName(result));
+    return;
+  }
+  queueFrame(frame, peer);
+  TRACE_INSTANT(TRACE_TRACK_BLE, "ble.rx", frame.opcode());
+  LOG_D("Link: Received frame, opcode %d", frame.opcode());
+}
+
+// Links the transport sets up itself; the BLE link reports through the
+// server and client callbacks instead.
+static void onTransportLink(bool up) {
+  if (up) {
+    TRACE_INSTANT(TRACE_TRACK_BLE, "ble.connected", 0);
+  } else {
+    TRACE_INSTANT(TRACE_TRACK_BLE, "ble.disconnected", 0);
+  }
+  if (deviceRole == ROLE_SHOOTER) {
+    deviceConnected = up;
+    LOG_I("Link: Dodger %s.", up ? "connected" : "disconnected");
+  } else if (up) {
+    connectStep = STEP_DONE;
+  } else {
+    linkLost = true;
+    LOG_I("Link: Disconnected from shooter.");
+  }
+  postEvent(EVT_BLE_LINK);
+}
+
+// --- BLE Client Connection Callbacks ---
+class MyClientCallbacks : public BLEClientCallbacks {
+  void onConnect(BLEClient* pClient) {
+  }
+  void onDisconnect(BLEClient* pClient) {
+    linkLost = true;
+    postEvent(EVT_BLE_LINK);
+    TRACE_INSTANT(TRACE_TRACK_BLE, "ble.disconnected", 0);
+    LOG_I("BLE Client: Disconnected from server.");
+  }
+};
+
+// --- BLE Client Scan Callbacks ---
+// Stop scanning the moment the shooter's advertisement arrives instead of
+// waiting out the scan window.
+class MyAdvertisedDeviceCallbacks : public BLEAdvertisedDeviceCallbacks {
+  void onResult(BLEAdvertisedDevice advertisedDevice) {
+    if (serverFound || !advertisedDevice.haveServiceUUID() ||
+        !advertisedDevice.isAdvertisingService(BLEUUID(SERVICE_UUID))) {
+      return;
+    }
+    memcpy(serverAddress, *advertisedDevice.getAddress().getNative(), sizeof(esp_bd_addr_t));
+    serverAddressType = advertisedDevice.getAddressType();
+    serverFound = true;
+    BLEDevice::getScan()->stop();
+    postEvent(EVT_BLE_LINK);
   }
 };
 
-// --- BLE Client Notification Callback ---
-static void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
-                           uint8_t* pData, size_t length, bool isNotify) {
-  if (length > 0) {
-    receivedShooterChoice = atoi((const char*)pData);
-    notificationReceived = true;
-    Serial.print("BLE: Notification received, shooter choice: ");
-    Serial.println(receivedShooterChoice);
+static void scanCompleteCallback(BLEScanResults results) {
+  scanWindowEnded = true;
+  postEvent(EVT_BLE_LINK);
+}
+
+// --- BLE Client Connect Task ---
+// Runs the blocking connect and discovery calls off the loop task, then
+// deletes itself. Progress is published through connectStep.
+static void clientConnectTask(void* param) {
+  connectStep = STEP_CONNECT;
+  postEvent(EVT_BLE_LINK);
+  bool ok = false;
+  if (pClient->connect(BLEAddress(serverAddress), serverAddressType)) {
+    connectStep = STEP_DISCOVER;
+    postEvent(EVT_BLE_LINK);
+    BLERemoteService* pRemoteService = pClient->getService(BLEUUID(SERVICE_UUID));
+    BLERemoteCharacteristic* pChar = nullptr;
+    if (pRemoteService != nullptr) {
+      pChar = pRemoteService->getCharacteristic(BLEUUID(CHARACTERISTIC_UUID));
+    }
+    BLERemoteCharacteristic* pPingChar = nullptr;
+    if (pRemoteService != nullptr) {
+      pPingChar = pRemoteService->getCharacteristic(BLEUUID(PING_CHARACTERISTIC_UUID));
+    }
+    bool pingNeeded = (deviceRole == ROLE_BENCH);
+    if (pChar != nullptr && pChar->canNotify() &&
+        (!pingNeeded || (pPingChar != nullptr && pPingChar->canNotify()))) {
+      connectStep = STEP_SUBSCRIBE;
+      postEvent(EVT_BLE_LINK);
+      bleTransportAttach(pChar, pingNeeded ? pPingChar : nullptr);
+      ok = true;
+    } else {
+      LOG_E("BLE Client Error: Shooter service or characteristic missing.");
+      pClient->disconnect();
+    }
+  }
+  connectStep = ok ? STEP_DONE : STEP_FAILED;
+  postEvent(EVT_BLE_LINK);
+  vTaskDelete(nullptr);
+}
+
+// --- Helpers: Encode and send frames to the peer ---
+// To every peer; set peer to address one dodger on the shooter.
+static GameFrame makeFrame(uint8_t opcode, int choice, uint8_t flags) {
+  GameFrame frame = { opcode, (uint8_t)roundNumber, (uint8_t)choice, flags, txSeq++, 0, 0, 0, 0, TRANSPORT_PEER_ALL };
+  return frame;
+}
+
+// Time since the touch that started the player's move, for its inputUs.
+static uint16_t touchInputUs() {
+  return gameFrameClampUs(micros() - lastTouchInterruptUs());
+}
+
+// False if there is no link. The timing fields are stamped last, right
+// before the hand-off.
+static bool sendFrame(const GameFrame& frame) {
+  uint32_t startUs = micros();
+  TRACE_SCOPE(TRACE_TRACK_LOOP, "ble.send");
+  TRACE_INSTANT(TRACE_TRACK_LOOP, "ble.tx", frame.opcode);
+  uint8_t buf[GAME_FRAME_SIZE];
+  size_t len = gameFrameEncode(frame, buf, sizeof(buf));
+  uint32_t sentUs = micros();
+  gameFrameStampSend(buf, sentUs, gameFrameClampUs(sentUs - startUs));
+  return transportSendTo(CHANNEL_GAME, frame.peer, buf, len);
+}
+
+// Benchmark frames use their own channel, padded to payloadSize.
+static bool sendBenchFrame(const GameFrame& frame, size_t payloadSize) {
+  uint8_t buf[BENCH_PAYLOAD_SIZE] = { 0 };
+  gameFrameEncode(frame, buf, sizeof(buf));
+  if (payloadSize < GAME_FRAME_SIZE) payloadSize = GAME_FRAME_SIZE;
+  if (payloadSize > sizeof(buf)) payloadSize = sizeof(buf);
+  return transportSendTo(CHANNEL_BENCH, frame.peer, buf, payloadSize);
+}
+
+static bool sendToShooter(uint8_t opcode, int choice) {
+  return sendFrame(makeFrame(opcode, choice, 0));
+}
+
+// A player's move, carrying the time since their touch.
+static bool sendMove(uint8_t opcode, int choice) {
+  GameFrame move = makeFrame(opcode, choice, 0);
+  move.inputUs = touchInputUs();
+  return sendFrame(move);
+}
+
+// A move the peer may have missed; either side may have lost it, and the
+// answer to a repeated choice is the shot (see MOVE_REPEAT).
+static bool repeatMove(uint8_t opcode, int choice, uint8_t round, TransportPeer peer) {
+  GameFrame move = makeFrame(opcode, choice, MOVE_REPEAT);
+  move.round = round;
+  move.inputUs = 0xFFFF;
+  move.peer = peer;
+  return sendFrame(move);
+}
+
+// --- Probed Dodger (shooter) ---
+// The clock offset and move latency follow one peer: on the shooter, the
+// first linked dodger that has joined the match.
+static int probeSession() {
+  for (int i = 0; i < sessions.count; i++) {
+    if (sessions.up[i] && sessions.state[i] != SESSION_LINKED) return i;
+  }
+  return -1;
+}
+
+// --- RTT Probe Helpers ---
+static void sendRttPing() {
+  GameFrame ping = makeFrame(OP_PING, 0, 0);
+  int probe = deviceRole == ROLE_SHOOTER ? probeSession() : -1;
+  if (probe >= 0) ping.peer = sessions.peer[probe];
+  rttPingSeq = ping.seq;
+  rttPingSentUs = micros();
+  if (sendFrame(ping)) {
+    timerStart(TIMER_RTT_PROBE, rttProbeTimeout, millis());
+  } else {
+    rttProbeRemaining = 0;
+  }
+}
+
+static void startRttProbe() {
+  clockSyncProbeStart();
+  rttProbeRemaining = rttProbePings;
+  rttLost = 0;
+  rttLostInRow = 0;
+  rttSamples = 0;
+  rttSumUs = 0;
+  rttMinUs = UINT32_MAX;
+  rttMaxUs = 0;
+  sendRttPing();
+}
+
+static void reportRttProbe() {
+  int probe = deviceRole == ROLE_SHOOTER ? probeSession() : -1;
+  const char* profile = (probe >= 0 && sessions.profile[probe] != PROFILE_NONE)
+                        ? connProfiles[sessions.profile[probe]].name : "peer";
+  if (rttSamples == 0) {
+    LOG_W("BLE: RTT probe (%s): no replies (%d pings lost).", profile, rttLost);
+    return;
+  }
+  LOG_I("BLE: RTT probe (%s): min %u us, avg %u us, max %u us over %d pings, %d lost.",
+        profile, rttMinUs, rttSumUs / rttSamples, rttMaxUs, rttSamples, rttLost);
+  if (clockSyncProbeEnd()) {
+    LOG_I("BLE: Peer clock offset %d us (+/- %u us).", (int)clockOffsetUs(), clockErrorUs());
+  }
+  // Probe again later so the offset follows the clocks' drift.
+  if (deviceRole != ROLE_BENCH) {
+    timerStart(TIMER_RTT_PROBE, clockResyncInterval, millis());
+  }
+}
+
+static void onRttPong(const GameFrame& pong) {
+  if (rttProbeRemaining == 0 || pong.seq != rttPingSeq) return;
+  uint32_t rtt = micros() - rttPingSentUs;
+  if (pong.inputUs != 0xFFFF && pong.encodeUs != 0xFFFF) {
+    clockSyncSample(rttPingSentUs, pong.rxUs, pong.sentUs, (uint32_t)pong.inputUs + pong.encodeUs);
+  }
+  rttSamples++;
+  rttLostInRow = 0;
+  rttSumUs += rtt;
+  if (rtt < rttMinUs) rttMinUs = rtt;
+  if (rtt > rttMaxUs) rttMaxUs = rtt;
+  timerCancel(TIMER_RTT_PROBE);
+  if (--rttProbeRemaining > 0) {
+    sendRttPing();
+  } else {
+    reportRttProbe();
+  }
+}
+
+// The ping in flight timed out; a late pong no longer matches rttPingSeq.
+static void onRttPingLost() {
+  rttLost++;
+  if (--rttProbeRemaining > 0 && ++rttLostInRow < rttProbeMaxLost) {
+    sendRttPing();
+  } else {
+    rttProbeRemaining = 0;
+    reportRttProbe();
+  }
+}
+
+// --- Connection Profile (shooter) ---
+// Request the wanted profile on each dodger's link where it is not in
+// force, then probe the round-trip time once the new parameters have
+// settled on the probed one.
+static void updateConnProfiles(ConnProfileId wanted) {
+  const ConnProfile& profile = connProfiles[wanted];
+  int probe = probeSession();
+  for (int i = 0; i < sessions.count; i++) {
+    if (!sessions.up[i] || sessions.profile[i] == wanted) continue;
+    if (pServer != nullptr) {
+      ALLOC_TRACE_PAUSE();  // the BLE stack allocates internally
+      pServer->updateConnParams(sessions.address[i], profile.minInterval, profile.maxInterval,
+                                profile.latency, profile.timeout);
+    }
+    sessions.profile[i] = wanted;
+    if (i == probe) {
+      rttProbeRemaining = 0;
+      timerStart(TIMER_RTT_PROBE, rttProbeSettleTime, millis());
+    }
+    LOG_I("BLE: Requested %s connection profile for dodger %d.", profile.name, i + 1);
+  }
+}
+
+// --- Match Snapshot (reconnect resynchronization) ---
+// The session's own round, the choice it holds for it, and the result
+// once shot at.
+static void sendSnapshot(int i) {
+  uint8_t state = sessions.state[i];
+  int choice = state == SESSION_CHOSEN ? sessions.choice[i] : 0;
+  uint8_t flags = 0;
+  if (state == SESSION_SHOT || state == SESSION_OUT) flags = sessions.result[i];
+  if (state == SESSION_OUT) flags |= SNAP_GAME_OVER;
+  GameFrame snap = makeFrame(OP_SNAPSHOT, choice, flags);
+  snap.round = sessions.round[i];
+  snap.peer = sessions.peer[i];
+  sendFrame(snap);
+  LOG_I("Shooter: Sent match snapshot for round %d to dodger %d", sessions.round[i], i + 1);
+}
+
+// --- Dodger Links (shooter) ---
+// Applies the connections opened and closed since the last pass to the
+// session table. A link the transport makes itself carries one dodger, on
+// peer 0 with no address.
+static void serviceDodgerLinks() {
+  DodgerLinkEvent event;
+  bool linksChanged = false;
+  while (dodgerLinkEvents.pop(&event)) {
+    linksChanged = true;
+    if (!event.up) {
+      sessionUnlink(event.peer);
+      continue;
+    }
+    int i = sessionLink(event.address, event.peer);
+    if (i < 0) {
+      LOG_W("BLE: All %d dodger sessions in use or held for the match, refusing connection %u.",
+            MAX_DODGERS, event.peer);
+      ALLOC_TRACE_PAUSE();  // the BLE stack allocates internally
+      pServer->disconnect(event.peer);
+      continue;
+    }
+    LOG_I("Shooter: Dodger %d linked, %d of %d connected.", i + 1, sessionsUp(), MAX_DODGERS);
+  }
+  // A connection stops advertising; spectators hear it either way.
+  if (linksChanged) spectatorAdvertise(sessionsUp() < MAX_DODGERS);
+  if (transportBackend() != &bleTransport) {
+    static const uint8_t noAddress[SESSION_ADDRESS_LEN] = { 0 };
+    bool linked = sessionFind(0) >= 0;
+    if (deviceConnected && !linked) sessionLink(noAddress, 0);
+    else if (!deviceConnected && linked) sessionUnlink(0);
+  }
+}
+
+// --- Shot Fan-Out (shooter) ---
+// One shot answers every dodger that has chosen. All of them are scored
+// first, then every frame is encoded, then the frames go to the link back
+// to back, each stamped as it is handed over.
+static void fireShot(int shot) {
+  shotHits = sessionsShoot(shot, &shotCount);
+  roundResultSafe = (shotHits == 0);
+  if (shotHits > 0) {
+    LOG_I("Result: %d of %d dodgers HIT!", shotHits, shotCount);
+  } else {
+    LOG_I("Result: Round Safe.");
+  }
+  uint32_t startUs = micros();
+  uint16_t inputUs = touchInputUs();
+  uint8_t frames[MAX_DODGERS][GAME_FRAME_SIZE];
+  TransportPeer peers[MAX_DODGERS];
+  int count = 0;
+  for (int i = 0; i < sessions.count; i++) {
+    if (sessions.state[i] != SESSION_SHOT || !sessions.up[i]) continue;
+    GameFrame frame = makeFrame(OP_SHOT, shot, 0);
+    frame.round = sessions.round[i];
+    frame.inputUs = inputUs;
+    gameFrameEncode(frame, frames[count], GAME_FRAME_SIZE);
+    peers[count++] = sessions.peer[i];
+  }
+  TRACE_SCOPE(TRACE_TRACK_LOOP, "ble.send");
+  int sent = 0;
+  for (int k = 0; k < count; k++) {
+    uint32_t sentUs = micros();
+    gameFrameStampSend(frames[k], sentUs, gameFrameClampUs(sentUs - startUs));
+    if (transportSendTo(CHANNEL_GAME, peers[k], frames[k], GAME_FRAME_SIZE)) sent++;
+  }
+  if (sent > 0) {
+    LOG_I("BLE: Notified %d of %d dodgers with shooter choice: %d", sent, shotCount, shot);
+  } else {
+    LOG_W("BLE Warning: No device connected!");
+  }
+}
+
+// --- Spectator Broadcast (shooter) ---
+// The match as the shooter's screen shows it; the advertising data only
+// changes when this does.
+static void publishSpectatorState() {
+  SpectatorSnapshot snap = { (uint8_t)roundNumber, 0, 0, 0, 0 };
+  int playing;
+  snap.ready = (uint8_t)sessionsReady(&playing);
+  snap.playing = (uint8_t)playing;
+  if (shooterState == SHOOTER_SHOW_RESULT) {
+    snap.flags = SNAP_SHOT_FIRED | (roundResultSafe ? SNAP_RESULT_SAFE : 0);
+    snap.playing = (uint8_t)shotCount;
+    snap.ready = (uint8_t)shotCount;
+    snap.hits = (uint8_t)shotHits;
+  } else if (shooterState == SHOOTER_GAME_OVER) {
+    snap.flags = SNAP_GAME_OVER | (roundResultSafe ? SNAP_RESULT_SAFE : 0);
+    snap.playing = 0;
+    snap.ready = 0;
+  }
+  spectatorPublish(snap);
+}
+
+static void applySnapshot(const GameFrame& snap) {
+  roundNumber = snap.round;
+  pendingChoice = 0;
+  roundResultSafe = (snap.flags & SNAP_RESULT_SAFE) != 0;
+  if (snap.flags & SNAP_GAME_OVER) {
+    gameOver = !roundResultSafe;
+    dodgerState = DODGER_GAME_OVER;
+  } else if (snap.flags & SNAP_SHOT_FIRED) {
+    gameOver = !roundResultSafe;
+    dodgerState = DODGER_SHOW_RESULT;
+    timerStart(TIMER_ROUND_RESULT, resultDisplayTime, millis());
+  } else if (snap.choice != 0) {
+    dodgerChoice = snap.choice;
+    dodgerState = DODGER_WAIT_SHOT;
+  } else {
+    dodgerState = DODGER_WAIT_INPUT;
+  }
+  linkState = LINK_READY;
+  timerCancel(TIMER_LINK_TICK);
+  rttProbeRemaining = 0;
+  timerStart(TIMER_RTT_PROBE, rttProbeSettleTime, millis());  // clock offset for move latency
+  screenInvalidate();
+  if (matchInterrupted) {
+    LOG_I("BLE Client: Match resumed %u ms after link loss (%d reconnect attempts).",
+          millis() - linkLostTime, reconnectAttempts);
+    matchInterrupted = false;
+  }
+  reconnectAttempts = 0;
+  LOG_I("Dodger: Synced to round %d", roundNumber);
+}
+
+// --- Move Latency ---
+static void startMoveTiming(const GameFrame& move) {
+  moveTiming = move;
+  moveHandledUs = micros();
+  moveTimingState = MOVE_TIMING_PENDING;
+}
+
+// The state machine took the pending move; it is measured once drawn.
+static void applyMoveTiming() {
+  if (moveTimingState != MOVE_TIMING_PENDING) return;
+  moveAppliedUs = micros();
+  moveTimingState = MOVE_TIMING_RENDER;
+}
+
+static void finishMoveTiming() {
+  if (moveTimingState != MOVE_TIMING_RENDER) return;
+  moveTimingState = MOVE_TIMING_IDLE;
+  if (moveTiming.inputUs == 0xFFFF) return;  // touch time unknown
+  LatencyBreakdown sample;
+  if (!latencyMeasure(moveTiming.sentUs, moveTiming.inputUs, moveTiming.encodeUs, moveTiming.rxUs,
+                      moveHandledUs, moveAppliedUs, micros(), &sample)) {
+    return;
+  }
+  latencyRecord(sample);
+  LOG_I("Latency: round %d: %d us (input %d, encode %d, radio %d, decode %d, render %d)",
+        moveTiming.round, (int)sample.totalUs, (int)sample.inputUs, (int)sample.encodeUs,
+        (int)sample.radioUs, (int)sample.decodeUs, (int)sample.renderUs);
+}
+
+static void logLatencySummary() {
+  if (latencyCount() == 0) return;
+  LatencyBreakdown avg;
+  latencyAverage(&avg);
+  LOG_I("Latency: %u moves, mean %d us (input %d, encode %d, radio %d, decode %d, render %d); 'lat' for the histogram.",
+        latencyCount(), (int)avg.totalUs, (int)avg.inputUs, (int)avg.encodeUs,
+        (int)avg.radioUs, (int)avg.decodeUs, (int)avg.renderUs);
+}
+
+// The shooter wins if no dodger survived.
+static void endMatch() {
+  roundResultSafe = (sessions.survivors > 0);
+  shooterState = SHOOTER_GAME_OVER;
+  LOG_I("Shooter: Game over, %d dodger(s) survived.", sessions.survivors);
+  logLatencySummary();
+}
+
+// --- Incoming Frame Dispatch (loop side) ---
+void handleMessage(const GameFrame& msg) {
+  PROFILE_SCOPE("loop.handleMessage");
+  if (msg.opcode == OP_PING) {
+    GameFrame pong = msg;
+    pong.opcode = OP_PONG;
+    pong.inputUs = gameFrameClampUs(micros() - msg.rxUs);  // turnaround, for the clock offset
+    sendFrame(pong);
+    return;
+  }
+  if (msg.opcode == OP_PONG) {
+    onRttPong(msg);
+    return;
+  }
+  if (msg.opcode >= OP_BENCH_PING) {
+    handleBenchMessage(msg);
+    return;
+  }
+  if (deviceRole == ROLE_SHOOTER) {
+    int i = sessionFind(msg.peer);
+    if (i < 0) {
+      LOG_W("BLE: Dropped frame from unknown connection %u", msg.peer);
+      return;
+    }
+    sessionJoin(i);
+    if (msg.opcode == OP_SYNC_REQUEST) {
+      sendSnapshot(i);
+    } else if (msg.opcode == OP_DODGER_CHOICE && sessionChoose(i, msg.round, msg.choice)) {
+      // A choice for a later round, or a round-1 choice on the game-over
+      // screen, is held by the session until it gets there.
+      if (i == probeSession() && !(msg.flags & MOVE_REPEAT)) startMoveTiming(msg);
+    } else if (msg.opcode == OP_DODGER_CHOICE && (msg.flags & MOVE_REPEAT) &&
+               sessionShotFor(i, msg.round) != 0) {
+      // Still waiting for a shot already fired: it was lost on the way.
+      repeatMove(OP_SHOT, sessionShotFor(i, msg.round), msg.round, sessions.peer[i]);
+      LOG_I("Shooter: Repeated round %d shot to dodger %d", msg.round, i + 1);
+    } else {
+      LOG_I("BLE: Discarded stale frame for round %d", msg.round);
+    }
+  } else {
+    if (msg.opcode == OP_SNAPSHOT) {
+      if (linkState == LINK_SYNCING) applySnapshot(msg);
+    } else if (msg.opcode == OP_SHOT && msg.round == roundNumber && dodgerState == DODGER_WAIT_SHOT) {
+      // Only while waiting: a repeated shot can still be in flight after
+      // the result, and must not answer the next match's first choice.
+      pendingChoice = msg.choice;
+      pendingRound = msg.round;
+      if (!(msg.flags & MOVE_REPEAT)) startMoveTiming(msg);
+    } else {
+      LOG_I("BLE: Discarded stale frame for round %d", msg.round);
+    }
   }
 }
 
@@ -129,83 +795,184 @@ void setup() {
   M5.Display.setRotation(0);
   M5.Display.fillScreen(BLACK);
   Serial.begin(115200);
-  Serial.println("Setup: Starting system...");
+  logInit();
+  memMonitorInit();
+  consoleRegister("mem", "heap/stack monitor: mem [history|overlay]", onMemCommand);
+  consoleRegister("lat", "move latency histogram: lat [reset]", onLatCommand);
+  consoleRegister("link", "link conditions: link [profile | latency_ms jitter_ms loss_permille]", onLinkCommand);
+  consoleRegister("render", "frame counts and mean compose/push times", onRenderCommand);
+#if PROFILER
+  consoleRegister("prof", "scope timings: prof [reset]", onProfCommand);
+#endif
+#if TRACE
+  traceInit();
+  consoleRegister("trace", "timeline dump for tools/trace2json.py: trace [clear]", onTraceCommand);
+#endif
+  LOG_I("Setup: Starting system...");
+  renderInit();
 
-  // Initialize touch.
+  // Initialize touch and the events that wake the main loop.
   M5.Touch.begin(&M5.Display);
+  eventsInit();
 
   // Draw role selection screen.
   drawRoleSelectionScreen();
-  Serial.println("Setup: Role selection screen displayed. Touch left for Shooter, right for Dodger.");
+  LOG_I("Setup: Role selection screen displayed. Touch left for Shooter, right for Dodger, bottom for Benchmark or Spectator, top to switch the link.");
 
   // Wait for user to select role using touch events.
   while (deviceRole == ROLE_UNDEFINED) {
+    waitForEvents(loopIdleTimeout);
     M5.update();
     if (M5.Touch.getCount() > 0) {
       if (millis() - lastTouchTime < touchDebounce) {
         continue;  // Allowed here because we're in a while loop.
       }
       lastTouchTime = millis();
+      TRACE_INSTANT(TRACE_TRACK_LOOP, "touch", 0);
       auto pos = M5.Touch.getDetail(0);  // Get first touch detail
       int tx = pos.x;
       int ty = pos.y;
-      Serial.print("Role selection touch: x=");
-      Serial.print(tx);
-      Serial.print(", y=");
-      Serial.println(ty);
-      if (pointInRect(tx, ty, 0, roleButtonY, roleButtonWidth, roleButtonHeight)) {
+      LOG_D("Role selection touch: x=%d, y=%d", tx, ty);
+      if (pointInRect(tx, ty, linkButtonX, linkButtonY, linkButtonWidth, linkButtonHeight)) {
+        linkChoice = (linkChoice + 1) % linkChoiceCount;
+        LOG_I("Link selected: %s", linkChoices[linkChoice].backend->name);
+        drawRoleSelectionScreen();
+      } else if (pointInRect(tx, ty, 0, roleButtonY, roleButtonWidth, roleButtonHeight)) {
         deviceRole = ROLE_SHOOTER;
-        Serial.println("Role selected: SHOOTER");
+        LOG_I("Role selected: SHOOTER");
       } else if (pointInRect(tx, ty, roleButtonWidth, roleButtonY, roleButtonWidth, roleButtonHeight)) {
         deviceRole = ROLE_DODGER;
-        Serial.println("Role selected: DODGER");
+        LOG_I("Role selected: DODGER");
+      } else if (pointInRect(tx, ty, benchButtonX, benchButtonY, benchButtonWidth, benchButtonHeight)) {
+        deviceRole = ROLE_BENCH;
+        LOG_I("Role selected: BENCHMARK");
+      } else if (pointInRect(tx, ty, spectatorButtonX, spectatorButtonY, spectatorButtonWidth, spectatorButtonHeight)) {
+        deviceRole = ROLE_SPECTATOR;
+        LOG_I("Role selected: SPECTATOR");
       }
     }
   }
   
+  // Reset before any BLE traffic can arrive so nothing received during the
+  // banner is thrown away.
+  resetGame();
+  if (deviceRole == ROLE_SPECTATOR) {
+    // No game link: the spectator only listens to the shooter's adverts.
+  } else
+#if TRANSPORT_HOST
+  if (hostTransportConfigured()) {
+    transportInit(&hostTransport, onTransportFrame, onTransportLink);
+  } else
+#endif
+  transportInit(linkChoices[linkChoice].backend, onTransportFrame, onTransportLink);
+
   // Clear screen and show selected role.
-  M5.Display.fillScreen(BLACK);
-  M5.Display.setTextSize(2);
+  lgfx::LovyanGFX& gfx = frameBegin();
+  gfx.fillScreen(BLACK);
+  gfx.setTextSize(2);
+  const char* banner = "Dodger Mode";
+  if (deviceRole == ROLE_SHOOTER) banner = "Shooter Mode";
+  else if (deviceRole == ROLE_BENCH) banner = "Benchmark Mode";
+  else if (deviceRole == ROLE_SPECTATOR) banner = "Spectator Mode";
+  gfx.drawCentreString(banner, screenWidth / 2, 20, 2);
+  frameEnd((uint32_t)screenWidth * screenHeight);
+  bool bleLink = (transportBackend() == &bleTransport);
   if (deviceRole == ROLE_SHOOTER) {
-    M5.Display.drawCentreString("Shooter Mode", screenWidth / 2, 20, 2);
-    setupBLE_Server();
+    if (bleLink) setupBLE_Server();
+    else transportBegin(true);
+    // The advert link's frames fill the advertising data.
+    if (!bleLink && transportBackend() != &advTransport) spectatorBroadcastBegin(false);
     shooterState = SHOOTER_WAIT_DODGER;
+  } else if (deviceRole == ROLE_SPECTATOR) {
+    spectatorListen();
   } else {
-    M5.Display.drawCentreString("Dodger Mode", screenWidth / 2, 20, 2);
-    setupBLE_Client();
+    if (bleLink) setupBLE_Client();
+    else startLinkScan();
     dodgerState = DODGER_WAIT_INPUT;
   }
   
-  delay(1000);
-  resetGame();
-  Serial.println("Setup complete. Entering main loop.");
+  // Keep the banner up without blocking; BLE events are serviced meanwhile.
+  splashActive = true;
+  timerStart(TIMER_SPLASH, splashTime, millis());
+  LOG_I("Setup complete. Entering main loop.");
 }
 
 void loop() {
+  // Sleep until a BLE callback, the touch interrupt, a state change, the
+  // next timer deadline or the next delayed outgoing frame wakes us.
+  uint32_t timeout = timerTimeUntilNext(millis());
+  uint32_t linkWaitUs = transportPoll(micros());
+  if (linkWaitUs != UINT32_MAX && (linkWaitUs + 999) / 1000 < timeout) {
+    timeout = (linkWaitUs + 999) / 1000;
+  }
+  waitForEvents(timeout < loopIdleTimeout ? timeout : loopIdleTimeout);
+  PROFILE_SCOPE("loop.pass");  // one wake-up, excluding the wait
+  TRACE_SCOPE(TRACE_TRACK_LOOP, "loop");
   M5.update();
+  consolePoll();  // serial input does not wake the loop; answered within a pass
+
+  uint32_t firedTimers = 0;
+  int timerId;
+  while ((timerId = timerPopExpired(millis())) >= 0) {
+    firedTimers |= 1u << timerId;
+  }
+  if (splashActive) {
+    if (!(firedTimers & (1u << TIMER_SPLASH))) {
+      // Periodic timers re-arm from their handlers, so a dropped expiry
+      // would stop them for good; keep it for the first pass after.
+      timersHeldBySplash |= firedTimers;
+      return;
+    }
+    splashActive = false;
+    firedTimers |= timersHeldBySplash;
+    timersHeldBySplash = 0;
+    screenInvalidate();
+  }
+
+  if (deviceRole == ROLE_SHOOTER) serviceDodgerLinks();  // sessions before their frames
+  GameFrame msg;
+  while (rxMessages.pop(&msg)) {
+    handleMessage(msg);
+  }
+  ShooterState prevShooterState = shooterState;
+  DodgerState prevDodgerState = dodgerState;
   
+  // RTT probe: start after the settle delay, or count a lost reply.
+  if (firedTimers & (1u << TIMER_RTT_PROBE)) {
+    if (rttProbeRemaining == 0) {
+      startRttProbe();
+    } else {
+      onRttPingLost();
+    }
+  }
+
   // --- Shooter Mode Logic ---
   if (deviceRole == ROLE_SHOOTER) {
+    int lowestRound = sessionsLowestRound();
+    if (lowestRound > 0) roundNumber = lowestRound;
     if (shooterState == SHOOTER_WAIT_DODGER) {
-      // Waiting for dodger's barrel selection via BLE.
-      drawGameScreen(); // displays "Waiting for dodger..."
-      if (dodgerInputReceived) {
+      PROFILE_SCOPE("shooter.waitDodger");
+      // Waiting for every linked dodger still in the match to pick a barrel.
+      int playing;
+      int ready = sessionsReady(&playing);
+      if (playing > 0 && ready == playing) {
+        applyMoveTiming();
         shooterState = SHOOTER_WAIT_INPUT;
-        dodgerInputReceived = false;
-        Serial.println("Shooter: Dodger input received; now waiting for shooter input.");
+        LOG_I("Shooter: Input from %d dodger(s) received; now waiting for shooter input.", ready);
+      } else if (playing == 0 && sessionsEndIfOver()) {
+        // The last dodger still playing dropped after the others went out.
+        endMatch();
       }
     }
     else if (shooterState == SHOOTER_WAIT_INPUT) {
-      drawGameScreen(); // displays "Select barrel to shoot"
+      PROFILE_SCOPE("shooter.waitInput");
       if (M5.Touch.getCount() > 0) {
         if (millis() - lastTouchTime >= touchDebounce) {
           lastTouchTime = millis();
+          TRACE_INSTANT(TRACE_TRACK_LOOP, "touch", 0);
           auto pos = M5.Touch.getDetail(0);
           int tx = pos.x, ty = pos.y;
-          Serial.print("Shooter button touch: x=");
-          Serial.print(tx);
-          Serial.print(", y=");
-          Serial.println(ty);
+          LOG_D("Shooter button touch: x=%d, y=%d", tx, ty);
           if (pointInRect(tx, ty, button1X, buttonY, buttonWidth, buttonHeight)) {
             shooterChoice = 1;
           } else if (pointInRect(tx, ty, button2X, buttonY, buttonWidth, buttonHeight)) {
@@ -214,58 +981,40 @@ void loop() {
             shooterChoice = 3;
           }
           if (shooterChoice >= 1 && shooterChoice <= 3) {
-            Serial.print("Shooter selected barrel: ");
-            Serial.println(shooterChoice);
-            // Now the shooter wins (dodger loses) if shooterChoice equals dodgerChoice.
-            if (shooterChoice == dodgerChoice) {
-              roundResultSafe = false;
-              gameOver = true;
-              Serial.println("Result: Dodger HIT!");
-            } else {
-              roundResultSafe = true;
-              Serial.println("Result: Round Safe.");
-            }
-            if (deviceConnected) {
-              char buf[4];
-              sprintf(buf, "%d", shooterChoice);
-              pCharacteristic->setValue(buf);
-              pCharacteristic->notify();
-              Serial.print("BLE: Notified dodger with shooter choice: ");
-              Serial.println(shooterChoice);
-            } else {
-              Serial.println("BLE Warning: No device connected!");
-            }
+            LOG_I("Shooter selected barrel: %d", shooterChoice);
+            // A dodger is hit if the shot matches its choice.
+            fireShot(shooterChoice);
             shooterState = SHOOTER_SHOW_RESULT;
+            timerStart(TIMER_ROUND_RESULT, resultDisplayTime, millis());
           }
         }
       }
     }
     else if (shooterState == SHOOTER_SHOW_RESULT) {
-      drawGameScreen();
-      delay(1500);
-      if (gameOver || (roundNumber >= MAX_ROUNDS && roundResultSafe)) {
-        shooterState = SHOOTER_GAME_OVER;
-        Serial.println("Shooter: Game over.");
-      } else {
-        roundNumber++;
-        shooterState = SHOOTER_WAIT_DODGER;
-        Serial.print("Shooter: Advancing to round ");
-        Serial.println(roundNumber);
+      PROFILE_SCOPE("shooter.showResult");
+      // The result stays on screen until the round-result timer fires.
+      if (firedTimers & (1u << TIMER_ROUND_RESULT)) {
+        if (sessionsAdvance()) {
+          endMatch();
+        } else {
+          lowestRound = sessionsLowestRound();
+          if (lowestRound > 0) roundNumber = lowestRound;
+          shooterState = SHOOTER_WAIT_DODGER;
+          LOG_I("Shooter: Advancing to round %d", roundNumber);
+        }
       }
     }
     else if (shooterState == SHOOTER_GAME_OVER) {
-      drawGameOverScreen();
+      PROFILE_SCOPE("shooter.gameOver");
       if (M5.Touch.getCount() > 0) {
         if (millis() - lastTouchTime >= touchDebounce) {
           lastTouchTime = millis();
+          TRACE_INSTANT(TRACE_TRACK_LOOP, "touch", 0);
           auto pos = M5.Touch.getDetail(0);
           int tx = pos.x, ty = pos.y;
-          Serial.print("Shooter restart touch: x=");
-          Serial.print(tx);
-          Serial.print(", y=");
-          Serial.println(ty);
+          LOG_D("Shooter restart touch: x=%d, y=%d", tx, ty);
           if (pointInRect(tx, ty, screenWidth / 2 - 60, 120, 120, 40)) {
-            Serial.println("Shooter: Restart pressed.");
+            LOG_I("Shooter: Restart pressed.");
             resetGame();
             shooterState = SHOOTER_WAIT_DODGER;
           }
@@ -275,17 +1024,22 @@ void loop() {
   }
   // --- Dodger Mode Logic ---
   else if (deviceRole == ROLE_DODGER) {
-    if (dodgerState == DODGER_WAIT_INPUT) {
-      drawGameScreen();
+    {
+      PROFILE_SCOPE("dodger.link");
+      serviceClientLink(firedTimers);
+    }
+    if (linkState != LINK_READY) {
+      // Touch input and peer frames wait until the link is up and in sync.
+    }
+    else if (dodgerState == DODGER_WAIT_INPUT) {
+      PROFILE_SCOPE("dodger.waitInput");
       if (M5.Touch.getCount() > 0) {
         if (millis() - lastTouchTime >= touchDebounce) {
           lastTouchTime = millis();
+          TRACE_INSTANT(TRACE_TRACK_LOOP, "touch", 0);
           auto pos = M5.Touch.getDetail(0);
           int tx = pos.x, ty = pos.y;
-          Serial.print("Dodger button touch: x=");
-          Serial.print(tx);
-          Serial.print(", y=");
-          Serial.println(ty);
+          LOG_D("Dodger button touch: x=%d, y=%d", tx, ty);
           if (pointInRect(tx, ty, button1X, buttonY, buttonWidth, buttonHeight)) {
             dodgerChoice = 1;
           } else if (pointInRect(tx, ty, button2X, buttonY, buttonWidth, buttonHeight)) {
@@ -294,66 +1048,71 @@ void loop() {
             dodgerChoice = 3;
           }
           if (dodgerChoice >= 1 && dodgerChoice <= 3) {
-            Serial.print("Dodger selected barrel: ");
-            Serial.println(dodgerChoice);
-            if (pRemoteCharacteristic != nullptr) {
-              char buf[4];
-              sprintf(buf, "%d", dodgerChoice);
-              pRemoteCharacteristic->writeValue(std::string(buf));
-              Serial.print("BLE: Sent dodger choice: ");
-              Serial.println(dodgerChoice);
+            LOG_I("Dodger selected barrel: %d", dodgerChoice);
+            if (sendMove(OP_DODGER_CHOICE, dodgerChoice)) {
+              LOG_I("BLE: Sent dodger choice: %d", dodgerChoice);
             } else {
-              Serial.println("BLE Warning: Remote characteristic not found!");
+              LOG_W("BLE Warning: Remote characteristic not found!");
             }
             dodgerState = DODGER_WAIT_SHOT;
+            timerStart(TIMER_MOVE_REPEAT, moveRepeatInterval, millis());
           }
         }
       }
     }
     else if (dodgerState == DODGER_WAIT_SHOT) {
-      drawGameScreen();
-      if (notificationReceived) {
-        notificationReceived = false;
-        Serial.print("Dodger: Received shooter choice: ");
-        Serial.println(receivedShooterChoice);
+      PROFILE_SCOPE("dodger.waitShot");
+      if (pendingChoice != 0 && pendingRound == roundNumber) {
+        int shot = pendingChoice;
+        pendingChoice = 0;
+        timerCancel(TIMER_MOVE_REPEAT);
+        applyMoveTiming();
+        LOG_I("Dodger: Received shooter choice: %d", shot);
         // Now the dodger loses if the received shooter choice equals the dodger's choice.
-        if (receivedShooterChoice == dodgerChoice) {
+        if (shot == dodgerChoice) {
           roundResultSafe = false;
           gameOver = true;
-          Serial.println("Dodger: You were hit!");
+          LOG_I("Dodger: You were hit!");
         } else {
           roundResultSafe = true;
-          Serial.println("Dodger: Round safe.");
+          LOG_I("Dodger: Round safe.");
         }
         dodgerState = DODGER_SHOW_RESULT;
+        timerStart(TIMER_ROUND_RESULT, resultDisplayTime, millis());
+      } else if (firedTimers & (1u << TIMER_MOVE_REPEAT)) {
+        // No shot yet: the choice or the shot may have been lost.
+        repeatMove(OP_DODGER_CHOICE, dodgerChoice, (uint8_t)roundNumber, TRANSPORT_PEER_ALL);
+        timerStart(TIMER_MOVE_REPEAT, moveRepeatInterval, millis());
+      } else if (!timerActive(TIMER_MOVE_REPEAT)) {
+        timerStart(TIMER_MOVE_REPEAT, moveRepeatInterval, millis());  // resumed from a snapshot
       }
     }
     else if (dodgerState == DODGER_SHOW_RESULT) {
-      drawGameScreen();
-      delay(1500);
-      if (gameOver || (roundNumber >= MAX_ROUNDS && roundResultSafe)) {
-        dodgerState = DODGER_GAME_OVER;
-        Serial.println("Dodger: Game over.");
-      } else {
-        roundNumber++;
-        dodgerState = DODGER_WAIT_INPUT;
-        Serial.print("Dodger: Advancing to round ");
-        Serial.println(roundNumber);
+      PROFILE_SCOPE("dodger.showResult");
+      // The result stays on screen until the round-result timer fires.
+      if (firedTimers & (1u << TIMER_ROUND_RESULT)) {
+        if (gameOver || (roundNumber >= MAX_ROUNDS && roundResultSafe)) {
+          dodgerState = DODGER_GAME_OVER;
+          LOG_I("Dodger: Game over.");
+          logLatencySummary();
+        } else {
+          roundNumber++;
+          dodgerState = DODGER_WAIT_INPUT;
+          LOG_I("Dodger: Advancing to round %d", roundNumber);
+        }
       }
     }
     else if (dodgerState == DODGER_GAME_OVER) {
-      drawGameOverScreen();
+      PROFILE_SCOPE("dodger.gameOver");
       if (M5.Touch.getCount() > 0) {
         if (millis() - lastTouchTime >= touchDebounce) {
           lastTouchTime = millis();
+          TRACE_INSTANT(TRACE_TRACK_LOOP, "touch", 0);
           auto pos = M5.Touch.getDetail(0);
           int tx = pos.x, ty = pos.y;
-          Serial.print("Dodger restart touch: x=");
-          Serial.print(tx);
-          Serial.print(", y=");
-          Serial.println(ty);
+          LOG_D("Dodger restart touch: x=%d, y=%d", tx, ty);
           if (pointInRect(tx, ty, screenWidth / 2 - 60, 120, 120, 40)) {
-            Serial.println("Dodger: Restart pressed.");
+            LOG_I("Dodger: Restart pressed.");
             resetGame();
             dodgerState = DODGER_WAIT_INPUT;
           }
@@ -361,84 +1120,419 @@ void loop() {
       }
     }
   }
+  // --- Benchmark Mode Logic ---
+  else if (deviceRole == ROLE_BENCH) {
+    serviceClientLink(firedTimers);
+    if (linkState == LINK_READY) {
+      serviceBench(firedTimers);
+    }
+  }
+  // --- Spectator Mode Logic ---
+  else if (deviceRole == ROLE_SPECTATOR) {
+    SpectatorSnapshot snap;
+    while (spectatorReceive(&snap)) {
+      spectatorView = snap;
+      spectatorWatching = true;
+      LOG_I("Spectator: Round %d, flags %02x, %d of %d ready, %d hit.", snap.round, snap.flags,
+            snap.ready, snap.playing, snap.hits);
+    }
+    if (spectatorShooterLost(micros())) {
+      spectatorWatching = false;
+      LOG_I("Spectator: Shooter went quiet.");
+    }
+  }
+  
+  if (rxMessages.overflowCount() != reportedRxOverflows) {
+    reportedRxOverflows = rxMessages.overflowCount();
+    LOG_W("BLE Warning: Receive queue overflowed, frames lost: %u", reportedRxOverflows);
+  }
+
+  // Shooter streams a requested benchmark flood a burst per pass.
+  if (deviceRole == ROLE_SHOOTER && benchFloodRemaining > 0) {
+    for (int i = 0; i < benchFloodBurst && benchFloodRemaining > 0; i++) {
+      GameFrame data = { OP_BENCH_DATA, 0, 0, 0, benchFloodSeq++, 0, 0, 0, 0, benchFloodPeer };
+      if (!sendBenchFrame(data, BENCH_PAYLOAD_SIZE)) {
+        benchFloodRemaining = 0;
+        break;
+      }
+      benchFloodRemaining--;
+    }
+    postEvent(EVT_STATE_CHANGED);  // come straight back for the next burst
+  }
+
+  // Low latency while rounds are played, power saving on the game-over screen.
+  if (deviceRole == ROLE_SHOOTER) {
+    updateConnProfiles(shooterState == SHOOTER_GAME_OVER ? PROFILE_POWER_SAVE : PROFILE_LOW_LATENCY);
+    publishSpectatorState();
+  }
+
+  // A state change is handled on the next pass without waiting for input.
+  if (shooterState != prevShooterState || dodgerState != prevDodgerState) {
+    postEvent(EVT_STATE_CHANGED);
+  }
+  drawCurrentScreen();
+  finishMoveTiming();
+#if ALLOC_TRACE
+  traceRoundAllocations();
+#endif
+#if TRACE
+  traceStateSpans();
+#endif
+}
+
+#if TRACE
+static const char* const shooterStateNames[] = { "shooter.waitDodger", "shooter.waitInput", "shooter.showResult", "shooter.gameOver" };
+static const char* const dodgerStateNames[] = { "dodger.waitInput", "dodger.waitShot", "dodger.showResult", "dodger.gameOver" };
+static const char* const linkStateNames[] = { "link.idle", "link.scanning", "link.connecting", "link.syncing", "link.ready" };
+
+// Game and link states as spans: close the old one and open the new one
+// whenever the state changed during this pass.
+void traceStateSpans() {
+  static const char* shownState = nullptr;
+  static const char* shownLink = nullptr;
+  const char* state = nullptr;
+  if (deviceRole == ROLE_SHOOTER) state = shooterStateNames[shooterState];
+  else if (deviceRole == ROLE_DODGER) state = dodgerStateNames[dodgerState];
+  if (state != shownState) {
+    if (shownState != nullptr) TRACE_END_NAMED(TRACE_TRACK_STATE, shownState);
+    if (state != nullptr) TRACE_BEGIN_NAMED(TRACE_TRACK_STATE, state);
+    shownState = state;
+  }
+  const char* link = (deviceRole == ROLE_DODGER || deviceRole == ROLE_BENCH) ? linkStateNames[linkState] : nullptr;
+  if (link != shownLink) {
+    if (shownLink != nullptr) TRACE_END_NAMED(TRACE_TRACK_LINK, shownLink);
+    if (link != nullptr) TRACE_BEGIN_NAMED(TRACE_TRACK_LINK, link);
+    shownLink = link;
+  }
 }
 
+void onTraceCommand(const char* args) {
+  if (strcmp(args, "clear") == 0) {
+    traceClear();
+    Serial.println("trace: cleared.");
+  } else {
+    traceDump();
+  }
+}
+#endif
+
+#if ALLOC_TRACE
+// A round runs from the first pass waiting for input to the pass that
+// shows its result; none of those passes may allocate.
+static bool roundInProgress() {
+  if (deviceRole == ROLE_SHOOTER) {
+    return shooterState == SHOOTER_WAIT_DODGER || shooterState == SHOOTER_WAIT_INPUT;
+  }
+  if (deviceRole == ROLE_DODGER) {
+    return linkState == LINK_READY &&
+           (dodgerState == DODGER_WAIT_INPUT || dodgerState == DODGER_WAIT_SHOT);
+  }
+  return false;
+}
+
+void traceRoundAllocations() {
+  bool inRound = roundInProgress();
+  if (inRound && !allocTraceActive()) {
+    allocTraceBegin();
+  } else if (!inRound && allocTraceActive()) {
+    AllocTraceReport report;
+    if (allocTraceEnd(&report)) {
+      LOG_I("Alloc: Round %d ran with no heap allocations.", roundNumber);
+    } else {
+      LOG_E("Alloc: Round %d made %u allocations (%u bytes), first %u bytes from %x.",
+            roundNumber, report.count, report.bytes, report.firstSize, report.firstCaller);
+    }
+  }
+}
+#endif
+
 // --- UI Drawing Functions ---
 void drawRoleSelectionScreen() {
   M5.Display.setRotation(1);  // Landscape mode.
-  M5.Display.fillScreen(BLACK);
-  M5.Display.setTextSize(2);
+  lgfx::LovyanGFX& gfx = frameBegin();
+  gfx.fillScreen(BLACK);
+  gfx.setTextSize(2);
+  // Top: link toggle.
+  gfx.fillRect(linkButtonX, linkButtonY, linkButtonWidth, linkButtonHeight, NAVY);
+  gfx.drawRect(linkButtonX, linkButtonY, linkButtonWidth, linkButtonHeight, TFT_WHITE);
+  gfx.drawCentreString(linkChoices[linkChoice].label, screenWidth / 2, linkButtonY + 5, 2);
   // Left half: Shooter button.
-  M5.Display.fillRect(0, roleButtonY, roleButtonWidth, roleButtonHeight, BLUE);
-  M5.Display.drawRect(0, roleButtonY, roleButtonWidth, roleButtonHeight, TFT_WHITE);
-  M5.Display.drawCentreString("Shooter", roleButtonWidth / 2, roleButtonY + 25, 2);
+  gfx.fillRect(0, roleButtonY, roleButtonWidth, roleButtonHeight, BLUE);
+  gfx.drawRect(0, roleButtonY, roleButtonWidth, roleButtonHeight, TFT_WHITE);
+  gfx.drawCentreString("Shooter", roleButtonWidth / 2, roleButtonY + 25, 2);
   // Right half: Dodger button.
-  M5.Display.fillRect(roleButtonWidth, roleButtonY, roleButtonWidth, roleButtonHeight, GREEN);
-  M5.Display.drawRect(roleButtonWidth, roleButtonY, roleButtonWidth, roleButtonHeight, TFT_WHITE);
-  M5.Display.drawCentreString("Dodger", roleButtonWidth + roleButtonWidth / 2, roleButtonY + 25, 2);
-  Serial.println("UI: Role selection screen drawn.");
+  gfx.fillRect(roleButtonWidth, roleButtonY, roleButtonWidth, roleButtonHeight, GREEN);
+  gfx.drawRect(roleButtonWidth, roleButtonY, roleButtonWidth, roleButtonHeight, TFT_WHITE);
+  gfx.drawCentreString("Dodger", roleButtonWidth + roleButtonWidth / 2, roleButtonY + 25, 2);
+  // Below: link benchmark and spectator.
+  gfx.fillRect(benchButtonX, benchButtonY, benchButtonWidth, benchButtonHeight, DARKGREY);
+  gfx.drawRect(benchButtonX, benchButtonY, benchButtonWidth, benchButtonHeight, TFT_WHITE);
+  gfx.drawCentreString("Benchmark", benchButtonX + benchButtonWidth / 2, benchButtonY + 5, 2);
+  gfx.fillRect(spectatorButtonX, spectatorButtonY, spectatorButtonWidth, spectatorButtonHeight, PURPLE);
+  gfx.drawRect(spectatorButtonX, spectatorButtonY, spectatorButtonWidth, spectatorButtonHeight, TFT_WHITE);
+  gfx.drawCentreString("Spectator", spectatorButtonX + spectatorButtonWidth / 2, spectatorButtonY + 5, 2);
+  frameEnd((uint32_t)screenWidth * screenHeight);
+  screenInvalidate();
+  LOG_D("UI: Role selection screen drawn.");
 }
 
+// With several dodgers the shooter shows counts instead of one dodger's
+// progress.
 void drawGameScreen() {
-  M5.Display.fillScreen(BLACK);
-  M5.Display.setTextSize(2);
-  
-  String roundStr = "Round: " + String(roundNumber) + " / " + String(MAX_ROUNDS);
-  M5.Display.drawCentreString(roundStr, screenWidth / 2, 10, 2);
-  
+  PROFILE_SCOPE("draw.game");
+  const char* status = "";
+  char counts[24];
   if (deviceRole == ROLE_SHOOTER) {
     if (shooterState == SHOOTER_WAIT_DODGER) {
-      M5.Display.drawCentreString("Waiting for dodger...", screenWidth / 2, 50, 2);
+      int playing;
+      int ready = sessionsReady(&playing);
+      if (playing <= 1) {
+        status = "Waiting for dodger...";
+      } else {
+        snprintf(counts, sizeof(counts), "%d of %d ready", ready, playing);
+        status = counts;
+      }
     } else if (shooterState == SHOOTER_WAIT_INPUT) {
-      M5.Display.drawCentreString("Select barrel to shoot", screenWidth / 2, 50, 2);
+      status = "Select barrel to shoot";
     } else if (shooterState == SHOOTER_SHOW_RESULT) {
-      if (roundResultSafe)
-        M5.Display.drawCentreString("Round Safe", screenWidth / 2, 50, 2);
-      else
-        M5.Display.drawCentreString("Dodger Hit!", screenWidth / 2, 50, 2);
+      if (shotCount <= 1) {
+        status = roundResultSafe ? "Round Safe" : "Dodger Hit!";
+      } else {
+        snprintf(counts, sizeof(counts), "Hit %d of %d", shotHits, shotCount);
+        status = counts;
+      }
     }
   } else { // Dodger mode.
     if (dodgerState == DODGER_WAIT_INPUT) {
-      M5.Display.drawCentreString("Select barrel to hide", screenWidth / 2, 50, 2);
+      status = "Select barrel to hide";
     } else if (dodgerState == DODGER_WAIT_SHOT) {
-      M5.Display.drawCentreString("Waiting for shot...", screenWidth / 2, 50, 2);
+      status = "Waiting for shot...";
     } else if (dodgerState == DODGER_SHOW_RESULT) {
-      if (roundResultSafe)
-        M5.Display.drawCentreString("Safe!", screenWidth / 2, 50, 2);
-      else
-        M5.Display.drawCentreString("You Were Hit!", screenWidth / 2, 50, 2);
+      status = roundResultSafe ? "Safe!" : "You Were Hit!";
     }
   }
   
-  // Draw barrel selection buttons.
-  M5.Display.fillRect(button1X, buttonY, buttonWidth, buttonHeight, DARKGREY);
-  M5.Display.drawRect(button1X, buttonY, buttonWidth, buttonHeight, TFT_WHITE);
-  M5.Display.drawCentreString("Barrel1", button1X + buttonWidth / 2, buttonY + 15, 2);
-  
-  M5.Display.fillRect(button2X, buttonY, buttonWidth, buttonHeight, DARKGREY);
-  M5.Display.drawRect(button2X, buttonY, buttonWidth, buttonHeight, TFT_WHITE);
-  M5.Display.drawCentreString("Barrel2", button2X + buttonWidth / 2, buttonY + 15, 2);
-  
-  M5.Display.fillRect(button3X, buttonY, buttonWidth, buttonHeight, DARKGREY);
-  M5.Display.drawRect(button3X, buttonY, buttonWidth, buttonHeight, TFT_WHITE);
-  M5.Display.drawCentreString("Barrel3", button3X + buttonWidth / 2, buttonY + 15, 2);
+  // Only the elements that changed since the last call reach the panel.
+  screenSetRound(roundNumber, MAX_ROUNDS);
+  screenSetStatus(status);
+  for (int i = 1; i <= NUM_BARRELS; i++) {
+    screenSetBarrelColor(i, DARKGREY);
+  }
+  screenRender();
 }
 
+// The match as the shooter last broadcast it, in the words of the
+// shooter's own screen.
+void drawSpectatorScreen() {
+  PROFILE_SCOPE("draw.spectator");
+  const SpectatorSnapshot& s = spectatorView;
+  const char* status = "";
+  char counts[24];
+  if (!spectatorWatching) {
+    screenSetTitle("Spectating");
+    status = "Looking for a match...";
+  } else if (s.flags & SNAP_GAME_OVER) {
+    screenSetTitle("Game Over");
+    status = (s.flags & SNAP_RESULT_SAFE) ? "Shooter Loses!" : "Shooter Wins!";
+  } else {
+    screenSetRound(s.round, MAX_ROUNDS);
+    if (s.flags & SNAP_SHOT_FIRED) {
+      if (s.playing <= 1) {
+        status = (s.flags & SNAP_RESULT_SAFE) ? "Round Safe" : "Dodger Hit!";
+      } else {
+        snprintf(counts, sizeof(counts), "Hit %d of %d", s.hits, s.playing);
+        status = counts;
+      }
+    } else if (s.playing == 0) {
+      status = "Waiting for dodger...";
+    } else if (s.ready == s.playing) {
+      status = "Shooter aiming...";
+    } else if (s.playing == 1) {
+      status = "Dodger choosing...";
+    } else {
+      snprintf(counts, sizeof(counts), "%d of %d ready", s.ready, s.playing);
+      status = counts;
+    }
+  }
+  screenSetStatus(status);
+  for (int i = 1; i <= NUM_BARRELS; i++) {
+    screenSetBarrelColor(i, BLACK);
+  }
+  screenRender();
+}
+
+// Connection progress for the dodger; barrels stay dark until linked.
+void drawLinkScreen() {
+  PROFILE_SCOPE("draw.link");
+  char status[40];  // longest: "Discovering... " plus a 20-digit count
+  unsigned long elapsed = (millis() - linkStartTime) / 1000;
+  if (linkState == LINK_SCANNING) {
+    snprintf(status, sizeof(status), "Scanning... %lus", elapsed);
+  } else if (linkState == LINK_CONNECTING) {
+    const char* step = "Connecting";
+    if (connectStep == STEP_DISCOVER) step = "Discovering";
+    else if (connectStep == STEP_SUBSCRIBE) step = "Subscribing";
+    snprintf(status, sizeof(status), "%s... %lus", step, elapsed);
+  } else if (linkState == LINK_SYNCING) {
+    snprintf(status, sizeof(status), "Syncing... %lus", elapsed);
+  } else if (timerActive(TIMER_LINK_RETRY)) {
+    snprintf(status, sizeof(status), "Retrying soon...");
+  } else {
+    snprintf(status, sizeof(status), "Tap to search again");
+  }
+  if (linkState == LINK_SCANNING) {
+    screenSetTitle("Tap to cancel");
+  } else {
+    screenSetTitle(matchInterrupted ? "Reconnecting" : "Finding shooter");
+  }
+  screenSetStatus(status);
+  for (int i = 1; i <= NUM_BARRELS; i++) {
+    screenSetBarrelColor(i, BLACK);
+  }
+  screenRender();
+}
+
+// Game-over screen is static, so it is drawn once per visit.
+void drawCurrentScreen() {
+  updateMemOverlay();
+  if ((deviceRole == ROLE_DODGER || deviceRole == ROLE_BENCH) && linkState != LINK_READY) {
+    drawLinkScreen();
+    return;
+  }
+  if (deviceRole == ROLE_BENCH) {
+    drawBenchScreen();
+    return;
+  }
+  if (deviceRole == ROLE_SPECTATOR) {
+    drawSpectatorScreen();
+    return;
+  }
+  bool over = (deviceRole == ROLE_SHOOTER) ? (shooterState == SHOOTER_GAME_OVER)
+                                           : (dodgerState == DODGER_GAME_OVER);
+  if (!over) {
+    drawGameScreen();
+  } else if (!gameOverScreenShown) {
+    drawGameOverScreen();
+    gameOverScreenShown = true;
+  }
+}
+
+// Newest memory sample as one short line on the game screen.
+void updateMemOverlay() {
+  MemSample sample;
+  if (!memOverlay || !memMonitorLatest(&sample)) {
+    screenSetOverlay("");
+    return;
+  }
+  char text[sizeof(ScreenModel::overlayText)];
+  snprintf(text, sizeof(text), "heap %uK blk %uK ps %uK stk %u/%u/%u",
+           sample.heapFree * MEM_HEAP_UNIT / 1024, sample.heapLargest * MEM_HEAP_UNIT / 1024,
+           sample.psramFreeKb, sample.stackFree[MEM_TASK_LOOP], sample.stackFree[MEM_TASK_BTC],
+           sample.stackFree[MEM_TASK_BTU]);
+  screenSetOverlay(text);
+}
+
+void onLatCommand(const char* args) {
+  if (strcmp(args, "reset") == 0) {
+    latencyReset();
+    Serial.println("lat: cleared.");
+    return;
+  }
+  latencyPrint(deviceRole == ROLE_SHOOTER ? "dodger->shooter" : "shooter->dodger");
+}
+
+void onMemCommand(const char* args) {
+  if (strcmp(args, "history") == 0) {
+    memMonitorPrintHistory();
+  } else if (strcmp(args, "overlay") == 0) {
+    memOverlay = !memOverlay;
+    Serial.printf("mem: overlay %s.\n", memOverlay ? "on" : "off");
+    postEvent(EVT_STATE_CHANGED);
+  } else {
+    memMonitorPrintLatest();
+  }
+}
+
+// "link" shows the conditions and counters; "link busy" picks a profile;
+// "link 20 10 5" sets 20 ms latency, 10 ms jitter and 5/1000 loss.
+void onLinkCommand(const char* args) {
+  unsigned latencyMs, jitterMs, lossPermille;
+  if (sscanf(args, "%u %u %u", &latencyMs, &jitterMs, &lossPermille) == 3) {
+    LinkConditions custom = { "custom", latencyMs * 1000, jitterMs * 1000, (uint16_t)lossPermille };
+    transportSetConditions(custom);
+    return;
+  }
+  for (int i = 0; i < LINK_PROFILE_COUNT; i++) {
+    if (strcmp(args, linkProfiles[i].name) == 0) {
+      transportSetConditions(linkProfiles[i]);
+      return;
+    }
+  }
+  if (args[0] != '\0') {
+    Serial.println("link: profiles are ideal, good, busy, lossy.");
+    return;
+  }
+  const LinkConditions& c = transportConditions();
+  const TransportStats& stats = transportStats();
+  Serial.printf("link: %s over %s: latency %u us, jitter %u us, loss %u/1000.\n",
+                c.name, transportBackend() != nullptr ? transportBackend()->name : "none",
+                c.latencyUs, c.jitterUs, c.lossPermille);
+  Serial.printf("link: sent %u, lost %u, overflow %u, max queued %u.\n",
+                stats.sent, stats.lost, stats.overflow, stats.maxQueued);
+  if (transportBackend() == &advTransport) {
+    const AdvTransportStats& adv = advTransportStats();
+    Serial.printf("link: published %u, accepted %u, duplicates %u, stale %u.\n",
+                  adv.published, adv.accepted, adv.duplicates, adv.stale);
+  } else if (transportBackend() == &espNowTransport) {
+    const EspNowTransportStats& espNow = espNowTransportStats();
+    Serial.printf("link: unacknowledged %u, game frames resent %u, abandoned %u.\n",
+                  espNow.failed, espNow.resent, espNow.abandoned);
+  }
+}
+
+void onRenderCommand(const char* args) {
+  const RenderStats& stats = renderStats();
+  if (stats.frames == 0) {
+    Serial.printf("render: %s mode, no frames yet.\n", renderModeName());
+    return;
+  }
+  Serial.printf("render: %s mode, %u frames, mean %u px, compose %u us, push %u us.\n", renderModeName(),
+                stats.frames, (unsigned)(stats.totalPixels / stats.frames),
+                (unsigned)(stats.totalComposeUs / stats.frames), (unsigned)(stats.totalPushUs / stats.frames));
+  Serial.printf("render: last frame %u px, compose %u us, push %u us.\n",
+                stats.lastFramePixels, stats.lastComposeUs, stats.lastPushUs);
+}
+
+#if PROFILER
+void onProfCommand(const char* args) {
+  if (strcmp(args, "reset") == 0) {
+    profileReset();
+    Serial.println("prof: cleared.");
+  } else {
+    profilePrint();
+  }
+}
+#endif
+
 void drawGameOverScreen() {
-  M5.Display.fillScreen(BLACK);
-  M5.Display.setTextSize(2);
-  String result;
+  PROFILE_SCOPE("draw.gameOver");
+  const char* result;
   if (deviceRole == ROLE_SHOOTER) {
     result = (!roundResultSafe) ? "You Win!" : "You Lose!";
   } else {
     result = (!roundResultSafe) ? "You Lose!" : "You Win!";
   }
-  M5.Display.drawCentreString("Game Over", screenWidth / 2, 50, 2);
-  M5.Display.drawCentreString(result, screenWidth / 2, 80, 2);
-  M5.Display.fillRect(screenWidth / 2 - 60, 120, 120, 40, BLUE);
-  M5.Display.drawRect(screenWidth / 2 - 60, 120, 120, 40, TFT_WHITE);
-  M5.Display.drawCentreString("Restart", screenWidth / 2, 130, 2);
-  Serial.println("UI: Game over screen drawn.");
+  lgfx::LovyanGFX& gfx = frameBegin();
+  gfx.fillScreen(BLACK);
+  gfx.setTextSize(2);
+  gfx.drawCentreString("Game Over", screenWidth / 2, 50, 2);
+  gfx.drawCentreString(result, screenWidth / 2, 80, 2);
+  gfx.fillRect(screenWidth / 2 - 60, 120, 120, 40, BLUE);
+  gfx.drawRect(screenWidth / 2 - 60, 120, 120, 40, TFT_WHITE);
+  gfx.drawCentreString("Restart", screenWidth / 2, 130, 2);
+  frameEnd((uint32_t)screenWidth * screenHeight);
+  screenInvalidate();
+  LOG_D("UI: Game over screen drawn.");
 }
 
 void resetGame() {
@@ -446,79 +1540,332 @@ void resetGame() {
   gameOver = false;
   roundResultSafe = false;
   dodgerChoice = 0;
+  pendingChoice = 0;
   shooterChoice = 0;
-  dodgerInputReceived = false;
-  notificationReceived = false;
-  receivedShooterChoice = 0;
-  M5.Display.fillScreen(BLACK);
-  Serial.println("Game reset.");
+  shotCount = 0;
+  shotHits = 0;
+  sessionsRestart();
+  gameOverScreenShown = false;
+  screenInvalidate();
+  LOG_I("Game reset.");
 }
 
 // --- BLE Setup Functions ---
 void setupBLE_Server() {
   BLEDevice::init("M5Core2_Shooter");
   pServer = BLEDevice::createServer();
-  pServer->setCallbacks(new MyServerCallbacks());
+  static MyServerCallbacks serverCallbacks;
+  pServer->setCallbacks(&serverCallbacks);
   pService = pServer->createService(SERVICE_UUID);
-  pCharacteristic = pService->createCharacteristic(
+  BLECharacteristic* pCharacteristic = pService->createCharacteristic(
                       CHARACTERISTIC_UUID,
                       BLECharacteristic::PROPERTY_READ |
                       BLECharacteristic::PROPERTY_WRITE |
                       BLECharacteristic::PROPERTY_NOTIFY
                     );
-  pCharacteristic->setCallbacks(new MyCharacteristicCallbacks());
-  pCharacteristic->setValue("0");
+  BLECharacteristic* pPingCharacteristic = pService->createCharacteristic(
+                          PING_CHARACTERISTIC_UUID,
+                          BLECharacteristic::PROPERTY_WRITE |
+                          BLECharacteristic::PROPERTY_WRITE_NR |
+                          BLECharacteristic::PROPERTY_NOTIFY
+                        );
+  bleTransportServe(pCharacteristic, pPingCharacteristic);
   pService->start();
   BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
   pAdvertising->addServiceUUID(SERVICE_UUID);
-  pAdvertising->setScanResponse(true);
-  pAdvertising->setMinPreferred(0x06);
-  pAdvertising->setMinPreferred(0x12);
+  // The advertising data, service UUID included, and a scan response with
+  // the preferred connection interval range.
+  spectatorBroadcastBegin(true);
   BLEDevice::startAdvertising();
-  Serial.println("BLE Server: Advertising started.");
+  LOG_I("BLE Server: Advertising started.");
 }
 
 void setupBLE_Client() {
   BLEDevice::init("");
+  static MyClientCallbacks clientCallbacks;
+  static MyAdvertisedDeviceCallbacks advertisedDeviceCallbacks;
   pClient = BLEDevice::createClient();
-  Serial.println("BLE Client: Created. Scanning for server...");
-  
+  pClient->setClientCallbacks(&clientCallbacks);
   BLEScan* pBLEScan = BLEDevice::getScan();
-  BLEAdvertisedDevice* myDevice = nullptr;
-  while (true) {
-    BLEScanResults foundDevices = pBLEScan->start(5);
-    Serial.print("BLE Client: Found devices: ");
-    Serial.println(foundDevices.getCount());
-    for (int i = 0; i < foundDevices.getCount(); i++) {
-      BLEAdvertisedDevice device = foundDevices.getDevice(i);
-      if (device.haveServiceUUID() && device.isAdvertisingService(BLEUUID(SERVICE_UUID))) {
-        myDevice = new BLEAdvertisedDevice(device);
-        break;
+  pBLEScan->setAdvertisedDeviceCallbacks(&advertisedDeviceCallbacks);
+  LOG_I("BLE Client: Created.");
+  startLinkScan();
+}
+
+// --- Dodger Link State Machine ---
+// Other transports find the shooter themselves; the link is connecting
+// until they report it up.
+void startLinkScan() {
+  if (transportBackend() != &bleTransport) {
+    linkLost = false;
+    linkState = LINK_CONNECTING;
+    connectStep = STEP_CONNECT;
+    linkStartTime = millis();
+    serverFoundTime = linkStartTime;
+    timerStart(TIMER_LINK_TICK, linkTickInterval, millis());
+    LOG_I("Link: Connecting over %s...", transportBackend()->name);
+    transportBegin(false);
+    return;
+  }
+  BLEScan* pBLEScan = BLEDevice::getScan();
+  pBLEScan->clearResults();
+  serverFound = false;
+  scanWindowEnded = false;
+  linkLost = false;
+  linkState = LINK_SCANNING;
+  linkStartTime = millis();
+  pBLEScan->start(scanWindowSeconds, scanCompleteCallback, false);
+  timerStart(TIMER_LINK_TICK, linkTickInterval, millis());
+  LOG_I("BLE Client: Scanning for server...");
+}
+
+// Arm the next reconnect attempt with exponential backoff.
+static void scheduleReconnect() {
+  uint32_t delayMs = reconnectMaxDelay;
+  if (reconnectAttempts < 5 && (reconnectBaseDelay << reconnectAttempts) < reconnectMaxDelay) {
+    delayMs = reconnectBaseDelay << reconnectAttempts;
+  }
+  reconnectAttempts++;
+  timerStart(TIMER_LINK_RETRY, delayMs, millis());
+  LOG_I("BLE Client: Reconnect attempt %d in %u ms.", reconnectAttempts, delayMs);
+}
+
+// Scans, connect tasks and reconnects allocate in the BLE stack; each of
+// those calls runs paused.
+void serviceClientLink(uint32_t firedTimers) {
+  if (linkLost && (linkState == LINK_READY || linkState == LINK_SYNCING)) {
+    linkLost = false;
+    {
+      ALLOC_TRACE_PAUSE();
+      bleTransportDetach();
+    }
+    linkState = LINK_IDLE;
+    timerCancel(TIMER_LINK_TICK);
+    if (!matchInterrupted) {
+      matchInterrupted = true;
+      linkLostTime = millis();
+    }
+    gameOverScreenShown = false;
+    LOG_I("BLE Client: Link lost, match paused.");
+    scheduleReconnect();
+  }
+  if (linkState == LINK_READY) return;
+
+  bool tapped = false;
+  if (M5.Touch.getCount() > 0 && millis() - lastTouchTime >= touchDebounce) {
+    lastTouchTime = millis();
+    TRACE_INSTANT(TRACE_TRACK_LOOP, "touch", 0);
+    tapped = true;
+  }
+  if (firedTimers & (1u << TIMER_LINK_TICK)) {
+    timerStart(TIMER_LINK_TICK, linkTickInterval, millis());
+  }
+
+  if (linkState == LINK_SCANNING) {
+    if (serverFound) {
+      serverFoundTime = millis();
+      LOG_I("BLE Client: Found server %02x:%02x:%02x:%02x:%02x:%02x after %u ms, connecting...",
+            serverAddress[0], serverAddress[1], serverAddress[2],
+            serverAddress[3], serverAddress[4], serverAddress[5],
+            serverFoundTime - linkStartTime);
+      linkState = LINK_CONNECTING;
+      connectStep = STEP_CONNECT;
+      ALLOC_TRACE_PAUSE();
+      xTaskCreate(clientConnectTask, "bleConnect", 4096, nullptr, 1, nullptr);
+    } else if (tapped) {
+      ALLOC_TRACE_PAUSE();
+      BLEDevice::getScan()->stop();
+      linkState = LINK_IDLE;
+      timerCancel(TIMER_LINK_TICK);
+      LOG_I("BLE Client: Scan cancelled.");
+    } else if (scanWindowEnded) {
+      scanWindowEnded = false;
+      ALLOC_TRACE_PAUSE();
+      BLEDevice::getScan()->clearResults();
+      BLEDevice::getScan()->start(scanWindowSeconds, scanCompleteCallback, false);
+      LOG_I("BLE Client: Server not found, rescanning...");
+    }
+  }
+  else if (linkState == LINK_CONNECTING) {
+    if (connectStep == STEP_DONE) {
+      LOG_I("BLE Client: Connected in %u ms (connect + discovery %u ms).",
+            millis() - linkStartTime, millis() - serverFoundTime);
+      if (deviceRole == ROLE_BENCH) {
+        linkState = LINK_READY;
+        timerCancel(TIMER_LINK_TICK);
+        startBench();
+      } else {
+        // The game resumes once the shooter's snapshot arrives.
+        linkState = LINK_SYNCING;
+        sendToShooter(OP_SYNC_REQUEST, dodgerChoice);
       }
+    } else if (connectStep == STEP_FAILED) {
+      linkState = LINK_IDLE;
+      timerCancel(TIMER_LINK_TICK);
+      LOG_E("BLE Client Error: Connect failed.");
+      scheduleReconnect();
     }
-    if (myDevice != nullptr) break;
-    Serial.println("BLE Client: Server not found, rescanning...");
   }
-  
-  Serial.print("BLE Client: Connecting to ");
-  Serial.println(myDevice->getAddress().toString().c_str());
-  pClient->connect(myDevice);
-  Serial.println("BLE Client: Connected to server.");
-  
-  BLERemoteService* pRemoteService = pClient->getService(BLEUUID(SERVICE_UUID));
-  if (pRemoteService == nullptr) {
-    Serial.println("BLE Client Error: Failed to find service.");
-    return;
+  else if (linkState == LINK_SYNCING) {
+    // Ask again on every progress tick until the snapshot arrives.
+    if (firedTimers & (1u << TIMER_LINK_TICK)) {
+      sendToShooter(OP_SYNC_REQUEST, dodgerChoice);
+    }
   }
-  
-  pRemoteCharacteristic = pRemoteService->getCharacteristic(BLEUUID(CHARACTERISTIC_UUID));
-  if (pRemoteCharacteristic == nullptr) {
-    Serial.println("BLE Client Error: Failed to find characteristic.");
+  else if (linkState == LINK_IDLE) {
+    if (tapped || (firedTimers & (1u << TIMER_LINK_RETRY))) {
+      timerCancel(TIMER_LINK_RETRY);
+      ALLOC_TRACE_PAUSE();
+      startLinkScan();
+    }
+  }
+}
+
+// --- Benchmark Mode ---
+static void sendBenchPing() {
+  GameFrame ping = makeFrame(OP_BENCH_PING, 0, 0);
+  benchPingSeq = ping.seq;
+  benchPingSentUs = micros();
+  benchPingsSent++;
+  sendBenchFrame(ping, GAME_FRAME_SIZE);
+  timerStart(TIMER_BENCH, benchPingTimeout, millis());
+}
+
+static void startBenchFlood() {
+  benchState = BENCH_FLOOD;
+  benchFloodSeen = 0;
+  GameFrame request = makeFrame(OP_BENCH_FLOOD, 0, 0);
+  request.seq = BENCH_FLOOD_COUNT;  // number of notifications wanted
+  sendBenchFrame(request, GAME_FRAME_SIZE);
+  timerStart(TIMER_BENCH, benchFloodIdleTimeout, millis());
+  LOG_I("Bench: Round trips done, requesting notification flood.");
+}
+
+static void finishBench() {
+  benchState = BENCH_DONE;
+  timerCancel(TIMER_BENCH);
+  benchSummarize(&benchSummary);
+  benchResultsShown = false;
+  LOG_I("Bench: RTT min %u us, p50 %u us, p99 %u us (%u ok, %u lost).",
+        benchSummary.rttMinUs, benchSummary.rttP50Us, benchSummary.rttP99Us,
+        benchSummary.pongs, benchSummary.lost);
+  if (benchSummary.rateMeasured) {
+    LOG_I("Bench: Flood %u/%d notifications, %u notif/s, %u kbps.",
+          benchSummary.floodPackets, BENCH_FLOOD_COUNT, benchSummary.notifyPerSec, benchSummary.kbps);
+  } else {
+    LOG_I("Bench: Flood %u/%d notifications, rate n/a (under two packets or no elapsed time).",
+          benchSummary.floodPackets, BENCH_FLOOD_COUNT);
+  }
+}
+
+void startBench() {
+  benchReset();
+  benchState = BENCH_RTT;
+  benchPingsSent = 0;
+  LOG_I("Bench: Starting round-trip measurement over %s.", transportBackend()->name);
+  sendBenchPing();
+}
+
+void handleBenchMessage(const GameFrame& msg) {
+  if (deviceRole == ROLE_SHOOTER) {
+    if (msg.opcode == OP_BENCH_PING) {
+      GameFrame pong = msg;
+      pong.opcode = OP_BENCH_PONG;
+      sendBenchFrame(pong, GAME_FRAME_SIZE);
+    } else if (msg.opcode == OP_BENCH_FLOOD) {
+      benchFloodRemaining = msg.seq;
+      benchFloodPeer = msg.peer;
+      benchFloodSeq = 0;
+      LOG_I("Bench: Streaming %d notifications.", benchFloodRemaining);
+    }
+  } else if (deviceRole == ROLE_BENCH && msg.opcode == OP_BENCH_PONG &&
+             benchState == BENCH_RTT && msg.seq == benchPingSeq) {
+    benchAddRtt(micros() - benchPingSentUs);
+    if (benchPingsSent < BENCH_PINGS) {
+      sendBenchPing();
+    } else {
+      startBenchFlood();
+    }
+  }
+}
+
+void serviceBench(uint32_t firedTimers) {
+  if (benchState == BENCH_RTT && (firedTimers & (1u << TIMER_BENCH))) {
+    benchAddLoss();
+    if (benchPingsSent < BENCH_PINGS) {
+      sendBenchPing();
+    } else {
+      startBenchFlood();
+    }
+  }
+  else if (benchState == BENCH_FLOOD) {
+    uint32_t seen = benchFloodPackets();
+    if (seen >= BENCH_FLOOD_COUNT) {
+      finishBench();
+    } else if (seen != benchFloodSeen) {
+      benchFloodSeen = seen;
+      timerStart(TIMER_BENCH, benchFloodIdleTimeout, millis());
+    } else if (firedTimers & (1u << TIMER_BENCH)) {
+      finishBench();  // flood stalled; report what arrived
+    }
+  }
+  else if (benchState == BENCH_DONE) {
+    if (M5.Touch.getCount() > 0 && millis() - lastTouchTime >= touchDebounce) {
+      lastTouchTime = millis();
+      TRACE_INSTANT(TRACE_TRACK_LOOP, "touch", 0);
+      screenInvalidate();
+      startBench();
+    }
+  }
+}
+
+// Progress while running, a results table once done.
+void drawBenchScreen() {
+  PROFILE_SCOPE("draw.bench");
+  if (benchState != BENCH_DONE) {
+    char status[32];
+    if (benchState == BENCH_RTT) {
+      snprintf(status, sizeof(status), "RTT %d/%d", benchPingsSent, BENCH_PINGS);
+    } else {
+      snprintf(status, sizeof(status), "Flood %lu/%d", (unsigned long)benchFloodSeen, BENCH_FLOOD_COUNT);
+    }
+    screenSetTitle("Benchmark");
+    screenSetStatus(status);
+    for (int i = 1; i <= NUM_BARRELS; i++) {
+      screenSetBarrelColor(i, BLACK);
+    }
+    screenRender();
     return;
   }
-  
-  if (pRemoteCharacteristic->canNotify())
-    pRemoteCharacteristic->registerForNotify(notifyCallback);
-  
-  Serial.println("BLE Client: Setup complete.");
+  if (benchResultsShown) return;
+
+  char line[40];
+  lgfx::LovyanGFX& gfx = frameBegin();
+  gfx.fillScreen(BLACK);
+  gfx.setTextSize(1);
+  gfx.drawCentreString("Benchmark Results", screenWidth / 2, 10, 4);
+  snprintf(line, sizeof(line), "RTT min %lu us", (unsigned long)benchSummary.rttMinUs);
+  gfx.drawString(line, 20, 50, 2);
+  snprintf(line, sizeof(line), "RTT p50 %lu us", (unsigned long)benchSummary.rttP50Us);
+  gfx.drawString(line, 20, 70, 2);
+  snprintf(line, sizeof(line), "RTT p99 %lu us", (unsigned long)benchSummary.rttP99Us);
+  gfx.drawString(line, 20, 90, 2);
+  snprintf(line, sizeof(line), "Pings %u ok, %u lost", benchSummary.pongs, benchSummary.lost);
+  gfx.drawString(line, 20, 110, 2);
+  if (benchSummary.rateMeasured) {
+    snprintf(line, sizeof(line), "Notify %lu/s, %lu kbps", (unsigned long)benchSummary.notifyPerSec,
+             (unsigned long)benchSummary.kbps);
+  } else {
+    snprintf(line, sizeof(line), "Notify n/a (not measurable)");
+  }
+  gfx.drawString(line, 20, 140, 2);
+  snprintf(line, sizeof(line), "Flood %lu/%d received", (unsigned long)benchSummary.floodPackets,
+           BENCH_FLOOD_COUNT);
+  gfx.drawString(line, 20, 160, 2);
+  snprintf(line, sizeof(line), "Link %s", transportBackend()->name);
+  gfx.drawString(line, 20, 180, 2);
+  gfx.drawCentreString("Tap to run again", screenWidth / 2, 210, 2);
+  frameEnd((uint32_t)screenWidth * screenHeight);
+  benchResultsShown = true;
+  screenInvalidate();  // the next progress screen starts from a clear panel
 }
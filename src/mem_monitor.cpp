@@ -0,0 +1,133 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "mem_monitor.h"
+
+static const char* const taskNames[MEM_TASK_COUNT] = { "loopTask", "BTC_TASK", "BTU_TASK", "log" };
+static TaskHandle_t taskHandles[MEM_TASK_COUNT] = { nullptr };
+
+static MemSample history[MEM_HISTORY];
+static uint32_t sampleCount = 0;
+static portMUX_TYPE historyLock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint16_t heapUnits(size_t bytes) {
+  size_t units = bytes / MEM_HEAP_UNIT;
+  return units > 0xFFFF ? 0xFFFF : (uint16_t)units;
+}
+
+static void monitorTask(void* param) {
+  for (;;) {
+    memMonitorSample(millis());
+    vTaskDelay(pdMS_TO_TICKS(MEM_SAMPLE_PERIOD_MS));
+  }
+}
+
+void memMonitorInit() {
+  taskHandles[MEM_TASK_LOOP] = xTaskGetCurrentTaskHandle();
+  xTaskCreate(monitorTask, "memMon", 2048, nullptr, 1, nullptr);
+}
+
+void memMonitorSample(uint32_t nowMs) {
+  const uint32_t internal = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+  MemSample sample;
+  sample.ms = nowMs;
+  sample.heapFree = heapUnits(heap_caps_get_free_size(internal));
+  sample.heapLargest = heapUnits(heap_caps_get_largest_free_block(internal));
+  sample.heapMinFree = heapUnits(heap_caps_get_minimum_free_size(internal));
+  sample.psramFreeKb = (uint16_t)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024);
+  for (int i = 0; i < MEM_TASK_COUNT; i++) {
+    // The BLE tasks only exist once the stack is up; look them up lazily.
+    if (taskHandles[i] == nullptr) {
+      taskHandles[i] = xTaskGetHandle(taskNames[i]);
+    }
+    if (taskHandles[i] == nullptr) {
+      sample.stackFree[i] = MEM_STACK_UNKNOWN;
+    } else {
+      UBaseType_t freeBytes = uxTaskGetStackHighWaterMark(taskHandles[i]);
+      sample.stackFree[i] = freeBytes >= MEM_STACK_UNKNOWN ? MEM_STACK_UNKNOWN - 1 : (uint16_t)freeBytes;
+    }
+  }
+
+  portENTER_CRITICAL(&historyLock);
+  history[sampleCount % MEM_HISTORY] = sample;
+  sampleCount++;
+  portEXIT_CRITICAL(&historyLock);
+}
+
+bool memMonitorLatest(MemSample* out) {
+  bool found = false;
+  portENTER_CRITICAL(&historyLock);
+  if (sampleCount > 0) {
+    *out = history[(sampleCount - 1) % MEM_HISTORY];
+    found = true;
+  }
+  portEXIT_CRITICAL(&historyLock);
+  return found;
+}
+
+int memMonitorHistory(MemSample* out, int max) {
+  portENTER_CRITICAL(&historyLock);
+  uint32_t available = sampleCount < MEM_HISTORY ? sampleCount : MEM_HISTORY;
+  int n = (int)available < max ? (int)available : max;
+  uint32_t first = sampleCount - (uint32_t)n;
+  for (int i = 0; i < n; i++) {
+    out[i] = history[(first + i) % MEM_HISTORY];
+  }
+  portEXIT_CRITICAL(&historyLock);
+  return n;
+}
+
+uint32_t memMonitorSampleCount() {
+  return sampleCount;
+}
+
+const char* memTaskName(int task) {
+  return task >= 0 && task < MEM_TASK_COUNT ? taskNames[task] : "?";
+}
+
+// --- Console Output ---
+static MemSample dump[MEM_HISTORY];  // static: too big for the loop stack
+
+void memMonitorPrintLatest() {
+  int n = memMonitorHistory(dump, MEM_HISTORY);
+  if (n == 0) {
+    Serial.println("mem: no samples yet.");
+    return;
+  }
+  const MemSample& last = dump[n - 1];
+  uint16_t lowLargest = last.heapLargest;
+  uint16_t lowStack[MEM_TASK_COUNT];
+  for (int t = 0; t < MEM_TASK_COUNT; t++) lowStack[t] = last.stackFree[t];
+  for (int i = 0; i < n; i++) {
+    if (dump[i].heapLargest < lowLargest) lowLargest = dump[i].heapLargest;
+    for (int t = 0; t < MEM_TASK_COUNT; t++) {
+      if (dump[i].stackFree[t] < lowStack[t]) lowStack[t] = dump[i].stackFree[t];
+    }
+  }
+  Serial.printf("mem @%lu ms: heap free %lu, largest %lu (low %lu), min ever %lu, psram free %u KB\n",
+                (unsigned long)last.ms, (unsigned long)last.heapFree * MEM_HEAP_UNIT,
+                (unsigned long)last.heapLargest * MEM_HEAP_UNIT, (unsigned long)lowLargest * MEM_HEAP_UNIT,
+                (unsigned long)last.heapMinFree * MEM_HEAP_UNIT, last.psramFreeKb);
+  for (int t = 0; t < MEM_TASK_COUNT; t++) {
+    if (last.stackFree[t] == MEM_STACK_UNKNOWN) {
+      Serial.printf("  stack %-9s not running\n", taskNames[t]);
+    } else {
+      Serial.printf("  stack %-9s %u bytes free (low %u)\n", taskNames[t], last.stackFree[t], lowStack[t]);
+    }
+  }
+  Serial.printf("  %d samples, every %u s\n", n, MEM_SAMPLE_PERIOD_MS / 1000);
+}
+
+void memMonitorPrintHistory() {
+  int n = memMonitorHistory(dump, MEM_HISTORY);
+  Serial.println("      ms   heap largest  minfree psramKB  loop   BTC   BTU   log");
+  for (int i = 0; i < n; i++) {
+    const MemSample& s = dump[i];
+    Serial.printf("%8lu %6lu %7lu %8lu %7u %5u %5u %5u %5u\n", (unsigned long)s.ms,
+                  (unsigned long)s.heapFree * MEM_HEAP_UNIT, (unsigned long)s.heapLargest * MEM_HEAP_UNIT,
+                  (unsigned long)s.heapMinFree * MEM_HEAP_UNIT, s.psramFreeKb,
+                  s.stackFree[MEM_TASK_LOOP], s.stackFree[MEM_TASK_BTC],
+                  s.stackFree[MEM_TASK_BTU], s.stackFree[MEM_TASK_LOG]);
+  }
+}
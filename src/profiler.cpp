@@ -0,0 +1,64 @@
+#include "profiler.h"
+
+#if PROFILER
+#include <Arduino.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+
+static ProfileSlot slots[PROFILE_SLOTS];
+static int slotCount = 0;
+static portMUX_TYPE slotLock = portMUX_INITIALIZER_UNLOCKED;
+
+ProfileSlot* profileSlot(const char* name) {
+  ProfileSlot* found = nullptr;
+  portENTER_CRITICAL(&slotLock);
+  for (int i = 0; i < slotCount; i++) {
+    if (strcmp(slots[i].name, name) == 0) {
+      found = &slots[i];
+      break;
+    }
+  }
+  if (found == nullptr && slotCount < PROFILE_SLOTS) {
+    found = &slots[slotCount++];
+    found->name = name;
+    found->count = 0;
+    found->totalCycles = 0;
+    found->minCycles = UINT32_MAX;
+    found->maxCycles = 0;
+  }
+  portEXIT_CRITICAL(&slotLock);
+  return found;
+}
+
+void profileReset() {
+  for (int i = 0; i < slotCount; i++) {
+    slots[i].count = 0;
+    slots[i].totalCycles = 0;
+    slots[i].minCycles = UINT32_MAX;
+    slots[i].maxCycles = 0;
+  }
+}
+
+void profilePrint() {
+#if defined(__XTENSA__)
+  uint32_t cyclesPerUs = getCpuFrequencyMhz();
+#else
+  uint32_t cyclesPerUs = 1;
+#endif
+  Serial.println("scope                    count    total us    avg us    min us    max us");
+  for (int i = 0; i < slotCount; i++) {
+    const ProfileSlot& s = slots[i];
+    if (s.count == 0) {
+      Serial.printf("%-22s %7u\n", s.name, 0u);
+      continue;
+    }
+    Serial.printf("%-22s %7lu %11llu %9lu %9lu %9lu\n", s.name, (unsigned long)s.count,
+                  (unsigned long long)(s.totalCycles / cyclesPerUs),
+                  (unsigned long)(s.totalCycles / s.count / cyclesPerUs),
+                  (unsigned long)(s.minCycles / cyclesPerUs), (unsigned long)(s.maxCycles / cyclesPerUs));
+  }
+  if (slotCount == PROFILE_SLOTS) {
+    Serial.println("(profile table full; later scopes are not recorded)");
+  }
+}
+#endif
@@ -0,0 +1,101 @@
+#include "render_target.h"
+#include "game_config.h"
+#include "game_log.h"
+#include "trace.h"
+
+static RenderStats stats = { 0, 0, 0, 0, 0, 0, 0 };
+static uint32_t composeStartUs = 0;
+
+#if RENDER_MODE == RENDER_MODE_SPRITE
+static M5Canvas canvas(&M5.Display);
+static bool canvasReady = false;
+static bool pushPending = false;  // DMA transfer may still be reading the canvas
+#endif
+
+void renderInit() {
+#if RENDER_MODE == RENDER_MODE_SPRITE
+  canvas.setColorDepth(16);
+  canvas.setPsram(true);
+  canvasReady = canvas.createSprite(screenWidth, screenHeight) != nullptr;
+  if (canvasReady) {
+    canvas.fillScreen(BLACK);
+    M5.Display.initDMA();
+    LOG_I("UI: Sprite render mode, canvas allocated in PSRAM.");
+  } else {
+    LOG_W("UI Warning: Canvas allocation failed, drawing directly.");
+  }
+#else
+  LOG_I("UI: Direct render mode.");
+#endif
+}
+
+lgfx::LovyanGFX& frameBegin() {
+  TRACE_BEGIN(TRACE_TRACK_LOOP, "frame");
+#if RENDER_MODE == RENDER_MODE_SPRITE
+  if (canvasReady) {
+    // The canvas is retained between frames, so wait until the previous
+    // transfer has finished reading it before drawing over it. Ending the
+    // bus transaction any earlier would block on the transfer anyway.
+    if (pushPending) {
+      M5.Display.waitDMA();
+      M5.Display.endWrite();
+      pushPending = false;
+    }
+    composeStartUs = micros();
+    return canvas;
+  }
+#endif
+  composeStartUs = micros();
+  M5.Display.startWrite();
+  return M5.Display;
+}
+
+void frameEnd(uint32_t pixelsDrawn) {
+  uint32_t pushStartUs = micros();
+  uint32_t pushed = pixelsDrawn;
+#if RENDER_MODE == RENDER_MODE_SPRITE
+  if (canvasReady) {
+    if (pixelsDrawn > 0) {
+      // One DMA transfer for the whole frame; the CPU returns as soon as it
+      // is queued and the transaction stays open until the next frame.
+      // (From PSRAM the driver stages it through internal RAM.)
+      M5.Display.startWrite();
+      M5.Display.pushImageDMA(0, 0, screenWidth, screenHeight,
+                              (const lgfx::swap565_t*)canvas.getBuffer());
+      pushPending = true;
+      pushed = (uint32_t)screenWidth * screenHeight;
+    }
+  } else {
+    M5.Display.endWrite();
+  }
+#else
+  M5.Display.endWrite();
+#endif
+  uint32_t endUs = micros();
+
+  TRACE_END(TRACE_TRACK_LOOP, "frame");
+  TRACE_COUNTER("frame.px", pushed);
+  stats.lastFramePixels = pushed;
+  if (pushed == 0) return;
+  stats.frames++;
+  stats.totalPixels += pushed;
+  stats.lastComposeUs = pushStartUs - composeStartUs;
+  stats.lastPushUs = endUs - pushStartUs;
+  stats.totalComposeUs += stats.lastComposeUs;
+  stats.totalPushUs += stats.lastPushUs;
+  // Per frame, so debug only; the "render" command prints the totals.
+  LOG_D("UI: Frame (%s) pushed %u px, compose %u us, push %u us.",
+        renderModeName(), pushed, stats.lastComposeUs, stats.lastPushUs);
+}
+
+const RenderStats& renderStats() {
+  return stats;
+}
+
+const char* renderModeName() {
+#if RENDER_MODE == RENDER_MODE_SPRITE
+  return canvasReady ? "sprite" : "direct";
+#else
+  return "direct";
+#endif
+}
@@ -0,0 +1,106 @@
+#include <M5Unified.h>
+#include <string.h>
+#include "screen_model.h"
+#include "render_target.h"
+
+static ScreenModel wanted = { "", "", { DARKGREY, DARKGREY, DARKGREY }, "" };
+static ScreenModel shown;
+static bool panelValid = false;
+
+static const int barrelX[NUM_BARRELS] = { button1X, button2X, button3X };
+
+void screenSetRound(int round, int maxRounds) {
+  snprintf(wanted.roundText, sizeof(wanted.roundText), "Round: %d / %d", round, maxRounds);
+}
+
+void screenSetTitle(const char* text) {
+  strncpy(wanted.roundText, text, sizeof(wanted.roundText) - 1);
+  wanted.roundText[sizeof(wanted.roundText) - 1] = '\0';
+}
+
+void screenSetStatus(const char* text) {
+  strncpy(wanted.statusText, text, sizeof(wanted.statusText) - 1);
+  wanted.statusText[sizeof(wanted.statusText) - 1] = '\0';
+}
+
+void screenSetBarrelColor(int barrel, uint16_t color) {
+  if (barrel >= 1 && barrel <= NUM_BARRELS) {
+    wanted.barrelColor[barrel - 1] = color;
+  }
+}
+
+void screenSetOverlay(const char* text) {
+  strncpy(wanted.overlayText, text, sizeof(wanted.overlayText) - 1);
+  wanted.overlayText[sizeof(wanted.overlayText) - 1] = '\0';
+}
+
+void screenInvalidate() {
+  panelValid = false;
+}
+
+// --- Element Painters (each returns the pixels it pushed) ---
+static uint32_t drawTextRow(lgfx::LovyanGFX& gfx, const char* text, int y) {
+  gfx.fillRect(0, y, screenWidth, textRowHeight, BLACK);
+  if (text[0] != '\0') {
+    gfx.drawCentreString(text, screenWidth / 2, y, 2);
+  }
+  return (uint32_t)screenWidth * textRowHeight;
+}
+
+static uint32_t drawOverlayRow(lgfx::LovyanGFX& gfx) {
+  gfx.fillRect(0, overlayTextY, screenWidth, overlayRowHeight, BLACK);
+  if (wanted.overlayText[0] != '\0') {
+    gfx.setTextSize(1);
+    gfx.setTextColor(YELLOW);
+    gfx.drawCentreString(wanted.overlayText, screenWidth / 2, overlayTextY, 2);
+    gfx.setTextColor(WHITE);
+    gfx.setTextSize(2);
+  }
+  return (uint32_t)screenWidth * overlayRowHeight;
+}
+
+static uint32_t drawBarrel(lgfx::LovyanGFX& gfx, int index) {
+  int x = barrelX[index];
+  char label[8];
+  snprintf(label, sizeof(label), "Barrel%d", index + 1);
+  gfx.fillRect(x, buttonY, buttonWidth, buttonHeight, wanted.barrelColor[index]);
+  gfx.drawRect(x, buttonY, buttonWidth, buttonHeight, TFT_WHITE);
+  gfx.drawCentreString(label, x + buttonWidth / 2, buttonY + 15, 2);
+  return (uint32_t)buttonWidth * buttonHeight;
+}
+
+uint8_t screenDirtyMask() {
+  if (!panelValid) return (1 << ELEM_COUNT) - 1;
+  uint8_t mask = 0;
+  if (strcmp(wanted.roundText, shown.roundText) != 0) mask |= 1 << ELEM_ROUND;
+  if (strcmp(wanted.statusText, shown.statusText) != 0) mask |= 1 << ELEM_STATUS;
+  for (int i = 0; i < NUM_BARRELS; i++) {
+    if (wanted.barrelColor[i] != shown.barrelColor[i]) mask |= 1 << (ELEM_BARREL1 + i);
+  }
+  if (strcmp(wanted.overlayText, shown.overlayText) != 0) mask |= 1 << ELEM_OVERLAY;
+  return mask;
+}
+
+uint32_t screenRender() {
+  uint8_t dirty = screenDirtyMask();
+  uint32_t pixels = 0;
+  if (dirty == 0) return 0;
+
+  lgfx::LovyanGFX& gfx = frameBegin();
+  gfx.setTextSize(2);
+  if (!panelValid) {
+    gfx.fillScreen(BLACK);
+    pixels += (uint32_t)screenWidth * screenHeight;
+  }
+  if (dirty & (1 << ELEM_ROUND)) pixels += drawTextRow(gfx, wanted.roundText, roundTextY);
+  if (dirty & (1 << ELEM_STATUS)) pixels += drawTextRow(gfx, wanted.statusText, statusTextY);
+  for (int i = 0; i < NUM_BARRELS; i++) {
+    if (dirty & (1 << (ELEM_BARREL1 + i))) pixels += drawBarrel(gfx, i);
+  }
+  if (dirty & (1 << ELEM_OVERLAY)) pixels += drawOverlayRow(gfx);
+  frameEnd(pixels);
+
+  shown = wanted;
+  panelValid = true;
+  return pixels;
+}
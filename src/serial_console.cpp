@@ -0,0 +1,59 @@
+#include <Arduino.h>
+#include <string.h>
+#include "serial_console.h"
+
+struct ConsoleCommand {
+  const char* name;
+  const char* help;
+  ConsoleHandler handler;
+};
+
+static ConsoleCommand commands[CONSOLE_MAX_COMMANDS];
+static int commandCount = 0;
+static char line[CONSOLE_LINE_SIZE];
+static size_t lineLen = 0;
+
+bool consoleRegister(const char* name, const char* help, ConsoleHandler handler) {
+  if (commandCount >= CONSOLE_MAX_COMMANDS) return false;
+  commands[commandCount].name = name;
+  commands[commandCount].help = help;
+  commands[commandCount].handler = handler;
+  commandCount++;
+  return true;
+}
+
+static void runLine(char* text) {
+  while (*text == ' ') text++;
+  if (*text == '\0') return;
+  char* args = text;
+  while (*args != '\0' && *args != ' ') args++;
+  if (*args != '\0') *args++ = '\0';
+  while (*args == ' ') args++;
+
+  if (strcmp(text, "help") == 0) {
+    for (int i = 0; i < commandCount; i++) {
+      Serial.printf("  %-8s %s\n", commands[i].name, commands[i].help);
+    }
+    return;
+  }
+  for (int i = 0; i < commandCount; i++) {
+    if (strcmp(text, commands[i].name) == 0) {
+      commands[i].handler(args);
+      return;
+    }
+  }
+  Serial.printf("Unknown command '%s' (try help).\n", text);
+}
+
+void consolePoll() {
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    if (c == '\r' || c == '\n') {
+      line[lineLen] = '\0';
+      lineLen = 0;
+      runLine(line);
+    } else if (lineLen + 1 < sizeof(line)) {
+      line[lineLen++] = (char)c;
+    }
+  }
+}
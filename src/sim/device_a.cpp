@@ -0,0 +1,8 @@
+// Simulated device A: a complete copy of the firmware (see sim_firmware.h).
+#include "sim_firmware.h"
+
+namespace device_a {
+#include "firmware_sources.inc"
+}
+
+SIM_FIRMWARE(device_a);
@@ -0,0 +1,8 @@
+// Simulated device B: a complete copy of the firmware (see sim_firmware.h).
+#include "sim_firmware.h"
+
+namespace device_b {
+#include "firmware_sources.inc"
+}
+
+SIM_FIRMWARE(device_b);
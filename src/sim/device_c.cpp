@@ -0,0 +1,9 @@
+// Simulated device C: a complete copy of the firmware (see sim_firmware.h),
+// for the spectator that --spectator adds.
+#include "sim_firmware.h"
+
+namespace device_c {
+#include "firmware_sources.inc"
+}
+
+SIM_FIRMWARE(device_c);
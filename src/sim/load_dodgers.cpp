@@ -0,0 +1,261 @@
+// Synthetic dodgers for the --load test: the BLE link and the game
+// protocol with no screen, touch or state machine, so one shooter can be
+// given as many connections as its session table takes. One build runs on
+// every load device; its state is kept per device (simCurrentDevice()).
+//
+// Each one scans for the shooter, connects, subscribes and asks for a
+// snapshot, then picks a random barrel the moment it may: as soon as it
+// knows its result, so the shooter holds choices for later rounds, and a
+// little after its match ends, once the shooter shows it out. It answers
+// pings like a dodger, and records how long each shot took to reach it.
+//
+// With drops on, the first of them hangs up in the middle of a match every
+// dropEveryMs and stays away until the others have finished
+// dropAwayMatches matches between them, which they can only do if the
+// shooter ends a match without it. Then it reconnects and carries on from
+// the snapshot, as a dodger would after losing its link.
+#include <algorithm>
+#include <vector>
+#include "sim_firmware.h"
+#include "ble_service.h"
+
+namespace load_dodger {
+#include "../game_protocol.cpp"
+
+static const uint32_t stepMs = 20;
+static const uint32_t restartDelayMs = 2000;  // past the shooter's result display
+static const uint32_t resyncIdleMs = 10000;   // heard nothing: ask for a snapshot
+static const uint32_t retryDelayMs = 500;
+static const uint32_t dropEveryMs = 30000;
+static const uint32_t dropAwayMatches = 3;
+
+enum LoadLinkState { LOAD_SCANNING, LOAD_FOUND, LOAD_PLAYING };
+
+struct LoadDodger {
+  LoadLinkState link;
+  bool lost;                  // set by the client callback
+  bool joined;                // has had a snapshot
+  esp_bd_addr_t server;
+  BLEClient* client;
+  BLERemoteCharacteristic* game;
+  uint8_t round;              // the round the last choice was for
+  uint8_t choice;             // 0 while a choice is due
+  uint32_t restartAtMs;       // match over: choose round 1 then (0: not pending)
+  uint32_t heardMs;
+  uint32_t retryAtMs;
+  uint16_t seq;
+  uint32_t rng;
+  bool drops;                 // hangs up mid-match now and then
+  uint32_t dropAtMs;
+  uint32_t backAtMatches;     // away until stats.matches reaches this
+};
+
+static LoadDodger dodgers[SIM_MAX_DEVICES];
+static LoadDodgerStats stats;
+static bool dropsEnabled = false;
+static bool dropperChosen = false;
+static std::vector<uint32_t> latencies;
+
+static LoadDodger& self() {
+  return dodgers[simCurrentDevice()];
+}
+
+static uint8_t randomBarrel(LoadDodger& d) {
+  d.rng ^= d.rng << 13;
+  d.rng ^= d.rng >> 17;
+  d.rng ^= d.rng << 5;
+  return (uint8_t)(1 + d.rng % NUM_BARRELS);
+}
+
+static void sendFrame(LoadDodger& d, uint8_t opcode, uint8_t round, uint8_t choice, uint16_t seq) {
+  if (d.game == nullptr) return;
+  GameFrame frame = { opcode, round, choice, 0, seq, micros(), 0, 0, 0, 0 };
+  uint8_t buf[GAME_FRAME_SIZE];
+  gameFrameEncode(frame, buf, sizeof(buf));
+  d.game->writeValue(buf, sizeof(buf), true);
+}
+
+static void choose(LoadDodger& d, uint8_t round) {
+  d.round = round;
+  d.choice = randomBarrel(d);
+  d.restartAtMs = 0;
+  sendFrame(d, OP_DODGER_CHOICE, round, d.choice, d.seq++);
+}
+
+// Out of this match: the shooter takes a round-1 choice once it shows the
+// session out, after its result display.
+static void matchOver(LoadDodger& d) {
+  stats.matches++;
+  d.choice = 0;
+  d.restartAtMs = millis() + restartDelayMs;
+  if (d.restartAtMs == 0) d.restartAtMs = 1;
+}
+
+// --- Frames From the Shooter ---
+static void onShot(LoadDodger& d, const GameFrameView& shot) {
+  if (shot.round() != d.round || d.choice == 0) return;
+  latencies.push_back((uint32_t)simNowUs() - shot.sentUs());
+  stats.shots++;
+  if (shot.choice() == d.choice || d.round >= MAX_ROUNDS) {
+    matchOver(d);
+  } else {
+    choose(d, d.round + 1);
+  }
+}
+
+static void onSnapshot(LoadDodger& d, const GameFrameView& snap) {
+  uint8_t flags = snap.flags();
+  if (!d.joined) {
+    d.joined = true;
+    stats.joined++;
+  }
+  d.round = snap.round();
+  if (flags & SNAP_GAME_OVER) {
+    d.choice = 0;
+    d.restartAtMs = 1;  // already shown out
+  } else if (flags & SNAP_SHOT_FIRED) {
+    if ((flags & SNAP_RESULT_SAFE) && d.round < MAX_ROUNDS) {
+      choose(d, d.round + 1);
+    } else {
+      d.choice = 0;
+      d.restartAtMs = millis() + restartDelayMs;
+    }
+  } else if (snap.choice() != 0) {
+    d.choice = snap.choice();
+  } else {
+    choose(d, d.round);
+  }
+}
+
+static void onGameNotify(BLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
+  LoadDodger& d = self();
+  GameFrameView frame;
+  if (gameFrameDecode(data, length, &frame) != FRAME_OK) return;
+  d.heardMs = millis();
+  if (frame.opcode() == OP_PING) {
+    sendFrame(d, OP_PONG, frame.round(), 0, frame.seq());  // echoes the sequence number
+  } else if (frame.opcode() == OP_SNAPSHOT) {
+    if (d.link == LOAD_PLAYING && d.game != nullptr) onSnapshot(d, frame);
+  } else if (frame.opcode() == OP_SHOT) {
+    onShot(d, frame);
+  }
+}
+
+// --- Link ---
+class LoadScanCallbacks : public BLEAdvertisedDeviceCallbacks {
+  void onResult(BLEAdvertisedDevice device) {
+    LoadDodger& d = self();
+    if (d.link != LOAD_SCANNING || !device.haveServiceUUID() ||
+        !device.isAdvertisingService(BLEUUID(SERVICE_UUID))) {
+      return;
+    }
+    memcpy(d.server, *device.getAddress().getNative(), sizeof(esp_bd_addr_t));
+    d.link = LOAD_FOUND;
+    BLEDevice::getScan()->stop();
+  }
+};
+
+class LoadClientCallbacks : public BLEClientCallbacks {
+  void onConnect(BLEClient* client) {}
+  void onDisconnect(BLEClient* client) {
+    self().lost = true;
+  }
+};
+
+static void startScan(LoadDodger& d) {
+  d.link = LOAD_SCANNING;
+  BLEDevice::getScan()->clearResults();
+  BLEDevice::getScan()->start(0, nullptr, false);
+}
+
+// Blocks this device's loop through connection and discovery.
+static bool connectToShooter(LoadDodger& d) {
+  d.lost = false;
+  if (!d.client->connect(BLEAddress(d.server))) return false;
+  BLERemoteService* service = d.client->getService(BLEUUID(SERVICE_UUID));
+  BLERemoteCharacteristic* game = service != nullptr ? service->getCharacteristic(BLEUUID(CHARACTERISTIC_UUID)) : nullptr;
+  if (game == nullptr || !game->canNotify()) {
+    d.client->disconnect();
+    return false;
+  }
+  game->registerForNotify(onGameNotify);
+  d.game = game;
+  return true;
+}
+
+// Hangs up with a choice in for round 2 or later, so the match is under way.
+static void dropMidMatch(LoadDodger& d, uint32_t now) {
+  if (!d.drops || d.choice == 0 || d.round < 2 || (int32_t)(now - d.dropAtMs) < 0) return;
+  stats.drops++;
+  d.dropAtMs = now + dropEveryMs;
+  d.client->disconnect();
+  d.game = nullptr;
+  d.backAtMatches = stats.matches + dropAwayMatches;
+  d.link = LOAD_FOUND;
+}
+
+void setup() {
+  static LoadScanCallbacks scanCallbacks;
+  static LoadClientCallbacks clientCallbacks;
+  LoadDodger& d = self();
+  d.rng = 0x9E3779B9u ^ ((uint32_t)simCurrentDevice() * 0x85EBCA6Bu);
+  if (dropsEnabled && !dropperChosen) {
+    dropperChosen = true;
+    d.drops = true;
+    d.dropAtMs = millis() + dropEveryMs;
+  }
+  BLEDevice::init("");
+  d.client = BLEDevice::createClient();
+  d.client->setClientCallbacks(&clientCallbacks);
+  BLEDevice::getScan()->setAdvertisedDeviceCallbacks(&scanCallbacks);
+  startScan(d);
+}
+
+void loop() {
+  LoadDodger& d = self();
+  uint32_t now = millis();
+  if (d.link == LOAD_PLAYING && d.lost) {
+    d.game = nullptr;
+    d.retryAtMs = now + retryDelayMs;
+    d.link = LOAD_FOUND;  // the same shooter
+  }
+  if (d.link == LOAD_FOUND && stats.matches >= d.backAtMatches && (int32_t)(now - d.retryAtMs) >= 0) {
+    if (connectToShooter(d)) {
+      d.link = LOAD_PLAYING;
+      d.heardMs = millis();
+      sendFrame(d, OP_SYNC_REQUEST, 0, 0, d.seq++);
+    } else {
+      // Refused (the shooter is full) or not advertising: look again later.
+      d.retryAtMs = millis() + retryDelayMs;
+    }
+  }
+  if (d.link == LOAD_PLAYING) {
+    if (d.restartAtMs != 0 && (int32_t)(now - d.restartAtMs) >= 0) {
+      choose(d, 1);
+    } else if (now - d.heardMs > resyncIdleMs) {
+      d.heardMs = now;
+      sendFrame(d, OP_SYNC_REQUEST, 0, 0, d.seq++);
+    }
+    dropMidMatch(d, now);
+  }
+  delay(stepMs);
+}
+}  // namespace load_dodger
+
+SIM_FIRMWARE(load_dodger);
+
+void loadDodgerEnableDrops() {
+  load_dodger::dropsEnabled = true;
+}
+
+LoadDodgerStats loadDodgerStats() {
+  LoadDodgerStats result = load_dodger::stats;
+  std::vector<uint32_t> sorted = load_dodger::latencies;
+  std::sort(sorted.begin(), sorted.end());
+  if (!sorted.empty()) {
+    result.latencyP50Us = sorted[sorted.size() / 2];
+    result.latencyP99Us = sorted[sorted.size() * 99 / 100];
+    result.latencyMaxUs = sorted.back();
+  }
+  return result;
+}
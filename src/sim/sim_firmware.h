@@ -0,0 +1,59 @@
+#ifndef SIM_FIRMWARE_H
+#define SIM_FIRMWARE_H
+
+// --- Simulated Firmware Instances ---
+// Each simulated device runs its own copy of the firmware: device_a.cpp,
+// device_b.cpp and device_c.cpp compile every source file into a
+// namespace of their own, so each copy has its own globals and file statics. The headers the
+// sources pull in from outside the project are included here first, at
+// global scope, so their include guards keep them out of the namespaces
+// and all copies share one HAL (lib/sim_hal).
+#include <Arduino.h>
+#include <M5Unified.h>
+#include <BLEDevice.h>
+#include <BLEUtils.h>
+#include <BLEServer.h>
+#include <BLEClient.h>
+#include <BLEScan.h>
+#include <BLEAdvertisedDevice.h>
+#include <BLERemoteCharacteristic.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sim_hal.h>
+#include <sim_link.h>
+
+extern const SimFirmware device_aFirmware;
+extern const SimFirmware device_bFirmware;
+extern const SimFirmware device_cFirmware;
+
+// Synthetic dodgers for the --load test (load_dodgers.cpp), totals across
+// every device running them.
+struct LoadDodgerStats {
+  uint32_t joined;        // dodgers that got a snapshot
+  uint32_t shots;         // shots that reached them
+  uint32_t matches;       // matches they finished
+  uint32_t drops;         // links hung up mid-match (--drop)
+  uint32_t latencyP50Us;  // shot sent to received
+  uint32_t latencyP99Us;
+  uint32_t latencyMaxUs;
+};
+
+extern const SimFirmware load_dodgerFirmware;
+LoadDodgerStats loadDodgerStats();
+// Before the load dodgers start: the first one hangs up mid-match now and
+// then (see load_dodgers.cpp).
+void loadDodgerEnableDrops();
+
+#endif // SIM_FIRMWARE_H
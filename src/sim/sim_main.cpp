@@ -0,0 +1,352 @@
+// --- Two-Device Simulator ---
+// Runs a shooter and a dodger (or a benchmark client with --bench) in one
+// process over the simulated BLE radio. A bot on each device picks its role
+// on the selection screen, then taps random barrels, and Restart when the
+// match is over. Both serial monitors are printed to stdout; when the time
+// is up each device is asked for its latency histogram ("lat") and the
+// panel frame counts are printed.
+//
+// Time is virtual unless --realtime is given: the run does not wait for
+// the wall clock and gives the same output for the same seed every time.
+// --matches N plays N full matches (Restart in between) and prints the
+// tally and a digest of all serial output; add --quiet to skip the log.
+//
+// --snapshots DIR saves the first frame of each known screen on each device
+// as DIR/<device>-<screen>.ppm (and .png). --golden DIR compares those
+// frames with the same files in DIR and exits with 1 if any differ, so a
+// layout change shows up before it is flashed. The reference images live
+// in test/golden (see the README there for the run that checks them all).
+//
+// --transport picks how game frames travel: "ble" (the simulated radio),
+// "espnow" (the simulated ESP-NOW radio), "adv" (BLE advertisements, with
+// no connection), "loopback" (straight to the other device, no radio) or
+// "socket" (a Unix socket at --socket PATH, to another simulator process).
+// The bots pick espnow and adv on the role screen, as a player would. --device runs
+// only the named device, for a pair of processes over a socket, e.g.
+//   program --device shooter --seconds 60 & program --device dodger --seconds 60
+// --link SPEC applies link conditions on each device, as the "link"
+// console command would ("busy", or "latency_ms jitter_ms loss_permille").
+//
+// --load [N] is a load test of the shooter's dodger sessions: instead of
+// the dodger, N synthetic dodgers (load_dodgers.cpp, default MAX_DODGERS)
+// connect over the simulated BLE radio and play every round as fast as
+// the shooter takes them. The run ends with their joins, shots, matches and
+// shot delivery latency. Over BLE only; the other links carry one dodger.
+// Add --drop (with two or more) to have one of them hang up mid-match now
+// and then and stay away until the others have played on without it: the
+// run stalls if the shooter waits for a dodger that is gone.
+//
+// --spectator adds a third device that picks Spectator on the role screen
+// and follows the match from the shooter's advertisements alone.
+//
+//   pio run -e native && .pio/build/native/program [--seconds N] [--seed N] [--bench]
+//       [--matches N] [--realtime] [--quiet] [--snapshots DIR] [--golden DIR]
+//       [--transport ble|espnow|adv|loopback|socket] [--socket PATH] [--device shooter|dodger|bench]
+//       [--link SPEC] [--load [N]] [--drop] [--spectator]
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sim_hal.h>
+#include "game_config.h"
+#include "dodger_sessions.h"
+#include "sim_firmware.h"
+
+enum BotRole { BOT_SHOOTER, BOT_DODGER, BOT_BENCH, BOT_SPECTATOR };
+
+struct Bot {
+  int device;
+  BotRole role;
+  uint32_t nextTapMs;
+};
+
+static const uint32_t botStepMs = 20;
+static const uint32_t tapHoldMs = 80;
+static const uint32_t firstTapMs = 1500;  // after power-up, once the role screen is up
+static const uint32_t matchLimitMs = 120000;  // --matches: give up if one takes longer
+
+static uint32_t rngState = 1;
+static const char* pickLink = nullptr;  // bots step the role screen's link toggle to this label
+
+// --- Screen Snapshots ---
+// A screen is recognised by text on the panel; the ones listed are drawn
+// the same way in every run.
+struct ScreenKey {
+  const char* name;
+  const char* text;
+  const char* alsoText;
+};
+
+static const ScreenKey screenKeys[] = {
+  { "roles", "Benchmark", "Dodger" },
+  { "wait-dodger", "Waiting for dodger...", nullptr },
+  { "shoot", "Select barrel to shoot", nullptr },
+  { "hide", "Select barrel to hide", nullptr },
+  { "wait-shot", "Waiting for shot...", nullptr },
+  { "win", "Game Over", "You Win!" },
+  { "lose", "Game Over", "You Lose!" },
+  { "aiming", "Shooter aiming...", nullptr },
+};
+static const int screenKeyCount = sizeof(screenKeys) / sizeof(screenKeys[0]);
+
+static const char* snapshotDir = nullptr;
+static const char* goldenDir = nullptr;
+static const char* deviceLabels[SIM_MAX_DEVICES];
+static bool snapped[SIM_MAX_DEVICES][screenKeyCount];
+static int goldenFailures = 0;
+
+// Matches finished, counted on the game-over screen of one device: the
+// shooter if it runs in this process, else the dodger.
+static int tallyDevice = 0;
+static bool tallyOnShooter = true;
+static uint32_t matchesPlayed = 0;
+static uint32_t shooterWins = 0;
+static bool tallyGameOver = false;
+
+static void countMatch(int device) {
+  if (device != tallyDevice) return;
+  bool over = simScreenHasText(device, "Game Over");
+  if (over && !tallyGameOver) {
+    matchesPlayed++;
+    if (simScreenHasText(device, tallyOnShooter ? "You Win!" : "You Lose!")) shooterWins++;
+  }
+  tallyGameOver = over;
+}
+
+static void onFrame(int device) {
+  countMatch(device);
+  if (snapshotDir == nullptr && goldenDir == nullptr) return;
+  for (int k = 0; k < screenKeyCount; k++) {
+    const ScreenKey& key = screenKeys[k];
+    if (snapped[device][k] || !simScreenHasText(device, key.text)) continue;
+    if (key.alsoText != nullptr && !simScreenHasText(device, key.alsoText)) continue;
+    snapped[device][k] = true;
+    char path[256];
+    if (snapshotDir != nullptr) {
+      snprintf(path, sizeof(path), "%s/%s-%s.ppm", snapshotDir, deviceLabels[device], key.name);
+      bool ok = simScreenSave(device, path);
+      snprintf(path, sizeof(path), "%s/%s-%s.png", snapshotDir, deviceLabels[device], key.name);
+      ok = simScreenSave(device, path) && ok;
+      if (!ok) fprintf(stderr, "sim: could not write %s\n", path);
+    }
+    if (goldenDir != nullptr) {
+      snprintf(path, sizeof(path), "%s/%s-%s.ppm", goldenDir, deviceLabels[device], key.name);
+      long differing = simScreenCompare(device, path);
+      if (differing < 0) {
+        printf("golden: %s-%s: no golden image\n", deviceLabels[device], key.name);
+      } else if (differing > 0) {
+        printf("golden: %s-%s: %ld pixels differ\n", deviceLabels[device], key.name, differing);
+        goldenFailures++;
+      } else {
+        printf("golden: %s-%s: match\n", deviceLabels[device], key.name);
+      }
+    }
+  }
+}
+
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static void tapCentre(int device, int x, int y, int w, int h) {
+  simTouch(device, x + w / 2, y + h / 2, tapHoldMs);
+}
+
+static void botStep(Bot& bot, uint32_t nowMs) {
+  if (nowMs < bot.nextTapMs) return;
+  bot.nextTapMs = nowMs + 400 + nextRandom() % 800;
+  if (simScreenHasText(bot.device, "Benchmark") && simScreenHasText(bot.device, "Dodger")) {
+    if (pickLink != nullptr && !simScreenHasText(bot.device, pickLink)) {
+      tapCentre(bot.device, linkButtonX, linkButtonY, linkButtonWidth, linkButtonHeight);
+    } else if (bot.role == BOT_SHOOTER) {
+      tapCentre(bot.device, 0, roleButtonY, roleButtonWidth, roleButtonHeight);
+    } else if (bot.role == BOT_DODGER) {
+      tapCentre(bot.device, roleButtonWidth, roleButtonY, roleButtonWidth, roleButtonHeight);
+    } else if (bot.role == BOT_BENCH) {
+      tapCentre(bot.device, benchButtonX, benchButtonY, benchButtonWidth, benchButtonHeight);
+    } else {
+      tapCentre(bot.device, spectatorButtonX, spectatorButtonY, spectatorButtonWidth, spectatorButtonHeight);
+    }
+  } else if (bot.role == BOT_BENCH || bot.role == BOT_SPECTATOR) {
+    // One benchmark run; tapping again would restart it. Spectators only watch.
+  } else if (simScreenHasText(bot.device, "Restart")) {
+    tapCentre(bot.device, screenWidth / 2 - 60, 120, 120, 40);
+  } else {
+    static const int barrelX[NUM_BARRELS] = { button1X, button2X, button3X };
+    tapCentre(bot.device, barrelX[nextRandom() % NUM_BARRELS], buttonY, buttonWidth, buttonHeight);
+  }
+}
+
+static const char* const botRoleNames[] = { "shooter", "dodger", "bench", "spectator" };
+
+static bool parseBotRole(const char* name, BotRole* role) {
+  for (int r = BOT_SHOOTER; r <= BOT_BENCH; r++) {
+    if (strcmp(name, botRoleNames[r]) == 0) {
+      *role = (BotRole)r;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parseTransport(const char* name, SimLinkKind* kind) {
+  pickLink = nullptr;
+  if (strcmp(name, "espnow") == 0) pickLink = "ESP-NOW link";
+  else if (strcmp(name, "adv") == 0) pickLink = "Advert link";
+  if (strcmp(name, "ble") == 0 || pickLink != nullptr) *kind = SIM_LINK_NONE;
+  else if (strcmp(name, "loopback") == 0) *kind = SIM_LINK_LOOPBACK;
+  else if (strcmp(name, "socket") == 0) *kind = SIM_LINK_UNIX_SOCKET;
+  else return false;
+  return true;
+}
+
+int main(int argc, char** argv) {
+  uint32_t seconds = 0;
+  uint32_t matches = 0;
+  bool bench = false;
+  bool realtime = false;
+  bool quiet = false;
+  SimLinkKind linkKind = SIM_LINK_NONE;
+  const char* socketPath = "/tmp/dodge-sim.sock";
+  bool single = false;
+  BotRole singleRole = BOT_SHOOTER;
+  const char* linkSpec = nullptr;
+  int loadDodgers = 0;
+  bool loadDrops = false;
+  bool spectator = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      rngState = (uint32_t)strtoul(argv[++i], nullptr, 10);
+      if (rngState == 0) rngState = 1;
+    } else if (strcmp(argv[i], "--bench") == 0) {
+      bench = true;
+    } else if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+      matches = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--realtime") == 0) {
+      realtime = true;
+    } else if (strcmp(argv[i], "--quiet") == 0) {
+      quiet = true;
+    } else if (strcmp(argv[i], "--snapshots") == 0 && i + 1 < argc) {
+      snapshotDir = argv[++i];
+    } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+      goldenDir = argv[++i];
+    } else if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc && parseTransport(argv[i + 1], &linkKind)) {
+      i++;
+    } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socketPath = argv[++i];
+    } else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc && parseBotRole(argv[i + 1], &singleRole)) {
+      single = true;
+      i++;
+    } else if (strcmp(argv[i], "--link") == 0 && i + 1 < argc) {
+      linkSpec = argv[++i];
+    } else if (strcmp(argv[i], "--load") == 0) {
+      loadDodgers = MAX_DODGERS;
+      if (i + 1 < argc && argv[i + 1][0] >= '1' && argv[i + 1][0] <= '9') {
+        loadDodgers = (int)strtoul(argv[++i], nullptr, 10);
+      }
+      if (loadDodgers > SIM_MAX_DEVICES - 2) loadDodgers = SIM_MAX_DEVICES - 2;
+    } else if (strcmp(argv[i], "--drop") == 0) {
+      loadDrops = true;
+    } else if (strcmp(argv[i], "--spectator") == 0) {
+      spectator = true;
+    } else {
+      fprintf(stderr, "usage: %s [--seconds N] [--seed N] [--bench] [--matches N] [--realtime] [--quiet]\n"
+                      "          [--snapshots DIR] [--golden DIR] [--transport ble|espnow|adv|loopback|socket]\n"
+                      "          [--socket PATH] [--device shooter|dodger|bench] [--link SPEC] [--load [N]]\n"
+                      "          [--drop] [--spectator]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // A lone device can only reach its peer in another process.
+  if (single) linkKind = SIM_LINK_UNIX_SOCKET;
+  if (loadDodgers > 0) {
+    single = false;
+    bench = false;
+    linkKind = SIM_LINK_NONE;
+    pickLink = nullptr;
+  }
+  if (linkKind == SIM_LINK_UNIX_SOCKET) realtime = true;
+  if (bench || (single && singleRole == BOT_BENCH)) matches = 0;
+  if (seconds == 0) seconds = matches > 0 ? matches * matchLimitMs / 1000 : 60;
+  simSetClock(realtime ? SIM_CLOCK_REAL : SIM_CLOCK_VIRTUAL);
+  simSetSerialEcho(!quiet);
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+
+  // The second device powers up a little later, so the two clocks differ.
+  Bot bots[3];
+  int botCount = 0;
+  if (single) {
+    bots[botCount++] = { simAddDevice(device_aFirmware, botRoleNames[singleRole], 0), singleRole, firstTapMs };
+  } else if (loadDodgers > 0) {
+    // Only the shooter is a bot; the synthetic dodgers power up one after
+    // another and find it on their own.
+    if (loadDrops && loadDodgers > 1) loadDodgerEnableDrops();
+    bots[botCount++] = { simAddDevice(device_aFirmware, "shooter", 0), BOT_SHOOTER, firstTapMs };
+    for (int i = 0; i < loadDodgers; i++) {
+      char label[16];
+      snprintf(label, sizeof(label), "load%d", i + 1);
+      simAddDevice(load_dodgerFirmware, label, 2000 + 150 * i);
+    }
+  } else {
+    BotRole peer = bench ? BOT_BENCH : BOT_DODGER;
+    bots[botCount++] = { simAddDevice(device_aFirmware, "shooter", 0), BOT_SHOOTER, firstTapMs };
+    bots[botCount++] = { simAddDevice(device_bFirmware, botRoleNames[peer], 350), peer, firstTapMs + 350 };
+  }
+  if (spectator && !single) {
+    bots[botCount++] = { simAddDevice(device_cFirmware, "spectator", 700), BOT_SPECTATOR, firstTapMs + 700 };
+  }
+  for (int i = 0; i < botCount; i++) {
+    deviceLabels[bots[i].device] = botRoleNames[bots[i].role];
+    if (linkKind != SIM_LINK_NONE) simSetLink(bots[i].device, linkKind, socketPath);
+    if (linkSpec != nullptr) {
+      char line[64];
+      snprintf(line, sizeof(line), "link %s\n", linkSpec);
+      simSerialInput(bots[i].device, line);
+    }
+  }
+  tallyDevice = bots[0].device;
+  tallyOnShooter = (bots[0].role == BOT_SHOOTER);
+  simSetFrameHook(onFrame);
+
+  for (uint32_t nowMs = 0; nowMs < seconds * 1000; nowMs += botStepMs) {
+    simRunFor(botStepMs);
+    if (matches > 0 && matchesPlayed >= matches) break;
+    for (int i = 0; i < botCount; i++) botStep(bots[i], nowMs);
+  }
+  for (int i = 0; i < botCount; i++) {
+    simSerialInput(bots[i].device, linkSpec != nullptr ? "link\nlat\n" : "lat\n");
+  }
+  simRunFor(200);
+
+  for (int i = 0; i < botCount; i++) {
+    SimFrameStats stats = simFrameStats(bots[i].device);
+    printf("frames: %s: %u frames, %llu px, mean %llu px, max %llu px\n", deviceLabels[bots[i].device], stats.frames,
+           (unsigned long long)stats.totalPixels,
+           (unsigned long long)(stats.frames > 0 ? stats.totalPixels / stats.frames : 0),
+           (unsigned long long)stats.maxPixels);
+  }
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  double simSeconds = simNowUs() / 1e6;
+  printf("matches: %u played, shooter won %u, dodger won %u\n", matchesPlayed, shooterWins,
+         matchesPlayed - shooterWins);
+  if (loadDodgers > 0) {
+    LoadDodgerStats load = loadDodgerStats();
+    printf("load: %d dodgers (%d sessions), %u joined, %u shots, %u dodger matches, %u drops, "
+           "shot latency p50 %u us, p99 %u us, max %u us\n", loadDodgers, MAX_DODGERS, load.joined,
+           load.shots, load.matches, load.drops, load.latencyP50Us, load.latencyP99Us, load.latencyMaxUs);
+  }
+  printf("time: %.1f s simulated in %.2f s (%.0fx)\n", simSeconds, wallSeconds,
+         wallSeconds > 0 ? simSeconds / wallSeconds : 0.0);
+  printf("digest: %016llx\n", (unsigned long long)simSerialDigest());
+  if (matches > 0 && matchesPlayed < matches) {
+    fprintf(stderr, "sim: only %u of %u matches finished\n", matchesPlayed, matches);
+    return 1;
+  }
+  return goldenFailures > 0 ? 1 : 0;
+}
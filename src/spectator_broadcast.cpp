@@ -0,0 +1,172 @@
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEAdvertisedDevice.h>
+#include <BLEScan.h>
+#include <string.h>
+#include <string>
+#include "spectator_broadcast.h"
+#include "alloc_trace.h"
+#include "ble_service.h"
+#include "game_events.h"
+#include "game_log.h"
+#include "spsc_ring.h"
+
+// Manufacturer data layout: company ID (0xFFFF, none), magic byte, then
+// round, flags, playing, ready and hits. With the flags and the 128-bit
+// service UUID that is the whole 31 bytes of advertising data.
+static const uint16_t spectatorCompanyId = 0xFFFF;
+static const uint8_t spectatorMagic = 0xD8;
+static const size_t spectatorPayloadSize = 8;
+static const uint16_t spectatorIntervalUnits = 0xA0;  // 100 ms when advertising for spectators only
+static const uint32_t spectatorQuietUs = 3000000;     // shooter lost after this long unheard
+// Custom advertising data replaces what BLEAdvertising would build, scan
+// response included, so the shooter's name and the connection interval
+// range preferred by the game link (7.5-22.5 ms, in 1.25 ms units) go in a
+// scan response of their own: 17 + 6 bytes of the 31.
+static const char* shooterName = "M5Core2_Shooter";
+static const uint16_t preferredIntervalMin = 0x06;
+static const uint16_t preferredIntervalMax = 0x12;
+
+// --- Publishing (shooter, loop task) ---
+static bool broadcastStarted = false;
+static bool broadcastWithService = false;
+static bool advertisingConnectable = true;
+static uint8_t published[spectatorPayloadSize];
+
+static void encode(const SpectatorSnapshot& snap, uint8_t* p) {
+  p[0] = spectatorCompanyId & 0xFF;
+  p[1] = spectatorCompanyId >> 8;
+  p[2] = spectatorMagic;
+  p[3] = snap.round;
+  p[4] = snap.flags;
+  p[5] = snap.playing;
+  p[6] = snap.ready;
+  p[7] = snap.hits;
+}
+
+// Replaces the advertising data; it goes out from the next advertising
+// event, whether or not advertising is running. The service UUID is left
+// out while dodgers cannot connect, so they do not try.
+static void setAdvertisingData() {
+  // Allocates in the Arduino wrapper and in Bluedroid, as for the advert
+  // transport's publications; it only runs when the published state changes.
+  ALLOC_TRACE_PAUSE();
+  BLEAdvertisementData advData;
+  advData.setFlags(ESP_BLE_ADV_FLAG_GEN_DISC | ESP_BLE_ADV_FLAG_BREDR_NOT_SPT);
+  if (broadcastWithService && advertisingConnectable) advData.setCompleteServices(BLEUUID(SERVICE_UUID));
+  advData.setManufacturerData(std::string((const char*)published, spectatorPayloadSize));
+  BLEDevice::getAdvertising()->setAdvertisementData(advData);
+}
+
+// Slave Connection Interval Range (AD type 0x12); the active profile is
+// requested explicitly once connected.
+static void setScanResponseData() {
+  ALLOC_TRACE_PAUSE();
+  BLEAdvertisementData scanData;
+  scanData.setName(shooterName);
+  const char range[] = { 5, 0x12,
+                         (char)(preferredIntervalMin & 0xFF), (char)(preferredIntervalMin >> 8),
+                         (char)(preferredIntervalMax & 0xFF), (char)(preferredIntervalMax >> 8) };
+  scanData.addData(std::string(range, sizeof(range)));
+  BLEDevice::getAdvertising()->setScanResponseData(scanData);
+}
+
+void spectatorBroadcastBegin(bool withService) {
+  broadcastWithService = withService;
+  SpectatorSnapshot idle = { 1, 0, 0, 0, 0 };
+  encode(idle, published);
+  if (!withService) BLEDevice::init(shooterName);  // the game link does not use BLE
+  BLEAdvertising* advertising = BLEDevice::getAdvertising();
+  if (!withService) {
+    advertising->setAdvertisementType(ADV_TYPE_NONCONN_IND);
+    advertising->setMinInterval(spectatorIntervalUnits);
+    advertising->setMaxInterval(spectatorIntervalUnits);
+    advertisingConnectable = false;
+  }
+  setAdvertisingData();
+  if (withService) setScanResponseData();
+  if (!withService) advertising->start();
+  broadcastStarted = true;
+  LOG_I("Spectator: Broadcasting match state%s.", withService ? " with the game service" : "");
+}
+
+void spectatorPublish(const SpectatorSnapshot& snap) {
+  if (!broadcastStarted) return;
+  uint8_t payload[spectatorPayloadSize];
+  encode(snap, payload);
+  if (memcmp(payload, published, spectatorPayloadSize) == 0) return;
+  memcpy(published, payload, spectatorPayloadSize);
+  setAdvertisingData();
+}
+
+// Switching between connectable and not takes a restart.
+void spectatorAdvertise(bool connectable) {
+  ALLOC_TRACE_PAUSE();  // advertising stop and start go through Bluedroid
+  BLEAdvertising* advertising = BLEDevice::getAdvertising();
+  if (connectable != advertisingConnectable) {
+    advertising->stop();
+    advertising->setAdvertisementType(connectable ? ADV_TYPE_IND : ADV_TYPE_NONCONN_IND);
+    advertisingConnectable = connectable;
+    setAdvertisingData();
+    LOG_I("Spectator: Advertising %s.", connectable ? "connectable" : "for spectators only");
+  }
+  advertising->start();
+}
+
+// --- Listening (spectator, BLE task) ---
+static SpscRing<SpectatorSnapshot, 8> heardStates;
+static volatile bool following = false;
+static esp_bd_addr_t shooterAddress;
+static bool heardKnown = false;                 // heard is set
+static uint8_t heard[spectatorPayloadSize];     // last state passed on
+static volatile uint32_t heardUs = 0;
+
+class SpectatorScanCallbacks : public BLEAdvertisedDeviceCallbacks {
+  void onResult(BLEAdvertisedDevice device) {
+    if (!device.haveManufacturerData()) return;
+    std::string m = device.getManufacturerData();
+    const uint8_t* p = (const uint8_t*)m.data();
+    if (m.size() < spectatorPayloadSize || p[0] != (spectatorCompanyId & 0xFF) ||
+        p[1] != (spectatorCompanyId >> 8) || p[2] != spectatorMagic) {
+      return;
+    }
+    if (!following) {
+      memcpy(shooterAddress, *device.getAddress().getNative(), sizeof(esp_bd_addr_t));
+      following = true;
+      heardKnown = false;
+      const uint8_t* a = shooterAddress;
+      LOG_I("Spectator: Following shooter %02x:%02x:%02x:%02x:%02x:%02x.", a[0], a[1], a[2], a[3], a[4], a[5]);
+    } else if (memcmp(*device.getAddress().getNative(), shooterAddress, sizeof(esp_bd_addr_t)) != 0) {
+      return;
+    }
+    heardUs = micros();
+    if (heardKnown && memcmp(heard, p, spectatorPayloadSize) == 0) return;  // a repeat
+    memcpy(heard, p, spectatorPayloadSize);
+    heardKnown = true;
+    SpectatorSnapshot snap = { p[3], p[4], p[5], p[6], p[7] };
+    heardStates.push(snap);
+    postEvent(EVT_BLE_RX);
+  }
+};
+
+void spectatorListen() {
+  BLEDevice::init("");
+  static SpectatorScanCallbacks scanCallbacks;
+  BLEScan* scan = BLEDevice::getScan();
+  scan->setAdvertisedDeviceCallbacks(&scanCallbacks, true);
+  scan->setActiveScan(false);
+  scan->setInterval(100);
+  scan->setWindow(100);  // listen all the time
+  scan->start(0, nullptr, false);
+  LOG_I("Spectator: Scanning for a shooter.");
+}
+
+bool spectatorReceive(SpectatorSnapshot* snap) {
+  return heardStates.pop(snap);
+}
+
+bool spectatorShooterLost(uint32_t nowUs) {
+  if (!following || (int32_t)(nowUs - heardUs) <= (int32_t)spectatorQuietUs) return false;
+  following = false;
+  return true;
+}
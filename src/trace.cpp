@@ -0,0 +1,118 @@
+#include "trace.h"
+
+#if TRACE
+#include <Arduino.h>
+#include <atomic>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+
+static_assert(sizeof(TraceEvent) == 12, "TraceEvent layout is read by tools/trace2json.py");
+static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0, "TRACE_EVENTS must be a power of two");
+
+static TraceEvent* events = nullptr;
+static uint32_t capacity = 0;                 // power of two
+static std::atomic<uint32_t> writeIndex{0};
+static std::atomic<bool> recording{false};
+
+static const char* names[TRACE_NAMES];
+static uint16_t nameCount = 0;
+static portMUX_TYPE nameLock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* const trackNames[TRACE_TRACK_COUNT] = { "loop", "ble", "state", "link" };
+
+void traceInit() {
+  capacity = TRACE_EVENTS;
+  events = (TraceEvent*)heap_caps_malloc(capacity * sizeof(TraceEvent), MALLOC_CAP_SPIRAM);
+  if (events == nullptr) {
+    capacity = TRACE_EVENTS / 8;  // no PSRAM: a short internal-RAM window
+    events = (TraceEvent*)heap_caps_malloc(capacity * sizeof(TraceEvent), MALLOC_CAP_8BIT);
+  }
+  recording = events != nullptr;
+}
+
+uint16_t traceNameId(const char* name) {
+  uint16_t id = TRACE_NAMES;
+  portENTER_CRITICAL(&nameLock);
+  for (uint16_t i = 0; i < nameCount; i++) {
+    if (names[i] == name || strcmp(names[i], name) == 0) {
+      id = i;
+      break;
+    }
+  }
+  if (id == TRACE_NAMES && nameCount < TRACE_NAMES) {
+    id = nameCount;
+    names[nameCount++] = name;
+  }
+  portEXIT_CRITICAL(&nameLock);
+  return id;  // TRACE_NAMES when the table is full; the converter shows "?"
+}
+
+void traceEvent(uint8_t type, uint8_t track, uint16_t name, int32_t arg) {
+  if (!recording.load(std::memory_order_relaxed)) return;
+  uint32_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+  TraceEvent& e = events[index & (capacity - 1)];
+  e.us = micros();
+  e.type = type;
+  e.track = track;
+  e.name = name;
+  e.arg = arg;
+}
+
+void traceClear() {
+  writeIndex = 0;
+}
+
+// --- Dump ---
+static const char base64Chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void printBase64(const uint8_t* data, size_t len) {
+  char out[4 * ((4 * sizeof(TraceEvent) + 2) / 3) + 1];
+  size_t n = 0;
+  for (size_t i = 0; i < len; i += 3) {
+    uint32_t v = (uint32_t)data[i] << 16;
+    if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+    if (i + 2 < len) v |= data[i + 2];
+    out[n++] = base64Chars[(v >> 18) & 0x3F];
+    out[n++] = base64Chars[(v >> 12) & 0x3F];
+    out[n++] = i + 1 < len ? base64Chars[(v >> 6) & 0x3F] : '=';
+    out[n++] = i + 2 < len ? base64Chars[v & 0x3F] : '=';
+  }
+  out[n] = '\0';
+  Serial.printf("#TRACE data %s\n", out);
+}
+
+void traceDump() {
+  if (events == nullptr) {
+    Serial.println("trace: no buffer.");
+    return;
+  }
+  recording = false;
+  delay(2);  // let a callback that already claimed a slot finish writing it
+  uint32_t total = writeIndex.load();
+  uint32_t count = total < capacity ? total : capacity;
+  uint32_t first = total - count;
+
+  Serial.printf("#TRACE begin 1 %lu %lu\n", (unsigned long)count, (unsigned long)(total - count));
+  for (int t = 0; t < TRACE_TRACK_COUNT; t++) {
+    Serial.printf("#TRACE track %d %s\n", t, trackNames[t]);
+  }
+  for (uint16_t i = 0; i < nameCount; i++) {
+    Serial.printf("#TRACE name %u %s\n", i, names[i]);
+  }
+  TraceEvent chunk[4];
+  uint32_t inChunk = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    chunk[inChunk++] = events[(first + i) & (capacity - 1)];
+    if (inChunk == 4 || i + 1 == count) {
+      printBase64((const uint8_t*)chunk, inChunk * sizeof(TraceEvent));
+      inChunk = 0;
+    }
+  }
+  Serial.println("#TRACE end");
+
+  traceClear();
+  recording = true;
+}
+#endif
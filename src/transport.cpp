@@ -0,0 +1,136 @@
+#include <Arduino.h>
+#include <string.h>
+#include "transport.h"
+#include "bench_stats.h"
+#include "game_log.h"
+
+static const TransportBackend* backend = nullptr;
+static TransportRxHandler rxHandler = nullptr;
+static TransportLinkHandler linkHandler = nullptr;
+
+// --- Link Conditioner State ---
+// Delayed frames wait in a ring in send order; due times never decrease,
+// so the head is always the next one to go.
+struct DelayedFrame {
+  uint32_t dueUs;
+  TransportPeer peer;
+  uint8_t channel;
+  uint8_t len;
+  uint8_t data[BENCH_PAYLOAD_SIZE];
+};
+
+static LinkConditions conditions = linkProfiles[LINK_IDEAL];
+static TransportStats linkStats = { 0, 0, 0, 0 };
+static DelayedFrame delayQueue[TRANSPORT_QUEUE_SLOTS];
+static uint8_t delayHead = 0;
+static uint8_t delayCount = 0;
+static uint32_t lastDueUs = 0;
+static uint32_t conditionRng = 0x9E3779B9;  // fixed seed: runs repeat exactly
+
+static uint32_t nextConditionRandom() {
+  conditionRng ^= conditionRng << 13;
+  conditionRng ^= conditionRng >> 17;
+  conditionRng ^= conditionRng << 5;
+  return conditionRng;
+}
+
+void transportInit(const TransportBackend* b, TransportRxHandler rx, TransportLinkHandler link) {
+  backend = b;
+  rxHandler = rx;
+  linkHandler = link;
+  LOG_I("Link: %s transport.", b->name);
+}
+
+const TransportBackend* transportBackend() {
+  return backend;
+}
+
+void transportBegin(bool host) {
+  if (backend != nullptr && backend->begin != nullptr) backend->begin(host);
+}
+
+bool transportSend(TransportChannel channel, const uint8_t* data, size_t len) {
+  return transportSendTo(channel, TRANSPORT_PEER_ALL, data, len);
+}
+
+bool transportSendTo(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len) {
+  if (backend == nullptr) return false;
+  if (conditions.latencyUs == 0 && conditions.jitterUs == 0 && conditions.lossPermille == 0 &&
+      delayCount == 0) {
+    bool ok = backend->send(channel, peer, data, len);
+    if (ok) linkStats.sent++;
+    return ok;
+  }
+  if (conditions.lossPermille > 0 && nextConditionRandom() % 1000 < conditions.lossPermille) {
+    linkStats.lost++;
+    return true;
+  }
+  uint32_t nowUs = micros();
+  uint32_t dueUs = nowUs + conditions.latencyUs;
+  if (conditions.jitterUs > 0) dueUs += nextConditionRandom() % (conditions.jitterUs + 1);
+  if (delayCount > 0 && (int32_t)(dueUs - lastDueUs) < 0) dueUs = lastDueUs;  // stay in order
+  if (delayCount == 0 && (int32_t)(dueUs - nowUs) <= 0) {
+    bool ok = backend->send(channel, peer, data, len);
+    if (ok) linkStats.sent++;
+    return ok;
+  }
+  if (delayCount == TRANSPORT_QUEUE_SLOTS || len > BENCH_PAYLOAD_SIZE) {
+    linkStats.overflow++;
+    return true;
+  }
+  DelayedFrame& slot = delayQueue[(delayHead + delayCount) % TRANSPORT_QUEUE_SLOTS];
+  slot.dueUs = dueUs;
+  slot.peer = peer;
+  slot.channel = (uint8_t)channel;
+  slot.len = (uint8_t)len;
+  memcpy(slot.data, data, len);
+  delayCount++;
+  if (delayCount > linkStats.maxQueued) linkStats.maxQueued = delayCount;
+  lastDueUs = dueUs;
+  return true;
+}
+
+uint32_t transportPoll(uint32_t nowUs) {
+  if (backend == nullptr) return UINT32_MAX;
+  uint32_t wait = backend->poll != nullptr ? backend->poll(nowUs) : UINT32_MAX;
+  while (delayCount > 0) {
+    DelayedFrame& head = delayQueue[delayHead];
+    int32_t due = (int32_t)(head.dueUs - nowUs);
+    if (due > 0) return (uint32_t)due < wait ? (uint32_t)due : wait;
+    // A frame for a link that has gone is lost with it.
+    if (backend->send((TransportChannel)head.channel, head.peer, head.data, head.len)) linkStats.sent++;
+    delayHead = (delayHead + 1) % TRANSPORT_QUEUE_SLOTS;
+    delayCount--;
+  }
+  return wait;
+}
+
+void transportReceive(TransportChannel channel, const uint8_t* data, size_t len) {
+  transportReceiveFrom(channel, 0, data, len);
+}
+
+void transportReceiveFrom(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len) {
+  if (rxHandler != nullptr && channel < CHANNEL_COUNT) rxHandler(channel, peer, data, len);
+}
+
+void transportLinkChanged(bool up) {
+  if (linkHandler != nullptr) linkHandler(up);
+}
+
+// --- Link Conditions ---
+void transportSetConditions(const LinkConditions& wanted) {
+  conditions = wanted;
+  linkStats.lost = 0;
+  linkStats.overflow = 0;
+  linkStats.maxQueued = delayCount;
+  LOG_I("Link: conditions %s: latency %u us, jitter %u us, loss %u/1000.", wanted.name,
+        wanted.latencyUs, wanted.jitterUs, wanted.lossPermille);
+}
+
+const LinkConditions& transportConditions() {
+  return conditions;
+}
+
+const TransportStats& transportStats() {
+  return linkStats;
+}
@@ -0,0 +1,189 @@
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEAdvertisedDevice.h>
+#include <BLEScan.h>
+#include <string.h>
+#include <string>
+#include "transport_adv.h"
+#include "alloc_trace.h"
+#include "game_log.h"
+
+// Manufacturer data layout: company ID (0xFFFF, none), magic byte, kind,
+// publication sequence number (little-endian), then the frame. The kind
+// has advKindShooter set when the shooter sends; its low bits are the
+// frame's channel, or advKindHello for a publication with no frame.
+static const uint16_t advCompanyId = 0xFFFF;
+static const uint8_t advMagic = 0xD7;
+static const uint8_t advKindShooter = 0x80;
+static const uint8_t advKindHello = 0x7F;
+static const size_t advHeaderSize = 6;
+// 31 bytes of advertising data, less the flags and the manufacturer data
+// structure's own length and type bytes.
+static const size_t advMaxFrame = ESP_BLE_ADV_DATA_LEN_MAX - 3 - 2 - advHeaderSize;
+static const uint16_t advIntervalUnits = 0x20;      // 20 ms advertising interval, in 0.625 ms units
+static const uint32_t advHoldUs = 60000;            // on the air before a queued frame replaces it
+static const uint32_t advPeerQuietUs = 2000000;     // peer lost after this long unheard
+static const int16_t advStaleWindow = 64;           // further behind means the peer restarted
+
+struct AdvFrame {
+  uint8_t kind;
+  uint8_t len;
+  uint8_t data[advMaxFrame];
+};
+
+static bool advStarted = false;
+static bool advHost = false;
+static uint16_t advSeq = 0;                     // of the publication on the air
+static uint32_t advOnAirUs = 0;                 // when it went on the air
+static AdvFrame advQueue[ADV_QUEUE_SLOTS];
+static uint8_t advQueueHead = 0;
+static uint8_t advQueueCount = 0;
+static AdvTransportStats advStats;
+
+// Written by the BLE task.
+static volatile bool advPaired = false;
+static esp_bd_addr_t advPeerAddress;
+static bool advPeerKnown = false;               // advPeerAddress and advPeerSeq are set
+static uint16_t advPeerSeq = 0;                 // last publication passed on
+static volatile uint32_t advHeardUs = 0;
+
+// --- Publishing (loop task) ---
+static void publish(uint8_t kind, const uint8_t* data, size_t len) {
+  uint8_t payload[advHeaderSize + advMaxFrame];
+  advSeq++;
+  payload[0] = advCompanyId & 0xFF;
+  payload[1] = advCompanyId >> 8;
+  payload[2] = advMagic;
+  payload[3] = kind | (advHost ? advKindShooter : 0);
+  payload[4] = advSeq & 0xFF;
+  payload[5] = advSeq >> 8;
+  memcpy(payload + advHeaderSize, data, len);
+  // The Arduino wrapper holds advertising data in std::string, and Bluedroid
+  // copies whatever it is given into a heap message for its own task, so a
+  // publication allocates however it is built. It runs once per frame sent,
+  // not once per pass.
+  ALLOC_TRACE_PAUSE();
+  BLEAdvertisementData advData;
+  advData.setFlags(ESP_BLE_ADV_FLAG_GEN_DISC | ESP_BLE_ADV_FLAG_BREDR_NOT_SPT);
+  advData.setManufacturerData(std::string((const char*)payload, advHeaderSize + len));
+  BLEDevice::getAdvertising()->setAdvertisementData(advData);
+  advOnAirUs = micros();
+  advStats.published++;
+}
+
+static void publishNext() {
+  const AdvFrame& f = advQueue[advQueueHead];
+  publish(f.kind, f.data, f.len);
+  advQueueHead = (advQueueHead + 1) % ADV_QUEUE_SLOTS;
+  advQueueCount--;
+}
+
+// --- Scanning (BLE task) ---
+static bool samePeer(BLEAdvertisedDevice& device) {
+  return memcmp(*device.getAddress().getNative(), advPeerAddress, sizeof(esp_bd_addr_t)) == 0;
+}
+
+class AdvTransportScanCallbacks : public BLEAdvertisedDeviceCallbacks {
+  void onResult(BLEAdvertisedDevice device) {
+    if (!device.haveManufacturerData()) return;
+    std::string m = device.getManufacturerData();
+    const uint8_t* p = (const uint8_t*)m.data();
+    if (m.size() < advHeaderSize || p[0] != (advCompanyId & 0xFF) || p[1] != (advCompanyId >> 8) ||
+        p[2] != advMagic) {
+      return;
+    }
+    // Only the other role pairs: shooters ignore shooters.
+    if (((p[3] & advKindShooter) != 0) == advHost) return;
+    uint16_t seq = (uint16_t)(p[4] | (p[5] << 8));
+    if (!advPaired) {
+      // Even the same peer, heard again after going quiet, may have restarted
+      // its sequence; at worst its publication on the air is passed on twice.
+      advPeerKnown = false;
+      memcpy(advPeerAddress, *device.getAddress().getNative(), sizeof(esp_bd_addr_t));
+      advPaired = true;
+      const uint8_t* a = advPeerAddress;
+      LOG_I("Advertising: Peer %02x:%02x:%02x:%02x:%02x:%02x heard.", a[0], a[1], a[2], a[3], a[4], a[5]);
+      transportLinkChanged(true);
+    } else if (!samePeer(device)) {
+      return;
+    }
+    advHeardUs = micros();
+    if (advPeerKnown) {
+      int16_t age = (int16_t)(advPeerSeq - seq);
+      if (age == 0) {
+        advStats.duplicates++;
+        return;
+      }
+      if (age > 0 && age <= advStaleWindow) {
+        advStats.stale++;
+        return;
+      }
+    }
+    advPeerKnown = true;
+    advPeerSeq = seq;
+    uint8_t kind = p[3] & ~advKindShooter;
+    if (kind >= CHANNEL_COUNT) return;  // hello
+    advStats.accepted++;
+    transportReceive((TransportChannel)kind, p + advHeaderSize, m.size() - advHeaderSize);
+  }
+};
+
+// --- Backend ---
+static void advBegin(bool host) {
+  advHost = host;
+  if (advStarted) return;  // advertising and scanning carry on after a lost peer
+  BLEDevice::init(host ? "M5Core2_Shooter" : "");
+  BLEAdvertising* advertising = BLEDevice::getAdvertising();
+  advertising->setAdvertisementType(ADV_TYPE_NONCONN_IND);
+  advertising->setMinInterval(advIntervalUnits);
+  advertising->setMaxInterval(advIntervalUnits);
+  publish(advKindHello, nullptr, 0);
+  advertising->start();
+  static AdvTransportScanCallbacks scanCallbacks;
+  BLEScan* scan = BLEDevice::getScan();
+  scan->setAdvertisedDeviceCallbacks(&scanCallbacks, true);
+  scan->setActiveScan(false);
+  scan->setInterval(100);
+  scan->setWindow(100);  // listen all the time
+  scan->start(0, nullptr, false);
+  advStarted = true;
+  LOG_I("Advertising: Publishing and scanning as %s.", host ? "shooter" : "dodger");
+}
+
+static bool advSend(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len) {
+  if (!advPaired || len > advMaxFrame) return false;
+  if (advQueueCount == ADV_QUEUE_SLOTS) {
+    LOG_W("Advertising: Publish queue full, frame dropped.");
+    return false;
+  }
+  AdvFrame& f = advQueue[(advQueueHead + advQueueCount) % ADV_QUEUE_SLOTS];
+  f.kind = (uint8_t)channel;
+  f.len = (uint8_t)len;
+  memcpy(f.data, data, len);
+  advQueueCount++;
+  if (advQueueCount == 1 && micros() - advOnAirUs >= advHoldUs) publishNext();
+  return true;
+}
+
+// Moves the next queued frame on the air once the current one has had its
+// time, and reports a peer that has gone quiet.
+static uint32_t advPoll(uint32_t nowUs) {
+  if (!advStarted) return UINT32_MAX;
+  if (advPaired && (int32_t)(nowUs - advHeardUs) > (int32_t)advPeerQuietUs) {
+    advPaired = false;
+    LOG_I("Advertising: Peer went quiet (%u duplicates, %u stale dropped).",
+          (unsigned)advStats.duplicates, (unsigned)advStats.stale);
+    transportLinkChanged(false);
+  }
+  if (advQueueCount == 0) return UINT32_MAX;
+  uint32_t onAir = nowUs - advOnAirUs;
+  if (onAir < advHoldUs) return advHoldUs - onAir;
+  publishNext();
+  return advQueueCount > 0 ? advHoldUs : UINT32_MAX;
+}
+
+const AdvTransportStats& advTransportStats() {
+  return advStats;
+}
+
+const TransportBackend advTransport = { "BLE adverts", advBegin, advSend, advPoll };
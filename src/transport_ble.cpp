@@ -0,0 +1,94 @@
+#include "transport_ble.h"
+#include "alloc_trace.h"
+#include "profiler.h"
+#include "trace.h"
+
+// Shooter side: the local characteristics, the GATT interface they are
+// served on, and whether a central is there.
+static BLECharacteristic* servedCharacteristics[CHANNEL_COUNT] = { nullptr, nullptr };
+static esp_gatt_if_t servedGattsIf = 0;
+static volatile bool serverLinked = false;
+
+// Dodger side: the shooter's characteristics, set while subscribed.
+static BLERemoteCharacteristic* volatile remoteCharacteristics[CHANNEL_COUNT] = { nullptr, nullptr };
+
+// --- Server Side ---
+class ServedCharacteristicCallbacks : public BLECharacteristicCallbacks {
+public:
+  explicit ServedCharacteristicCallbacks(TransportChannel channel) : channel(channel) {}
+  // The connection ID tells the dodgers apart.
+  void onWrite(BLECharacteristic* pCharacteristic, esp_ble_gatts_cb_param_t* param) {
+    PROFILE_SCOPE("ble.onWrite");
+    TRACE_SCOPE(TRACE_TRACK_BLE, "ble.onWrite");
+    transportReceiveFrom(channel, param->write.conn_id, pCharacteristic->getData(), pCharacteristic->getLength());
+  }
+
+private:
+  TransportChannel channel;
+};
+
+void bleTransportServe(BLECharacteristic* game, BLECharacteristic* bench) {
+  static ServedCharacteristicCallbacks gameCallbacks(CHANNEL_GAME);
+  static ServedCharacteristicCallbacks benchCallbacks(CHANNEL_BENCH);
+  servedCharacteristics[CHANNEL_GAME] = game;
+  servedCharacteristics[CHANNEL_BENCH] = bench;
+  servedGattsIf = game->getService()->getServer()->getGattsIf();
+  game->setCallbacks(&gameCallbacks);
+  if (bench != nullptr) bench->setCallbacks(&benchCallbacks);
+}
+
+void bleTransportSetServerLinked(bool linked) {
+  serverLinked = linked;
+}
+
+// --- Client Side ---
+static void gameNotifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
+                               uint8_t* pData, size_t length, bool isNotify) {
+  PROFILE_SCOPE("ble.notify");
+  TRACE_SCOPE(TRACE_TRACK_BLE, "ble.onNotify");
+  transportReceive(CHANNEL_GAME, pData, length);
+}
+
+static void benchNotifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic,
+                                uint8_t* pData, size_t length, bool isNotify) {
+  transportReceive(CHANNEL_BENCH, pData, length);
+}
+
+void bleTransportAttach(BLERemoteCharacteristic* game, BLERemoteCharacteristic* bench) {
+  game->registerForNotify(gameNotifyCallback);
+  remoteCharacteristics[CHANNEL_GAME] = game;
+  if (bench != nullptr) {
+    bench->registerForNotify(benchNotifyCallback);
+    remoteCharacteristics[CHANNEL_BENCH] = bench;
+  }
+}
+
+void bleTransportDetach() {
+  remoteCharacteristics[CHANNEL_GAME] = nullptr;
+  remoteCharacteristics[CHANNEL_BENCH] = nullptr;
+}
+
+// --- Backend ---
+// Notify on the shooter, to every subscribed central or to one connection,
+// and write on the dodger: with response for game frames, without for
+// benchmark frames.
+static bool bleSend(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len) {
+  ALLOC_TRACE_PAUSE();  // Bluedroid allocates a message for its task on every notify and write
+  BLECharacteristic* served = servedCharacteristics[channel];
+  if (served != nullptr) {
+    if (!serverLinked) return false;
+    if (peer != TRANSPORT_PEER_ALL) {
+      return esp_ble_gatts_send_indicate(servedGattsIf, peer, served->getHandle(), len,
+                                         const_cast<uint8_t*>(data), false) == ESP_OK;
+    }
+    served->setValue(const_cast<uint8_t*>(data), len);
+    served->notify();
+    return true;
+  }
+  BLERemoteCharacteristic* remote = remoteCharacteristics[channel];
+  if (remote == nullptr) return false;
+  remote->writeValue(const_cast<uint8_t*>(data), len, channel == CHANNEL_GAME);
+  return true;
+}
+
+const TransportBackend bleTransport = { "BLE GATT", nullptr, bleSend, nullptr };
@@ -0,0 +1,190 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <string.h>
+#include <atomic>
+#include "transport_espnow.h"
+#include "alloc_trace.h"
+#include "game_events.h"
+#include "game_log.h"
+
+// Packet layout: magic byte, kind, then the frame for kinds below
+// CHANNEL_COUNT (the kind is its channel) or, for a hello, one byte that is
+// 1 from the shooter and 0 from a dodger.
+static const uint8_t espNowMagic = 0xD6;
+static const uint8_t espNowKindHello = 0x80;
+static const uint32_t espNowBeaconIntervalUs = 100000;     // shooter, while unpaired
+static const uint32_t espNowHeartbeatIntervalUs = 500000;  // both ends, while paired
+static const uint32_t espNowPeerQuietUs = 2000000;         // unpair after this long unheard
+
+static const uint8_t espNowBroadcastMac[ESP_NOW_ETH_ALEN] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+static bool espNowStarted = false;
+static bool espNowHost = false;
+static volatile bool espNowPaired = false;      // written by the Wi-Fi task
+static uint8_t espNowPeerMac[ESP_NOW_ETH_ALEN];
+static volatile uint32_t espNowHeardUs = 0;     // last packet from the peer
+static uint32_t espNowHelloDueUs = 0;
+
+// Delivery reports: the Wi-Fi task calls back once per accepted packet, in
+// send order, so counting both sides identifies the packet each is about.
+// The report can come before esp_now_send returns, so a packet's index is
+// taken, and published for a game frame, before it is handed over.
+static uint32_t espNowSendsQueued = 0;                     // loop task
+static std::atomic<uint32_t> espNowSendsReported{0};       // Wi-Fi task
+static std::atomic<uint32_t> espNowSendsFailed{0};         // Wi-Fi task
+static std::atomic<uint32_t> espNowResendIndex{0};         // espNowSendsQueued of the kept game frame, 0 if none
+static std::atomic<bool> espNowResendWanted{false};        // the kept game frame was not acknowledged
+static uint8_t espNowResendFrame[ESP_NOW_MAX_DATA_LEN - 2];
+static size_t espNowResendLen = 0;
+static uint8_t espNowResendTries = 0;
+static EspNowTransportStats espNowStats;
+
+static bool addPeer(const uint8_t* mac) {
+  if (esp_now_is_peer_exist(mac)) return true;
+  esp_now_peer_info_t peer;
+  memset(&peer, 0, sizeof(peer));
+  memcpy(peer.peer_addr, mac, ESP_NOW_ETH_ALEN);
+  peer.channel = ESPNOW_WIFI_CHANNEL;
+  peer.ifidx = WIFI_IF_STA;
+  peer.encrypt = false;
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+static bool sendPacket(const uint8_t* mac, uint8_t kind, const uint8_t* data, size_t len) {
+  uint8_t packet[ESP_NOW_MAX_DATA_LEN];
+  if (len > sizeof(packet) - 2) return false;
+  packet[0] = espNowMagic;
+  packet[1] = kind;
+  memcpy(packet + 2, data, len);
+  uint32_t index = espNowSendsQueued + 1;
+  uint32_t keptIndex = espNowResendIndex.load();
+  espNowSendsQueued = index;
+  if (kind == CHANNEL_GAME) {
+    // A newer game frame supersedes the kept one.
+    espNowResendIndex.store(index);
+    espNowResendWanted.store(false);
+  }
+  ALLOC_TRACE_PAUSE();  // the Wi-Fi driver copies the packet into a heap buffer
+  if (esp_now_send(mac, packet, len + 2) != ESP_OK) {
+    // Not accepted, so never reported: the index goes back.
+    espNowSendsQueued = index - 1;
+    if (kind == CHANNEL_GAME) espNowResendIndex.store(keptIndex);
+    return false;
+  }
+  return true;
+}
+
+// --- Pairing (Wi-Fi task) ---
+static void pairWith(const uint8_t* mac) {
+  if (!addPeer(mac)) {
+    LOG_E("ESP-NOW Error: Could not add peer.");
+    return;
+  }
+  memcpy(espNowPeerMac, mac, ESP_NOW_ETH_ALEN);
+  espNowHeardUs = micros();
+  espNowHelloDueUs = espNowHeardUs;  // answer at once so the shooter pairs too
+  espNowPaired = true;
+  LOG_I("ESP-NOW: Paired with %02x:%02x:%02x:%02x:%02x:%02x.",
+        mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  transportLinkChanged(true);
+}
+
+static void onEspNowReceive(const uint8_t* mac, const uint8_t* data, int len) {
+  if (len < 2 || data[0] != espNowMagic) return;
+  if (data[1] == espNowKindHello) {
+    // Only the other role pairs: shooters ignore shooters' beacons.
+    if (len < 3 || (data[2] != 0) == espNowHost) return;
+    if (!espNowPaired) pairWith(mac);
+  }
+  if (!espNowPaired || memcmp(mac, espNowPeerMac, ESP_NOW_ETH_ALEN) != 0) return;
+  espNowHeardUs = micros();
+  if (data[1] < CHANNEL_COUNT) transportReceive((TransportChannel)data[1], data + 2, len - 2);
+}
+
+static void onEspNowSent(const uint8_t* mac, esp_now_send_status_t status) {
+  uint32_t index = espNowSendsReported.load() + 1;
+  espNowSendsReported.store(index);
+  if (status == ESP_NOW_SEND_SUCCESS) return;
+  espNowSendsFailed.fetch_add(1);
+  if (index == espNowResendIndex.load()) {
+    espNowResendWanted.store(true);
+    postEvent(EVT_BLE_RX);  // the loop resends from its transport poll
+  }
+}
+
+// --- Backend ---
+static void espNowBegin(bool host) {
+  espNowHost = host;
+  espNowHelloDueUs = micros();
+  if (espNowStarted) return;  // starting again after a lost peer
+  WiFi.mode(WIFI_STA);
+  esp_wifi_set_channel(ESPNOW_WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE);
+  if (esp_now_init() != ESP_OK) {
+    LOG_E("ESP-NOW Error: Init failed.");
+    return;
+  }
+  esp_now_register_recv_cb(onEspNowReceive);
+  esp_now_register_send_cb(onEspNowSent);
+  addPeer(espNowBroadcastMac);
+  espNowStarted = true;
+  uint8_t mac[ESP_NOW_ETH_ALEN];
+  esp_wifi_get_mac(WIFI_IF_STA, mac);
+  LOG_I("ESP-NOW: Started on channel %d as %02x:%02x:%02x:%02x:%02x:%02x, %s.", ESPNOW_WIFI_CHANNEL,
+        mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], host ? "beaconing" : "listening");
+}
+
+static bool espNowSend(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len) {
+  if (!espNowPaired) return false;
+  if (!sendPacket(espNowPeerMac, (uint8_t)channel, data, len)) return false;
+  if (channel == CHANNEL_GAME) {
+    // Kept until acknowledged. A failed report is acted on in the next
+    // poll, on this task, so the copy is in place by then.
+    memcpy(espNowResendFrame, data, len);
+    espNowResendLen = len;
+    espNowResendTries = 0;
+  }
+  return true;
+}
+
+// Sends the kept game frame again after a failed delivery report.
+static void resendGameFrame() {
+  espNowResendWanted.store(false);
+  if (!espNowPaired) return;
+  if (espNowResendTries == ESPNOW_GAME_RESENDS) {
+    espNowStats.abandoned++;
+    LOG_W("ESP-NOW: Game frame not acknowledged after %d resends.", ESPNOW_GAME_RESENDS);
+    return;
+  }
+  espNowResendTries++;
+  if (sendPacket(espNowPeerMac, CHANNEL_GAME, espNowResendFrame, espNowResendLen)) espNowStats.resent++;
+}
+
+// Beacons while the shooter is unpaired, heartbeats while paired, and the
+// quiet-peer check.
+static uint32_t espNowPoll(uint32_t nowUs) {
+  if (!espNowStarted) return UINT32_MAX;
+  if (espNowPaired && (int32_t)(nowUs - espNowHeardUs) > (int32_t)espNowPeerQuietUs) {
+    espNowPaired = false;
+    ALLOC_TRACE_PAUSE();
+    esp_now_del_peer(espNowPeerMac);
+    LOG_I("ESP-NOW: Peer went quiet, unpaired.");
+    transportLinkChanged(false);
+  }
+  if (espNowResendWanted.load()) resendGameFrame();
+  if (!espNowPaired && !espNowHost) return UINT32_MAX;  // a dodger waits for a beacon
+  if ((int32_t)(nowUs - espNowHelloDueUs) >= 0) {
+    uint8_t fromShooter = espNowHost ? 1 : 0;
+    sendPacket(espNowPaired ? espNowPeerMac : espNowBroadcastMac, espNowKindHello, &fromShooter, 1);
+    espNowHelloDueUs = nowUs + (espNowPaired ? espNowHeartbeatIntervalUs : espNowBeaconIntervalUs);
+  }
+  return espNowHelloDueUs - nowUs;
+}
+
+const EspNowTransportStats& espNowTransportStats() {
+  espNowStats.failed = espNowSendsFailed.load();
+  return espNowStats;
+}
+
+const TransportBackend espNowTransport = { "ESP-NOW", espNowBegin, espNowSend, espNowPoll };
@@ -0,0 +1,23 @@
+#include "transport_host.h"
+
+#if TRANSPORT_HOST
+#include <sim_link.h>
+
+static void onHostLinkFrame(uint8_t channel, const uint8_t* data, size_t len) {
+  transportReceive((TransportChannel)channel, data, len);
+}
+
+static void hostBegin(bool host) {
+  simLinkOpen(host, onHostLinkFrame, transportLinkChanged);
+}
+
+static bool hostSend(TransportChannel channel, TransportPeer peer, const uint8_t* data, size_t len) {
+  return simLinkSend((uint8_t)channel, data, len);
+}
+
+const TransportBackend hostTransport = { "simulator link", hostBegin, hostSend, nullptr };
+
+bool hostTransportConfigured() {
+  return simLinkKind() != SIM_LINK_NONE;
+}
+#endif
@@ -0,0 +1,180 @@
+// Allocation tracing over the shooter's per-round path:
+// pio test -e native -f test_alloc_trace
+//
+// On the device the linker wraps malloc (see the alloc-trace environment).
+// Here the global operator new goes through the same counting hook, which
+// covers every C++ container the game code could grow; the round below
+// fails the test if any of it allocates.
+#define ALLOC_TRACE 1
+#include <unity.h>
+
+#include <new>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "../../src/alloc_trace.cpp"
+#include "../../src/deadline_timer.cpp"
+#include "../../src/dodger_sessions.cpp"
+#include "../../src/game_protocol.cpp"
+#include "spsc_ring.h"
+
+extern "C" {
+void* __real_malloc(size_t size) { return malloc(size); }
+void* __real_calloc(size_t count, size_t size) { return calloc(count, size); }
+void* __real_realloc(void* ptr, size_t size) { return realloc(ptr, size); }
+}
+
+void* operator new(size_t size) {
+  void* p = __wrap_malloc(size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+// Out of line so the compiler does not pair free() with operator new.
+__attribute__((noinline)) static void releaseBlock(void* p) { free(p); }
+void operator delete(void* p) noexcept { releaseBlock(p); }
+void operator delete[](void* p) noexcept { releaseBlock(p); }
+void operator delete(void* p, size_t) noexcept { releaseBlock(p); }
+void operator delete[](void* p, size_t) noexcept { releaseBlock(p); }
+
+void setUp(void) {
+  memset(&sessions, 0, sizeof(sessions));
+}
+
+void tearDown(void) {}
+
+static volatile uintptr_t allocSink;
+
+// --- The tracer itself ---
+
+static void test_counts_allocation_while_tracing(void) {
+  AllocTraceReport report;
+  allocTraceBegin();
+  std::vector<uint8_t> grown(100);
+  allocSink = (uintptr_t)grown.data();
+  TEST_ASSERT_FALSE(allocTraceEnd(&report));
+  TEST_ASSERT_EQUAL_UINT32(1, report.count);
+  TEST_ASSERT_EQUAL_UINT32(100, report.firstSize);
+  TEST_ASSERT_NOT_NULL(report.firstCaller);
+}
+
+static void test_ignores_allocation_outside_trace_and_paused(void) {
+  std::string before(64, 'x');
+  allocSink = (uintptr_t)before.data();
+  AllocTraceReport report;
+  allocTraceBegin();
+  {
+    ALLOC_TRACE_PAUSE();
+    std::string paused(64, 'y');
+    allocSink = (uintptr_t)paused.data();
+  }
+  TEST_ASSERT_TRUE(allocTraceEnd(&report));
+  TEST_ASSERT_EQUAL_UINT32(0, report.count);
+  std::string after(64, 'z');
+  allocSink = (uintptr_t)after.data();
+  TEST_ASSERT_FALSE(allocTraceActive());
+}
+
+// --- Shooter round ---
+// Everything the shooter's loop does between a dodger's choice arriving and
+// the next round starting, minus the radio: decode the choices, record
+// them, fire, encode the shot frames, queue them and run the result timer.
+
+static SpscRing<GameFrame, 16> rxFrames;
+
+static void playRound(uint8_t round, uint8_t shot, uint32_t nowMs) {
+  for (int i = 0; i < sessions.count; i++) {
+    GameFrame choice = {};
+    choice.opcode = OP_DODGER_CHOICE;
+    choice.round = round;
+    choice.choice = (uint8_t)(1 + (i + round) % NUM_BARRELS);
+    choice.peer = sessions.peer[i];
+    uint8_t wire[GAME_FRAME_SIZE];
+    gameFrameEncode(choice, wire, sizeof(wire));
+    GameFrameView view;
+    TEST_ASSERT_EQUAL_INT(FRAME_OK, gameFrameDecode(wire, sizeof(wire), &view));
+    GameFrame received = {};
+    received.opcode = view.opcode();
+    received.round = view.round();
+    received.choice = view.choice();
+    received.peer = choice.peer;
+    TEST_ASSERT_TRUE(rxFrames.push(received));
+  }
+  GameFrame msg;
+  while (rxFrames.pop(&msg)) {
+    int i = sessionFind(msg.peer);
+    TEST_ASSERT_TRUE(i >= 0);
+    sessionJoin(i);
+    sessionChoose(i, msg.round, msg.choice);
+  }
+  int playing;
+  int ready = sessionsReady(&playing);
+  TEST_ASSERT_EQUAL_INT(playing, ready);
+
+  int shotCount;
+  sessionsShoot(shot, &shotCount);
+  uint8_t frames[MAX_DODGERS][GAME_FRAME_SIZE];
+  for (int i = 0, k = 0; i < sessions.count; i++) {
+    if (sessions.state[i] != SESSION_SHOT) continue;
+    GameFrame frame = {};
+    frame.opcode = OP_SHOT;
+    frame.round = sessions.round[i];
+    frame.choice = shot;
+    gameFrameEncode(frame, frames[k], GAME_FRAME_SIZE);
+    gameFrameStampSend(frames[k++], nowMs * 1000, 0);
+  }
+  allocSink = frames[0][2];
+
+  timerStart(1, 1500, nowMs);
+  TEST_ASSERT_EQUAL_INT(-1, timerPopExpired(nowMs));
+  TEST_ASSERT_EQUAL_INT(1, timerPopExpired(nowMs + 1500));
+  if (sessionsAdvance()) sessionsRestart();
+}
+
+static void linkDodgers(int count) {
+  for (int d = 0; d < count; d++) {
+    uint8_t address[SESSION_ADDRESS_LEN] = { 0x24, 0x0A, 0xC4, 0, 0, (uint8_t)d };
+    TEST_ASSERT_EQUAL_INT(d, sessionLink(address, (TransportPeer)d));
+  }
+}
+
+static void test_shooter_rounds_do_not_allocate(void) {
+  linkDodgers(MAX_DODGERS);
+  AllocTraceReport report;
+  allocTraceBegin();
+  for (int match = 0; match < 20; match++) {
+    for (uint8_t round = 1; round <= MAX_ROUNDS; round++) {
+      playRound(round, (uint8_t)(1 + (match + round) % NUM_BARRELS), 1000u * round);
+    }
+  }
+  bool clean = allocTraceEnd(&report);
+  if (!clean) {
+    char line[96];
+    snprintf(line, sizeof(line), "%u allocations, %u bytes, first %u bytes",
+             (unsigned)report.count, (unsigned)report.bytes, (unsigned)report.firstSize);
+    TEST_MESSAGE(line);
+  }
+  TEST_ASSERT_TRUE_MESSAGE(clean, "the per-round path allocated");
+}
+
+// The same harness must catch an allocation slipped into the round.
+static void test_allocation_in_round_is_caught(void) {
+  linkDodgers(1);
+  AllocTraceReport report;
+  allocTraceBegin();
+  playRound(1, 2, 1000);
+  std::string label = "round " + std::to_string(sessions.round[0]) + " of a much longer match";
+  allocSink = (uintptr_t)label.data();
+  TEST_ASSERT_FALSE(allocTraceEnd(&report));
+  TEST_ASSERT_GREATER_THAN(0, report.count);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_counts_allocation_while_tracing);
+  RUN_TEST(test_ignores_allocation_outside_trace_and_paused);
+  RUN_TEST(test_shooter_rounds_do_not_allocate);
+  RUN_TEST(test_allocation_in_round_is_caught);
+  return UNITY_END();
+}
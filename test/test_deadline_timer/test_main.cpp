@@ -0,0 +1,147 @@
+// Deadline scheduler on a virtual clock: pio test -e native -f test_deadline_timer
+#include <unity.h>
+
+#include "../../src/deadline_timer.cpp"
+
+void setUp(void) {
+  for (uint8_t id = 0; id < TIMER_SLOTS; id++) timerCancel(id);
+}
+
+void tearDown(void) {}
+
+// --- Arming and expiry ---
+
+static void test_idle_scheduler_has_no_deadline(void) {
+  TEST_ASSERT_EQUAL_UINT32(TIMER_NONE, timerTimeUntilNext(0));
+  TEST_ASSERT_EQUAL_INT(-1, timerPopExpired(0));
+}
+
+static void test_timer_fires_exactly_at_deadline(void) {
+  timerStart(2, 1000, 500);
+  TEST_ASSERT_TRUE(timerActive(2));
+  TEST_ASSERT_EQUAL_UINT32(1000, timerTimeUntilNext(500));
+  TEST_ASSERT_EQUAL_UINT32(1, timerTimeUntilNext(1499));
+  TEST_ASSERT_EQUAL_INT(-1, timerPopExpired(1499));
+  TEST_ASSERT_EQUAL_INT(2, timerPopExpired(1500));
+  TEST_ASSERT_FALSE(timerActive(2));
+  TEST_ASSERT_EQUAL_INT(-1, timerPopExpired(1500));
+}
+
+static void test_overdue_timer_reports_zero_wait(void) {
+  timerStart(0, 10, 0);
+  TEST_ASSERT_EQUAL_UINT32(0, timerTimeUntilNext(50));
+  TEST_ASSERT_EQUAL_INT(0, timerPopExpired(50));
+}
+
+static void test_rearm_replaces_deadline(void) {
+  timerStart(1, 100, 0);
+  timerStart(1, 300, 50);
+  TEST_ASSERT_EQUAL_INT(-1, timerPopExpired(100));
+  TEST_ASSERT_EQUAL_UINT32(250, timerTimeUntilNext(100));
+  TEST_ASSERT_EQUAL_INT(1, timerPopExpired(350));
+}
+
+static void test_cancel_disarms(void) {
+  timerStart(3, 100, 0);
+  timerCancel(3);
+  TEST_ASSERT_FALSE(timerActive(3));
+  TEST_ASSERT_EQUAL_UINT32(TIMER_NONE, timerTimeUntilNext(0));
+  TEST_ASSERT_EQUAL_INT(-1, timerPopExpired(1000));
+}
+
+static void test_out_of_range_ids_are_ignored(void) {
+  timerStart(TIMER_SLOTS, 10, 0);
+  TEST_ASSERT_FALSE(timerActive(TIMER_SLOTS));
+  TEST_ASSERT_EQUAL_UINT32(TIMER_NONE, timerTimeUntilNext(0));
+  timerCancel(TIMER_SLOTS);
+}
+
+// --- Ordering ---
+
+static void test_due_timers_pop_in_deadline_order(void) {
+  timerStart(5, 300, 0);
+  timerStart(1, 100, 0);
+  timerStart(4, 200, 0);
+  timerStart(6, 900, 0);
+  TEST_ASSERT_EQUAL_UINT32(100, timerTimeUntilNext(0));
+  TEST_ASSERT_EQUAL_INT(1, timerPopExpired(500));
+  TEST_ASSERT_EQUAL_INT(4, timerPopExpired(500));
+  TEST_ASSERT_EQUAL_INT(5, timerPopExpired(500));
+  TEST_ASSERT_EQUAL_INT(-1, timerPopExpired(500));
+  TEST_ASSERT_EQUAL_UINT32(400, timerTimeUntilNext(500));
+}
+
+static void test_all_slots_independent(void) {
+  for (uint8_t id = 0; id < TIMER_SLOTS; id++) timerStart(id, 10 * (TIMER_SLOTS - id), 0);
+  for (int expected = TIMER_SLOTS - 1; expected >= 0; expected--) {
+    TEST_ASSERT_EQUAL_INT(expected, timerPopExpired(1000));
+  }
+  TEST_ASSERT_EQUAL_UINT32(TIMER_NONE, timerTimeUntilNext(1000));
+}
+
+// --- millis() wrap ---
+
+static void test_deadline_across_wrap(void) {
+  uint32_t now = UINT32_MAX - 50;
+  timerStart(0, 100, now);
+  TEST_ASSERT_EQUAL_UINT32(100, timerTimeUntilNext(now));
+  TEST_ASSERT_EQUAL_INT(-1, timerPopExpired(now + 99));  // wraps to 48
+  TEST_ASSERT_EQUAL_UINT32(1, timerTimeUntilNext(now + 99));
+  TEST_ASSERT_EQUAL_INT(0, timerPopExpired(now + 100));
+}
+
+static void test_wrap_keeps_deadline_order(void) {
+  uint32_t now = UINT32_MAX - 10;
+  timerStart(2, 40, now);  // lands after the wrap
+  timerStart(3, 5, now);   // lands before it
+  TEST_ASSERT_EQUAL_UINT32(5, timerTimeUntilNext(now));
+  TEST_ASSERT_EQUAL_INT(3, timerPopExpired(now + 60));
+  TEST_ASSERT_EQUAL_INT(2, timerPopExpired(now + 60));
+}
+
+// --- Loop simulation ---
+
+// Drive the scheduler the way loop() does: sleep until the next deadline,
+// pop everything due, re-arm the periodic tick. Over ten virtual seconds
+// the 1000 ms tick must fire ten times and never late.
+static void test_virtual_clock_periodic_tick(void) {
+  const uint8_t tick = 2, oneShot = 0;
+  uint32_t now = 0;
+  int ticks = 0, oneShots = 0;
+  timerStart(tick, 1000, now);
+  timerStart(oneShot, 2500, now);
+  while (now < 10000) {
+    uint32_t wait = timerTimeUntilNext(now);
+    TEST_ASSERT_TRUE(wait != TIMER_NONE);
+    now += wait;
+    int id;
+    while ((id = timerPopExpired(now)) >= 0) {
+      if (id == tick) {
+        ticks++;
+        TEST_ASSERT_EQUAL_UINT32(0, now % 1000);
+        timerStart(tick, 1000, now);
+      } else if (id == oneShot) {
+        oneShots++;
+        TEST_ASSERT_EQUAL_UINT32(2500, now);
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_INT(10, ticks);
+  TEST_ASSERT_EQUAL_INT(1, oneShots);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_idle_scheduler_has_no_deadline);
+  RUN_TEST(test_timer_fires_exactly_at_deadline);
+  RUN_TEST(test_overdue_timer_reports_zero_wait);
+  RUN_TEST(test_rearm_replaces_deadline);
+  RUN_TEST(test_cancel_disarms);
+  RUN_TEST(test_out_of_range_ids_are_ignored);
+  RUN_TEST(test_due_timers_pop_in_deadline_order);
+  RUN_TEST(test_all_slots_independent);
+  RUN_TEST(test_deadline_across_wrap);
+  RUN_TEST(test_wrap_keeps_deadline_order);
+  RUN_TEST(test_virtual_clock_periodic_tick);
+  return UNITY_END();
+}
@@ -0,0 +1,247 @@
+// Frame encode/decode: round trips, rejections, a mutation fuzz pass over a
+// seed corpus and a timing benchmark. pio test -e native -f test_game_protocol
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../src/game_protocol.cpp"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --- Seed corpus ---
+// One valid frame per opcode, with every field at a distinct value so a
+// shifted or swapped byte shows up in the round trip.
+static const uint8_t corpus[][GAME_FRAME_SIZE] = {
+  { 2, OP_DODGER_CHOICE, 1, 1, 0x00, 0x01, 0x00, 0x10, 0x20, 0x30, 0x40, 0x50, 0x00, 0x60, 0x00 },
+  { 2, OP_SHOT,          5, 3, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF },
+  { 2, OP_SYNC_REQUEST,  0, 0, 0x00, 0x34, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+  { 2, OP_SNAPSHOT,      3, 2, SNAP_SHOT_FIRED | SNAP_RESULT_SAFE, 0x02, 0x00, 0x78, 0x56, 0x34, 0x12, 0x00, 0x00, 0x00, 0x00 },
+  { 2, OP_SNAPSHOT,      5, 0, SNAP_GAME_OVER, 0x03, 0x00, 0x01, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00 },
+  { 2, OP_PING,          0, 0, 0x00, 0x10, 0x00, 0xEF, 0xBE, 0xAD, 0xDE, 0x00, 0x00, 0x2A, 0x00 },
+  { 2, OP_PONG,          0, 0, 0x00, 0x10, 0x00, 0x0D, 0xF0, 0xAD, 0x0B, 0xE8, 0x03, 0x07, 0x00 },
+  { 2, OP_BENCH_PING,    0, 0, 0x00, 0x00, 0x80, 0x01, 0x02, 0x03, 0x04, 0x00, 0x00, 0x00, 0x00 },
+  { 2, OP_BENCH_PONG,    0, 0, 0x00, 0x00, 0x80, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x06, 0x00 },
+  { 2, OP_BENCH_FLOOD,   0, 0, 0x00, 0xF4, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+  { 2, OP_BENCH_DATA,    0, 0, 0x00, 0xF3, 0x01, 0x11, 0x22, 0x33, 0x44, 0x00, 0x00, 0x00, 0x00 },
+};
+static const size_t corpusSize = sizeof(corpus) / sizeof(corpus[0]);
+
+static GameFrame frameFromView(const GameFrameView& view) {
+  GameFrame frame = {};
+  frame.opcode = view.opcode();
+  frame.round = view.round();
+  frame.choice = view.choice();
+  frame.flags = view.flags();
+  frame.seq = view.seq();
+  frame.sentUs = view.sentUs();
+  frame.inputUs = view.inputUs();
+  frame.encodeUs = view.encodeUs();
+  return frame;
+}
+
+// --- Round trips ---
+
+static void test_encode_decode_round_trip(void) {
+  GameFrame frame = {};
+  frame.opcode = OP_SHOT;
+  frame.round = 4;
+  frame.choice = 2;
+  frame.flags = 0x5A;
+  frame.seq = 0xBEEF;
+  frame.sentUs = 0x89ABCDEF;
+  frame.inputUs = 0x1234;
+  frame.encodeUs = 0xFEDC;
+  uint8_t buf[GAME_FRAME_SIZE];
+  TEST_ASSERT_EQUAL_size_t(GAME_FRAME_SIZE, gameFrameEncode(frame, buf, sizeof(buf)));
+
+  GameFrameView view;
+  TEST_ASSERT_EQUAL_INT(FRAME_OK, gameFrameDecode(buf, sizeof(buf), &view));
+  TEST_ASSERT_TRUE(view.bytes == buf);
+  TEST_ASSERT_EQUAL_UINT8(OP_SHOT, view.opcode());
+  TEST_ASSERT_EQUAL_UINT8(4, view.round());
+  TEST_ASSERT_EQUAL_UINT8(2, view.choice());
+  TEST_ASSERT_EQUAL_UINT8(0x5A, view.flags());
+  TEST_ASSERT_EQUAL_UINT16(0xBEEF, view.seq());
+  TEST_ASSERT_EQUAL_UINT32(0x89ABCDEF, view.sentUs());
+  TEST_ASSERT_EQUAL_UINT16(0x1234, view.inputUs());
+  TEST_ASSERT_EQUAL_UINT16(0xFEDC, view.encodeUs());
+}
+
+static void test_corpus_round_trips_byte_exact(void) {
+  for (size_t i = 0; i < corpusSize; i++) {
+    GameFrameView view;
+    TEST_ASSERT_EQUAL_INT(FRAME_OK, gameFrameDecode(corpus[i], GAME_FRAME_SIZE, &view));
+    uint8_t buf[GAME_FRAME_SIZE];
+    TEST_ASSERT_EQUAL_size_t(GAME_FRAME_SIZE, gameFrameEncode(frameFromView(view), buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_MEMORY(corpus[i], buf, GAME_FRAME_SIZE);
+  }
+}
+
+static void test_stamp_send_only_touches_timing(void) {
+  uint8_t buf[GAME_FRAME_SIZE];
+  memcpy(buf, corpus[0], sizeof(buf));
+  gameFrameStampSend(buf, 0x01020304, 0x0506);
+  GameFrameView view;
+  TEST_ASSERT_EQUAL_INT(FRAME_OK, gameFrameDecode(buf, sizeof(buf), &view));
+  TEST_ASSERT_EQUAL_UINT32(0x01020304, view.sentUs());
+  TEST_ASSERT_EQUAL_UINT16(0x0506, view.encodeUs());
+  TEST_ASSERT_EQUAL_MEMORY(corpus[0], buf, 7);
+  TEST_ASSERT_EQUAL_MEMORY(corpus[0] + 11, buf + 11, 2);
+}
+
+static void test_clamp_us_saturates(void) {
+  TEST_ASSERT_EQUAL_UINT16(0, gameFrameClampUs(0));
+  TEST_ASSERT_EQUAL_UINT16(0xFFFF, gameFrameClampUs(0xFFFF));
+  TEST_ASSERT_EQUAL_UINT16(0xFFFF, gameFrameClampUs(0x10000));
+}
+
+// --- Rejections ---
+
+static void test_encode_rejects_small_buffer(void) {
+  GameFrame frame = {};
+  uint8_t buf[GAME_FRAME_SIZE - 1];
+  TEST_ASSERT_EQUAL_size_t(0, gameFrameEncode(frame, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_size_t(0, gameFrameEncode(frame, nullptr, GAME_FRAME_SIZE));
+}
+
+static void test_decode_rejections(void) {
+  GameFrameView view = { nullptr };
+  uint8_t buf[GAME_FRAME_SIZE];
+  memcpy(buf, corpus[0], sizeof(buf));
+  TEST_ASSERT_EQUAL_INT(FRAME_TOO_SHORT, gameFrameDecode(nullptr, GAME_FRAME_SIZE, &view));
+  TEST_ASSERT_EQUAL_INT(FRAME_TOO_SHORT, gameFrameDecode(buf, GAME_FRAME_SIZE - 1, &view));
+
+  buf[0] = 1;
+  TEST_ASSERT_EQUAL_INT(FRAME_BAD_VERSION, gameFrameDecode(buf, sizeof(buf), &view));
+  buf[0] = GAME_PROTOCOL_VERSION;
+
+  buf[1] = 0x7F;
+  TEST_ASSERT_EQUAL_INT(FRAME_BAD_OPCODE, gameFrameDecode(buf, sizeof(buf), &view));
+  buf[1] = OP_DODGER_CHOICE;
+
+  buf[3] = 0;
+  TEST_ASSERT_EQUAL_INT(FRAME_BAD_CHOICE, gameFrameDecode(buf, sizeof(buf), &view));
+  buf[3] = NUM_BARRELS + 1;
+  TEST_ASSERT_EQUAL_INT(FRAME_BAD_CHOICE, gameFrameDecode(buf, sizeof(buf), &view));
+  TEST_ASSERT_NULL(view.bytes);  // untouched on failure
+}
+
+static void test_padded_bench_frame_accepted(void) {
+  uint8_t buf[64] = {};
+  memcpy(buf, corpus[10], GAME_FRAME_SIZE);
+  GameFrameView view;
+  TEST_ASSERT_EQUAL_INT(FRAME_OK, gameFrameDecode(buf, sizeof(buf), &view));
+  TEST_ASSERT_EQUAL_UINT16(0x01F3, view.seq());
+}
+
+// --- Fuzz ---
+// Mutate corpus frames (bit flips, byte overwrites, truncation) with a fixed
+// seed. Whatever the decoder says, it must not read past len, and anything
+// it accepts must satisfy the field rules and re-encode to the same bytes.
+
+static uint32_t fuzzState = 0x2545F491;
+
+static uint32_t fuzzNext() {
+  fuzzState ^= fuzzState << 13;
+  fuzzState ^= fuzzState >> 17;
+  fuzzState ^= fuzzState << 5;
+  return fuzzState;
+}
+
+static void test_fuzz_mutated_corpus(void) {
+  const int iterations = 200000;
+  int accepted = 0;
+  int results[FRAME_BAD_CHOICE + 1] = {};
+  for (int i = 0; i < iterations; i++) {
+    uint8_t frame[GAME_FRAME_SIZE];
+    memcpy(frame, corpus[fuzzNext() % corpusSize], sizeof(frame));
+    int mutations = 1 + fuzzNext() % 4;
+    for (int m = 0; m < mutations; m++) {
+      uint32_t r = fuzzNext();
+      if (r & 1) frame[(r >> 1) % GAME_FRAME_SIZE] ^= (uint8_t)(1 << ((r >> 8) % 8));
+      else frame[(r >> 1) % GAME_FRAME_SIZE] = (uint8_t)(r >> 16);
+    }
+    size_t len = (fuzzNext() % 8 == 0) ? fuzzNext() % GAME_FRAME_SIZE : GAME_FRAME_SIZE;
+
+    // Copy to an exact-size heap block so an over-read trips ASan builds.
+    uint8_t* data = new uint8_t[len ? len : 1];
+    memcpy(data, frame, len);
+    GameFrameView view = { nullptr };
+    FrameDecodeResult result = gameFrameDecode(data, len, &view);
+    TEST_ASSERT_TRUE(result >= FRAME_OK && result <= FRAME_BAD_CHOICE);
+    TEST_ASSERT_TRUE(strcmp(frameDecodeResultName(result), "unknown") != 0);
+    results[result]++;
+    if (result == FRAME_OK) {
+      accepted++;
+      TEST_ASSERT_EQUAL_size_t(GAME_FRAME_SIZE, len);
+      TEST_ASSERT_EQUAL_UINT8(GAME_PROTOCOL_VERSION, view.bytes[0]);
+      TEST_ASSERT_TRUE(view.choice() <= NUM_BARRELS);
+      if (view.opcode() == OP_DODGER_CHOICE || view.opcode() == OP_SHOT) TEST_ASSERT_TRUE(view.choice() >= 1);
+      uint8_t again[GAME_FRAME_SIZE];
+      gameFrameEncode(frameFromView(view), again, sizeof(again));
+      TEST_ASSERT_EQUAL_MEMORY(data, again, GAME_FRAME_SIZE);
+    } else {
+      TEST_ASSERT_NULL(view.bytes);
+    }
+    delete[] data;
+  }
+  // Every outcome is reached, so the mutator is not stuck on one path.
+  for (int r = FRAME_OK; r <= FRAME_BAD_CHOICE; r++) TEST_ASSERT_GREATER_THAN(0, results[r]);
+  char line[96];
+  snprintf(line, sizeof(line), "fuzz: %d iterations, %d accepted", iterations, accepted);
+  TEST_MESSAGE(line);
+}
+
+// --- Benchmark ---
+// Times encode and decode of a shot frame. The bound is loose (it has to
+// pass on a loaded CI host); the printed figures are the point.
+
+static volatile uint32_t benchSink;
+
+static void test_benchmark_encode_decode(void) {
+  const int iterations = 1000000;
+  GameFrame frame = {};
+  frame.opcode = OP_SHOT;
+  frame.round = 1;
+  frame.choice = 2;
+  uint8_t buf[GAME_FRAME_SIZE];
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    frame.seq = (uint16_t)i;
+    frame.sentUs = (uint32_t)i;
+    benchSink = benchSink + gameFrameEncode(frame, buf, sizeof(buf)) + buf[5];
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    buf[5] = (uint8_t)i;
+    GameFrameView view;
+    if (gameFrameDecode(buf, sizeof(buf), &view) == FRAME_OK) benchSink = benchSink + view.seq() + view.sentUs();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double encodeNs = std::chrono::duration<double, std::nano>(mid - start).count() / iterations;
+  double decodeNs = std::chrono::duration<double, std::nano>(end - mid).count() / iterations;
+  char line[96];
+  snprintf(line, sizeof(line), "bench: encode %.1f ns/frame, decode %.1f ns/frame", encodeNs, decodeNs);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_TRUE(encodeNs < 1000.0);
+  TEST_ASSERT_TRUE(decodeNs < 1000.0);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_encode_decode_round_trip);
+  RUN_TEST(test_corpus_round_trips_byte_exact);
+  RUN_TEST(test_stamp_send_only_touches_timing);
+  RUN_TEST(test_clamp_us_saturates);
+  RUN_TEST(test_encode_rejects_small_buffer);
+  RUN_TEST(test_decode_rejections);
+  RUN_TEST(test_padded_bench_frame_accepted);
+  RUN_TEST(test_fuzz_mutated_corpus);
+  RUN_TEST(test_benchmark_encode_decode);
+  return UNITY_END();
+}
@@ -0,0 +1,125 @@
+// SpscRing across two real threads: pio test -e native -f test_spsc_ring
+#include <unity.h>
+
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+
+#include "spsc_ring.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --- Single thread ---
+
+static void test_push_pop_fifo(void) {
+  SpscRing<uint32_t, 4> ring;
+  uint32_t value = 0;
+  TEST_ASSERT_FALSE(ring.pop(&value));
+  for (uint32_t i = 1; i <= 4; i++) TEST_ASSERT_TRUE(ring.push(i));
+  TEST_ASSERT_EQUAL_size_t(4, ring.size());
+  TEST_ASSERT_FALSE(ring.push(5));
+  TEST_ASSERT_EQUAL_UINT32(1, ring.overflowCount());
+  for (uint32_t i = 1; i <= 4; i++) {
+    TEST_ASSERT_TRUE(ring.pop(&value));
+    TEST_ASSERT_EQUAL_UINT32(i, value);
+  }
+  TEST_ASSERT_FALSE(ring.pop(&value));
+  TEST_ASSERT_EQUAL_size_t(0, ring.size());
+}
+
+static void test_indices_wrap_many_times(void) {
+  SpscRing<uint16_t, 2> ring;
+  uint16_t value = 0;
+  for (uint32_t i = 0; i < 100000; i++) {
+    TEST_ASSERT_TRUE(ring.push((uint16_t)i));
+    TEST_ASSERT_TRUE(ring.pop(&value));
+    TEST_ASSERT_EQUAL_UINT16((uint16_t)i, value);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, ring.overflowCount());
+}
+
+// --- Two threads ---
+// The item is several words wide with a check word derived from the
+// sequence number, so a slot read before the producer's writes are visible
+// (a missing release/acquire) shows up as a torn item, not just a bad count.
+
+struct StressItem {
+  uint32_t seq;
+  uint32_t payload[6];
+  uint32_t check;
+};
+
+static uint32_t stressCheck(const StressItem& item) {
+  uint32_t c = item.seq * 2654435761u;
+  for (uint32_t word : item.payload) c ^= word + 0x9E3779B9u + (c << 6) + (c >> 2);
+  return c;
+}
+
+template <size_t Capacity>
+static void runStress(uint32_t count) {
+  SpscRing<StressItem, Capacity> ring;
+  std::atomic<uint32_t> refused{0};
+
+  std::thread producer([&] {
+    uint32_t localRefused = 0;
+    for (uint32_t seq = 0; seq < count;) {
+      StressItem item;
+      item.seq = seq;
+      for (uint32_t w = 0; w < 6; w++) item.payload[w] = seq * 7 + w;
+      item.check = stressCheck(item);
+      if (ring.push(item)) {
+        seq++;
+      } else {
+        localRefused++;  // full: retry, as a BLE callback would drop and count
+        std::this_thread::yield();
+      }
+    }
+    refused.store(localRefused);
+  });
+
+  uint32_t expected = 0, torn = 0, outOfOrder = 0;
+  size_t maxSize = 0;
+  while (expected < count) {
+    size_t size = ring.size();
+    if (size > maxSize) maxSize = size;
+    StressItem item;
+    if (!ring.pop(&item)) {
+      std::this_thread::yield();  // single-core hosts: let the producer run
+      continue;
+    }
+    if (item.check != stressCheck(item)) torn++;
+    if (item.seq != expected) outOfOrder++;
+    expected = item.seq + 1;
+  }
+  producer.join();
+
+  StressItem leftover;
+  TEST_ASSERT_FALSE(ring.pop(&leftover));
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+  TEST_ASSERT_LESS_OR_EQUAL(Capacity, maxSize);
+  TEST_ASSERT_EQUAL_UINT32(refused.load(), ring.overflowCount());
+
+  char line[96];
+  snprintf(line, sizeof(line), "capacity %u: %u items, %u refused pushes",
+           (unsigned)Capacity, (unsigned)count, (unsigned)refused.load());
+  TEST_MESSAGE(line);
+}
+
+static void test_two_thread_stress_small_ring(void) {
+  runStress<2>(200000);
+}
+
+static void test_two_thread_stress_event_ring(void) {
+  runStress<16>(1000000);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_push_pop_fifo);
+  RUN_TEST(test_indices_wrap_many_times);
+  RUN_TEST(test_two_thread_stress_small_ring);
+  RUN_TEST(test_two_thread_stress_event_ring);
+  return UNITY_END();
+}
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""Turn the serial output of a LOG_TOKENIZED build back into text.
+
+    tools/detokenize.py --db log_tokens.csv capture.bin
+    tools/detokenize.py --db log_tokens.csv --port /dev/ttyUSB0   (needs pyserial)
+    tools/detokenize.py --src src include -- capture.bin          (hash the sources)
+
+Bytes outside log frames (boot ROM messages, panics) are passed through
+unchanged. See include/game_log.h for the frame layout.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from log_tokens import build_database, load_database  # noqa: E402
+
+FRAME_SYNC = 0xA5
+LEVEL_TAGS = '-EWID'
+CONV_RE = re.compile(r'%([-+ #0-9]*)(?:l|h|z)*([diuxXcs%])')
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def varint(self):
+        value = shift = 0
+        while True:
+            b = self.data[self.pos]
+            self.pos += 1
+            value |= (b & 0x7F) << shift
+            if b < 0x80:
+                return value
+            shift += 7
+
+    def zigzag(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def bytes(self, n):
+        out = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return out
+
+
+def render(fmt, argc, reader):
+    args_left = [argc]
+
+    def conversion(m):
+        flags, conv = m.group(1), m.group(2)
+        if conv == '%':
+            return '%'
+        if args_left[0] == 0:
+            return m.group(0)
+        args_left[0] -= 1
+        if conv == 's':
+            return ('%' + flags + 's') % reader.bytes(reader.varint()).decode('utf-8', 'replace')
+        v = reader.zigzag()
+        if conv == 'c':
+            return ('%' + flags + 'c') % chr(v & 0xFF)
+        if conv in 'uxX':
+            return ('%' + flags + ('d' if conv == 'u' else conv)) % (v & 0xFFFFFFFF)
+        return ('%' + flags + 'd') % v
+
+    return CONV_RE.sub(conversion, fmt)
+
+
+def decode_payload(payload, tokens):
+    reader = Reader(payload)
+    token = int.from_bytes(reader.bytes(4), 'little')
+    level_argc = reader.bytes(1)[0]
+    level, argc = level_argc >> 4, level_argc & 0x0F
+    ms = reader.varint()
+    tag = LEVEL_TAGS[level] if level < len(LEVEL_TAGS) else '?'
+    fmt = tokens.get(token)
+    if fmt is None:
+        args = [reader.zigzag() for _ in range(argc)]
+        text = '<unknown token %08x> %s' % (token, ' '.join(str(a) for a in args))
+    else:
+        text = render(fmt, argc, reader)
+    return '%7d %s %s' % (ms, tag, text)
+
+
+def detokenize(stream, tokens, out):
+    buf = bytearray()
+    text = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if chunk:
+            buf.extend(chunk)
+        while buf:
+            if buf[0] != FRAME_SYNC:
+                text.append(buf.pop(0))
+                continue
+            if len(buf) < 2 or len(buf) < buf[1] + 3:
+                break  # wait for the rest of the frame
+            length = buf[1]
+            payload = bytes(buf[2:2 + length])
+            check = 0
+            for b in payload:
+                check ^= b
+            try:
+                if check != buf[2 + length]:
+                    raise ValueError('checksum')
+                line = decode_payload(payload, tokens)
+            except (ValueError, IndexError):
+                text.append(buf.pop(0))  # not a frame after all; resync
+                continue
+            del buf[:length + 3]
+            if text:
+                out.write(text.decode('utf-8', 'replace'))
+                text.clear()
+            out.write(line + '\n')
+        if text:
+            out.write(text.decode('utf-8', 'replace'))
+            text.clear()
+        out.flush()
+        if not chunk:
+            return
+
+
+class PortStream:
+    """Blocking reads from a serial port (pyserial returns b'' on timeout)."""
+
+    def __init__(self, port, baud):
+        import serial
+        self.port = serial.Serial(port, baud, timeout=0.1)
+
+    def read(self, n):
+        while True:
+            data = self.port.read(n)
+            if data:
+                return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('input', nargs='?', default='-', help='capture file (default: stdin)')
+    parser.add_argument('--db', help='token CSV from tools/log_tokens.py')
+    parser.add_argument('--src', nargs='+', help='build the token table from these sources instead')
+    parser.add_argument('--port', help='read from a serial port instead of a file')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    if args.db:
+        tokens = load_database(args.db)
+    elif args.src:
+        tokens = build_database(args.src)
+    else:
+        parser.error('give --db or --src')
+
+    if args.port:
+        stream = PortStream(args.port, args.baud)
+    elif args.input == '-':
+        stream = sys.stdin.buffer
+    else:
+        stream = open(args.input, 'rb')
+    try:
+        detokenize(stream, tokens, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""Build the token database for LOG_TOKENIZED firmware builds.
+
+Scans the firmware sources for LOG_E/LOG_W/LOG_I/LOG_D and LOG_FMT calls,
+hashes each format literal with the same 32-bit FNV-1a as logFnv1a() in
+include/game_log.h, and writes a CSV of token,format rows.
+
+    tools/log_tokens.py -o log_tokens.csv src include
+
+Exits with status 1 if two different formats share a token.
+"""
+
+import argparse
+import csv
+import os
+import re
+import sys
+
+CALL_RE = re.compile(r'\bLOG_(?:[EWID]|FMT)\s*\(\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+LITERAL_RE = re.compile(r'"((?:[^"\\]|\\.)*)"')
+ESCAPES = {'n': '\n', 't': '\t', 'r': '\r', '0': '\0', '\\': '\\', '"': '"', "'": "'"}
+SOURCE_EXTS = ('.c', '.cpp', '.h', '.hpp')
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def unescape(literal):
+    out = []
+    i = 0
+    while i < len(literal):
+        c = literal[i]
+        if c == '\\' and i + 1 < len(literal):
+            n = literal[i + 1]
+            if n == 'x':
+                m = re.match(r'[0-9a-fA-F]+', literal[i + 2:])
+                out.append(chr(int(m.group(0), 16)))
+                i += 2 + len(m.group(0))
+                continue
+            out.append(ESCAPES.get(n, n))
+            i += 2
+            continue
+        out.append(c)
+        i += 1
+    return ''.join(out)
+
+
+def formats_in(text):
+    # Drop comments so examples in doc comments are not picked up.
+    text = re.sub(r'//[^\n]*|/\*.*?\*/', '', text, flags=re.S)
+    for call in CALL_RE.finditer(text):
+        yield ''.join(unescape(lit) for lit in LITERAL_RE.findall(call.group(1)))
+
+
+def source_files(paths):
+    for path in paths:
+        if os.path.isfile(path):
+            yield path
+            continue
+        for root, _, files in os.walk(path):
+            for name in sorted(files):
+                if name.endswith(SOURCE_EXTS):
+                    yield os.path.join(root, name)
+
+
+def build_database(paths):
+    """Returns {token: format}; raises ValueError on a collision."""
+    tokens = {}
+    for path in source_files(paths):
+        with open(path, encoding='utf-8', errors='replace') as f:
+            for fmt in formats_in(f.read()):
+                token = fnv1a(fmt.encode('utf-8'))
+                if token in tokens and tokens[token] != fmt:
+                    raise ValueError('token 0x%08x collides: %r vs %r' % (token, tokens[token], fmt))
+                tokens[token] = fmt
+    return tokens
+
+
+def load_database(path):
+    with open(path, newline='', encoding='utf-8') as f:
+        return {int(row[0], 16): row[1] for row in csv.reader(f) if row and not row[0].startswith('#')}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('paths', nargs='*', default=['src', 'include'],
+                        help='source files or directories (default: src include)')
+    parser.add_argument('-o', '--output', default='log_tokens.csv', help='CSV to write')
+    args = parser.parse_args()
+
+    try:
+        tokens = build_database(args.paths)
+    except ValueError as e:
+        print('log_tokens: %s' % e, file=sys.stderr)
+        return 1
+    with open(args.output, 'w', newline='', encoding='utf-8') as f:
+        writer = csv.writer(f)
+        writer.writerow(['# token', 'format'])
+        for token, fmt in sorted(tokens.items()):
+            writer.writerow(['%08x' % token, fmt])
+    print('log_tokens: %d formats written to %s' % (len(tokens), args.output))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Convert a "trace" console dump into Chrome trace JSON.
+
+Capture the serial output while running the "trace" command (any other
+lines are ignored), then:
+
+    tools/trace2json.py capture.txt -o match.json
+
+Open the result in chrome://tracing or https://ui.perfetto.dev. If the
+capture holds several dumps, each becomes its own process row.
+"""
+
+import argparse
+import base64
+import json
+import struct
+import sys
+
+EVENT = struct.Struct('<IBBHi')  # matches TraceEvent in include/trace.h
+
+
+def parse_dumps(lines):
+    dump = None
+    for line in lines:
+        line = line.strip()
+        if not line.startswith('#TRACE '):
+            continue
+        parts = line.split(' ', 3)
+        kind = parts[1]
+        if kind == 'begin':
+            dump = {'tracks': {}, 'names': {}, 'data': bytearray(), 'overwritten': int(parts[3].split()[-1])}
+        elif dump is None:
+            continue
+        elif kind == 'track':
+            dump['tracks'][int(parts[2])] = parts[3]
+        elif kind == 'name':
+            dump['names'][int(parts[2])] = parts[3]
+        elif kind == 'data':
+            dump['data'].extend(base64.b64decode(parts[2]))
+        elif kind == 'end':
+            yield dump
+            dump = None
+
+
+def to_chrome(dump, pid):
+    out = [{'ph': 'M', 'pid': pid, 'name': 'process_name',
+            'args': {'name': 'dump %d (%d older events overwritten)' % (pid, dump['overwritten'])}}]
+    for tid, name in dump['tracks'].items():
+        out.append({'ph': 'M', 'pid': pid, 'tid': tid, 'name': 'thread_name', 'args': {'name': name}})
+        out.append({'ph': 'M', 'pid': pid, 'tid': tid, 'name': 'thread_sort_index', 'args': {'sort_index': tid}})
+
+    # micros() wraps every ~71 minutes; unwrap against the previous event.
+    base = None
+    last = 0
+    wraps = 0
+    open_spans = {}
+    for offset in range(0, len(dump['data']) - EVENT.size + 1, EVENT.size):
+        us, ph, tid, name_id, arg = EVENT.unpack_from(dump['data'], offset)
+        if base is not None and us < last and last - us > 0x80000000:
+            wraps += 1
+        last = us
+        ts = us + (wraps << 32)
+        if base is None:
+            base = ts
+        ts -= base
+        ph = chr(ph)
+        name = dump['names'].get(name_id, '?')
+        stack = open_spans.setdefault(tid, [])
+        if ph == 'B':
+            stack.append(name)
+            out.append({'ph': 'B', 'pid': pid, 'tid': tid, 'ts': ts, 'name': name})
+        elif ph == 'E':
+            if name not in stack:
+                continue  # began before the window (or while a dump paused recording)
+            while stack:
+                top = stack.pop()
+                out.append({'ph': 'E', 'pid': pid, 'tid': tid, 'ts': ts, 'name': top})
+                if top == name:
+                    break
+        elif ph == 'i':
+            out.append({'ph': 'i', 'pid': pid, 'tid': tid, 'ts': ts, 'name': name, 's': 't',
+                        'args': {'arg': arg}})
+        elif ph == 'C':
+            out.append({'ph': 'C', 'pid': pid, 'ts': ts, 'name': name, 'args': {name: arg}})
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('input', nargs='?', default='-', help='serial capture (default: stdin)')
+    parser.add_argument('-o', '--output', default='-', help='JSON file (default: stdout)')
+    args = parser.parse_args()
+
+    src = sys.stdin if args.input == '-' else open(args.input, encoding='utf-8', errors='replace')
+    events = []
+    dumps = 0
+    for dump in parse_dumps(src):
+        dumps += 1
+        events.extend(to_chrome(dump, dumps))
+    if dumps == 0:
+        print('trace2json: no "#TRACE begin ... #TRACE end" dump found', file=sys.stderr)
+        return 1
+
+    text = json.dumps({'traceEvents': events, 'displayTimeUnit': 'ms'})
+    if args.output == '-':
+        print(text)
+    else:
+        with open(args.output, 'w', encoding='utf-8') as f:
+            f.write(text)
+        print('trace2json: %d dump(s), %d events -> %s' % (dumps, len(events), args.output), file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())